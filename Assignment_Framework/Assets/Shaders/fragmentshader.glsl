@@ -59,6 +59,8 @@ const float shadingDiffuseStrength    = 0.6;
 const float shadingSpecularStrength   = 1.0;
 
 uniform sampler2D modelTexture; // texture of the model being drawn
+uniform sampler2DArray modelTextures; // or the texture array it is a layer of
+uniform float textureLayer = -1.0f; // the layer of modelTextures, -1 to use modelTexture
 uniform samplerCube shadowMap; // the shadow depth cube map
 
 uniform vec3 viewPosition;
@@ -154,8 +156,11 @@ vec3 calculatePointLight(PointLight pPointLight) {
 void main() {
     // get fragment color from the texture and times it by the vertex color
     vec3 color;
-    if(enableTextures)
-        color = texture(modelTexture, vec2(textureCoords.x * texWrapX - float(1*(texWrapX-1)/2), textureCoords.y * texWrapY - float((texWrapY-1)/2))).rgb * material.color;
+    vec2 wrappedCoords = vec2(textureCoords.x * texWrapX - float(1*(texWrapX-1)/2), textureCoords.y * texWrapY - float((texWrapY-1)/2));
+    if(enableTextures && textureLayer >= 0.0f)
+        color = texture(modelTextures, vec3(wrappedCoords, textureLayer)).rgb * material.color;
+    else if(enableTextures)
+        color = texture(modelTexture, wrappedCoords).rgb * material.color;
     else 
         color =  material.color;
 
@@ -1,15 +1,12 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 instancePositionSize; // pixel center and size
+layout (location = 2) in vec3 instanceColor;
 
 out vec3 vertexColor;
 
-uniform vec3 aColor;
-
-uniform mat4 worldMatrix;
-
 void main() {
-	gl_Position = worldMatrix * vec4(aPos, 1.0f);
+	gl_Position = vec4(instancePositionSize.xyz + aPos * instancePositionSize.w, 1.0f);
 
-	vertexColor = aColor;
+	vertexColor = instanceColor;
 }
-
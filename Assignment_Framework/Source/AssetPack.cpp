@@ -0,0 +1,328 @@
+#include "AssetPack.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char ASSET_PACK_MAGIC[8] = "SHCPAK";
+
+unsigned long long hashBytes(const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static std::string normalize(std::string path) {
+    std::replace(path.begin(), path.end(), '\\', '/');
+    std::transform(path.begin(), path.end(), path.begin(), ::tolower);
+    return path;
+}
+
+//////////////////////////////////////////////// VIEWS ////////////////////////////////////////////////
+
+AssetView::AssetView(std::vector<unsigned char>&& pLoose) {
+    static const unsigned char empty = 0; // an empty file is still open
+    loose = std::move(pLoose);
+    data = loose.empty() ? &empty : &loose[0];
+    size = loose.size();
+}
+
+void AssetStream::ViewBuffer::setView(const AssetView& view) {
+    char* begin = (char*)view.getData(); // only read, a streambuf wants it writable
+    setg(begin, begin, begin + view.getSize());
+}
+
+AssetStream::AssetStream(AssetView pView) : std::istream(&buffer), view(std::move(pView)) {
+    buffer.setView(view);
+    if (!view.isOpen())
+        setstate(std::ios::failbit);
+}
+
+static bool readLooseFile(std::string path, std::vector<unsigned char>& contents) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == NULL)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    contents.resize(size > 0 ? (size_t)size : 0);
+    bool read = size >= 0 && (contents.empty() || fread(&contents[0], 1, contents.size(), file) == contents.size());
+    fclose(file);
+    return read;
+}
+
+//////////////////////////////////////////////// MAPPING ////////////////////////////////////////////////
+
+static const unsigned char* mapFile(std::string path, size_t& size) {
+    /* maps the whole file read only, NULL if it cannot be opened
+    * the file itself is closed right away, the mapping keeps it open
+    */
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+    LARGE_INTEGER fileSize;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL)
+        return NULL;
+    const unsigned char* data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    size = (size_t)fileSize.QuadPart;
+    return data;
+#else
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return NULL;
+    struct stat status;
+    void* data = MAP_FAILED;
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+        data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (data == MAP_FAILED)
+        return NULL;
+    size = (size_t)status.st_size;
+    madvise(data, size, MADV_WILLNEED); // starts reading it all in while the game is still starting
+    return (const unsigned char*)data;
+#endif
+}
+
+static void unmapFile(const unsigned char* data, size_t size) {
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+#else
+    munmap((void*)data, size);
+#endif
+}
+
+//////////////////////////////////////////////// FILE SYSTEM ////////////////////////////////////////////////
+
+AssetFileSystem::AssetFileSystem() {
+    std::string packPath = ASSET_PACK_PATH;
+    FILE* pack = fopen(packPath.c_str(), "rb");
+    if (pack != NULL) {
+        fclose(pack);
+        mount(packPath, packPath.substr(0, packPath.size() - strlen(".shcpak")));
+    }
+}
+
+bool AssetFileSystem::mount(std::string packPath, std::string pRoot) {
+    unmount();
+    mapping = mapFile(packPath, mappingSize);
+    if (mapping == NULL) {
+        std::cerr << "Could not map the asset pack " << packPath << std::endl;
+        return false;
+    }
+
+    AssetPackHeader header;
+    bool valid = mappingSize >= sizeof(header);
+    if (valid) {
+        memcpy(&header, mapping, sizeof(header));
+        valid = memcmp(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic)) == 0 && header.version == ASSET_PACK_VERSION
+            && header.entryCount >= 0 && header.indexSize <= mappingSize - sizeof(header)
+            && header.indexSize >= header.entryCount * sizeof(AssetPackEntry)
+            && hashBytes(mapping + sizeof(header), (size_t)header.indexSize) == header.indexHash;
+    }
+
+    const AssetPackEntry* index = (const AssetPackEntry*)(mapping + sizeof(header));
+    const char* names = (const char*)(index + (valid ? header.entryCount : 0));
+    size_t namesSize = valid ? (size_t)header.indexSize - header.entryCount * sizeof(AssetPackEntry) : 0;
+    for (int i = 0; valid && i < header.entryCount; i++) {
+        AssetPackEntry entry;
+        memcpy(&entry, &index[i], sizeof(entry));
+        valid = entry.nameOffset <= namesSize && entry.nameLength <= namesSize - entry.nameOffset
+            && entry.offset <= mappingSize && entry.size <= mappingSize - entry.offset;
+        if (valid)
+            entries[std::string(names + entry.nameOffset, entry.nameLength)] = entry;
+    }
+
+    if (!valid) {
+        std::cerr << "Asset pack " << packPath << " is damaged or from another version, make it again with -pack" << std::endl;
+        unmount();
+        return false;
+    }
+    root = normalize(pRoot) + "/";
+    return true;
+}
+
+void AssetFileSystem::unmount() {
+    if (mapping != NULL)
+        unmapFile(mapping, mappingSize);
+    mapping = NULL;
+    mappingSize = 0;
+    entries.clear();
+    root.clear();
+}
+
+std::string AssetFileSystem::getName(std::string path) const {
+    std::string name = normalize(path);
+    if (name.compare(0, root.size(), root) != 0)
+        return ""; // not under the directory that was packed
+    return name.substr(root.size());
+}
+
+AssetView AssetFileSystem::open(std::string path) const {
+    if (mapping != NULL) {
+        std::unordered_map<std::string, AssetPackEntry>::const_iterator found = entries.find(getName(path));
+        if (found != entries.end())
+            return AssetView(mapping + found->second.offset, (size_t)found->second.size);
+    }
+
+    std::vector<unsigned char> contents;
+    if (!readLooseFile(path, contents))
+        return AssetView();
+    return AssetView(std::move(contents));
+}
+
+bool AssetFileSystem::isPacked(std::string path) const {
+    return mapping != NULL && entries.count(getName(path)) != 0;
+}
+
+int AssetFileSystem::verify() const {
+    int damaged = 0;
+    for (std::unordered_map<std::string, AssetPackEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i) {
+        if (hashBytes(mapping + i->second.offset, (size_t)i->second.size) != i->second.hash) {
+            std::cerr << "Asset " << i->first << " is damaged" << std::endl;
+            damaged++;
+        }
+    }
+    return damaged;
+}
+
+//////////////////////////////////////////////// PACKING ////////////////////////////////////////////////
+
+std::vector<std::string> listFiles(std::string directory, bool recursive) {
+    std::vector<std::string> files, directories;
+#if defined(_WIN32)
+    _finddata_t found;
+    intptr_t search = _findfirst((directory + "/*").c_str(), &found);
+    if (search != -1) {
+        do {
+            std::string name = found.name;
+            if (name == "." || name == "..")
+                continue;
+            if (found.attrib & _A_SUBDIR)
+                directories.push_back(directory + "/" + name);
+            else
+                files.push_back(directory + "/" + name);
+        } while (_findnext(search, &found) == 0);
+        _findclose(search);
+    }
+#else
+    if (DIR* dir = opendir(directory.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            struct stat status;
+            if (name == "." || name == ".." || stat((directory + "/" + name).c_str(), &status) != 0)
+                continue;
+            if (S_ISDIR(status.st_mode))
+                directories.push_back(directory + "/" + name);
+            else
+                files.push_back(directory + "/" + name);
+        }
+        closedir(dir);
+    }
+#endif
+
+    if (recursive) {
+        for (size_t i = 0; i < directories.size(); i++) {
+            std::vector<std::string> inside = listFiles(directories[i], true);
+            files.insert(files.end(), inside.begin(), inside.end());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+bool buildAssetPack(std::string directory, std::string packPath) {
+    std::vector<std::string> files = listFiles(directory, true);
+    if (files.empty()) {
+        std::cerr << "Nothing to pack in " << directory << std::endl;
+        return false;
+    }
+
+    // the index first, it is written before the contents it points to
+    std::vector<AssetPackEntry> index;
+    std::string names;
+    std::vector<std::vector<unsigned char> > contents(files.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        if (!readLooseFile(files[i], contents[i])) {
+            std::cerr << "Could not read " << files[i] << std::endl;
+            return false;
+        }
+        std::string name = normalize(files[i].substr(directory.size() + 1));
+        AssetPackEntry entry;
+        entry.size = contents[i].size();
+        entry.hash = hashBytes(contents[i].empty() ? NULL : &contents[i][0], contents[i].size());
+        entry.nameOffset = (unsigned int)names.size();
+        entry.nameLength = (unsigned int)name.size();
+        names += name;
+        index.push_back(entry);
+    }
+
+    AssetPackHeader header;
+    memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic));
+    header.version = ASSET_PACK_VERSION;
+    header.entryCount = (int)index.size();
+    header.indexSize = index.size() * sizeof(AssetPackEntry) + names.size();
+
+    unsigned long long offset = sizeof(header) + header.indexSize;
+    for (size_t i = 0; i < index.size(); i++) {
+        offset = (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+        index[i].offset = offset;
+        offset += index[i].size;
+    }
+
+    std::vector<unsigned char> indexBytes(header.indexSize);
+    memcpy(&indexBytes[0], &index[0], index.size() * sizeof(AssetPackEntry));
+    memcpy(&indexBytes[index.size() * sizeof(AssetPackEntry)], names.data(), names.size());
+    header.indexHash = hashBytes(&indexBytes[0], indexBytes.size());
+
+    FILE* file = fopen(packPath.c_str(), "wb");
+    if (file == NULL) {
+        std::cerr << "Could not write " << packPath << std::endl;
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(&indexBytes[0], 1, indexBytes.size(), file) == indexBytes.size();
+    std::vector<unsigned char> padding(ASSET_PACK_ALIGNMENT, 0);
+    unsigned long long position = sizeof(header) + indexBytes.size();
+    for (size_t i = 0; i < index.size() && written; i++) {
+        size_t paddingSize = (size_t)(index[i].offset - position);
+        written = fwrite(&padding[0], 1, paddingSize, file) == paddingSize
+            && (contents[i].empty() || fwrite(&contents[i][0], 1, contents[i].size(), file) == contents[i].size());
+        position = index[i].offset + index[i].size;
+    }
+    written = fclose(file) == 0 && written;
+    if (!written) {
+        std::cerr << "Could not write " << packPath << std::endl;
+        return false;
+    }
+
+    // read it back the way the game will
+    AssetFileSystem pack;
+    if (!pack.mount(packPath, directory) || pack.verify() != 0)
+        return false;
+    std::cout << "Packed " << files.size() << " files from " << directory << " into " << packPath << ", " << position / 1024 << " KB" << std::endl;
+    return true;
+}
@@ -0,0 +1,115 @@
+#ifndef ASSET_PACK_CLASS_H
+#define ASSET_PACK_CLASS_H
+
+#include <cstddef>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Every asset in one file (-pack), so a cold start opens one file instead of dozens on the cabinets' slow storage.
+* The pack is mapped in memory and an asset read from it is a view of the mapping: nothing is copied, the pages are
+* read when they are first touched (and asked for ahead of time where the OS allows it).
+*
+* The file is an AssetPackHeader, the index (an AssetPackEntry per asset then their names), then the assets, each
+* one starting on its own ASSET_PACK_ALIGNMENT boundary. Names are the paths under Assets in lower case with / (the
+* game was written on Windows, its paths do not always match the files' case). Each entry has the FNV-1a hash of its
+* contents and the header the one of the index, a damaged index is refused when the pack is mounted, -pack checks
+* every asset once it is written.
+*/
+
+struct AssetPackHeader {
+	char magic[8]; // "SHCPAK" and two 0
+	int version;
+	int entryCount;
+	unsigned long long indexSize; // the entries and the names, right after the header
+	unsigned long long indexHash;
+};
+
+struct AssetPackEntry {
+	unsigned long long offset, size; // of the contents, from the start of the file
+	unsigned long long hash;
+	unsigned int nameOffset, nameLength; // in the names after the entries
+};
+
+const int ASSET_PACK_VERSION = 1;
+const size_t ASSET_PACK_ALIGNMENT = 4096; // a page, paging an asset in never reads the end of the one before it
+
+unsigned long long hashBytes(const void* data, size_t size); // 64 bit FNV-1a
+
+class AssetView {
+	/* the contents of an asset: a view of the pack when it is in it, otherwise the loose file read into memory
+	* it can be moved but not copied, the data of a loose file goes with it
+	*/
+public:
+	AssetView() {}
+	AssetView(const unsigned char* pData, size_t pSize) : data(pData), size(pSize) {}
+	AssetView(std::vector<unsigned char>&& pLoose);
+	AssetView(AssetView&& other) = default;
+	AssetView& operator=(AssetView&& other) = default;
+	AssetView(const AssetView&) = delete;
+	AssetView& operator=(const AssetView&) = delete;
+
+	bool isOpen() const { return data != NULL; }
+	const unsigned char* getData() const { return data; }
+	size_t getSize() const { return size; }
+
+private:
+	const unsigned char* data = NULL;
+	size_t size = 0;
+	std::vector<unsigned char> loose; // moving a vector keeps its memory where it is, data stays valid
+};
+
+class AssetStream : public std::istream {
+	/* reads an asset like an ifstream, for the text formats (shapes, shaders, OBJ), straight from its view */
+public:
+	AssetStream(AssetView pView);
+	bool isOpen() const { return view.isOpen(); }
+
+private:
+	struct ViewBuffer : std::streambuf {
+		void setView(const AssetView& view);
+	};
+
+	AssetView view;
+	ViewBuffer buffer;
+};
+
+class AssetFileSystem {
+	/* where the game reads its assets from. open() looks a path up in the mounted pack, then falls back to the loose
+	* file: assets missing from the pack (or with no pack at all) are read from the disk as before.
+	* Reading is thread safe, mounting is not: it happens before anything is read.
+	*/
+public:
+	AssetFileSystem(); // mounts ASSET_PACK_PATH when there is one
+	~AssetFileSystem() { unmount(); }
+
+	bool mount(std::string packPath, std::string pRoot); // pRoot - the directory the pack was made from, as the game names it
+	void unmount();
+	bool isMounted() const { return mapping != NULL; }
+
+	AssetView open(std::string path) const; // not open if there is no such asset
+	bool isPacked(std::string path) const;
+	int verify() const; // the assets whose contents do not match their hash
+
+private:
+	const unsigned char* mapping = NULL;
+	size_t mappingSize = 0;
+	std::string root; // normalized, with a / at the end
+	std::unordered_map<std::string, AssetPackEntry> entries; // by name
+
+	std::string getName(std::string path) const; // the path's name in the pack
+};
+
+const char* const ASSET_PACK_PATH = "../Assets.shcpak";
+
+inline AssetFileSystem& assets() {
+	static AssetFileSystem fileSystem; // the models made at startup read their shapes before main
+	return fileSystem;
+}
+
+std::vector<std::string> listFiles(std::string directory, bool recursive); // sorted, directory/name
+bool buildAssetPack(std::string directory, std::string packPath); // packs every file under directory, then checks the pack
+
+#endif
@@ -1,5 +1,6 @@
 #define GLEW_STATIC 1   // This allows linking with Static Library on Windows, without DLL
 #include <GL/glew.h>    // Include GLEW - OpenGL Extension Wrangler
+#include "GLMetrics.hpp" // counts the draw calls and state changes made below
 
 #include <GLFW/glfw3.h> // GLFW provides a cross-platform interface for creating a graphical context,
 // initializing OpenGL and binding inputs
@@ -19,10 +20,38 @@
 #include "Grouping.hpp"
 #include "SpotLight.hpp"
 #include "DirectionalLight.hpp"
+#include "MeshSimplifier.hpp"
+#include "CubeRotation.hpp"
+#include "OrientationSolver.hpp"
+#include "Simulation.hpp"
+#include "InputRecording.hpp"
+#include "Random.hpp"
+#include "Benchmark.hpp"
+#include "GpuTimer.hpp"
+#include "FrameProfiler.hpp"
+#include "Trace.hpp"
+#include "OffscreenContext.hpp"
+#include "RenderTarget.hpp"
+#include "FrameCapture.hpp"
+#include "StreamBuffer.hpp"
+#include "JobSystem.hpp"
+#include "CommandList.hpp"
+#include "FrameState.hpp"
+#include "NullGL.hpp"
+#include "GLTrace.hpp"
+#include "GLTracePlayer.hpp"
+#include "TextureLoader.hpp"
+#include "TextureManager.hpp"
+#include "TextureCooker.hpp"
+#include "AssetPack.hpp"
+#include "ProgramCache.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include <time.h>
+#include <chrono>
+#include <thread>
+#include <algorithm>
 
 using namespace std;
 using namespace glm;
@@ -39,8 +68,6 @@ struct TexturedColoredVertex
 
 void printVec3(vec3 vector3) { cout << vector3.x << ", " << vector3.y << ", " << vector3.z << endl; }
 
-char* readFile(string filePath);
-
 GLuint getCubeModel();
 
 GLuint compileAndLinkShaders(string vertexShaderFilePath, string fragmentShaderFilePath);
@@ -53,22 +80,52 @@ void renderGrid(GLuint shaderProgram);
 
 void executeEvents(GLFWwindow* window, Camera& camera, float dt);
 
+SimulationInput readSimulationInput(GLFWwindow* window);
+
+void handleSimulationEvents(unsigned int events);
+
+void playSound(const char* filePath, bool looped = false);
+
 void initializeModels();
 
-GLuint loadTexture(const char* filename);
+void acquireSceneTextures();
+
+void releaseSceneTextures();
 
-void renderScene(GLuint shaderProgram);
+void linkSceneTextures();
 
-void shapePassedWall();
+vector<cubeInfo> buildWallCubes(string shapeFilePath);
 
-quat generateStartingAngle();
+void loadShapeCubes();
+
+void renderScene(GLuint shaderProgram, bool enableTextures, const LODSettings& lodSettings);
 
 void window_size_callback(GLFWwindow* window, int width, int height);
 
-GLuint setupModelVBO(string path, int& vertexCount);
+GLFWwindow* createWindow(bool visible);
+
+void captureFrame(int frame, bool screenshot, int width, int height);
+
+GLuint setupModelVBO(string path, int& vertexCount, LODChain* lodChain = NULL);
+
+GLuint createMeshVAO(vector<vec3>& vertices, vector<vec3>& normals, vector<vec2>& UVs);
 
 void endGame();
 
+void benchmarkOrientationSolver();
+
+void benchmarkSimulation();
+
+void benchmarkJobSystem();
+
+void replaySimulation();
+
+int playGLTrace(string filePath);
+
+void placeBenchmarkCamera(int frame, int frameCount);
+
+string getHintText();
+
 
 //////////////////////////////////////////////// WINDOW CONSTANTS ////////////////////////////////////////////////
 // dimensions of the window in pixels
@@ -79,11 +136,46 @@ int WINDOW_HEIGHT = 768;
 const int SHADOW_WIDTH = 1024;
 const int SHADOW_HEIGHT = 1024;
 
+//////////////////////////////////////////////// LEVEL OF DETAIL ////////////////////////////////////////////////
+float lodErrorThreshold = 1.0f; // screen space error in pixels a model is allowed to show before a finer LOD is used
+float shadowLODErrorScale = 4.0f; // the shadow cube is low resolution and blurred so it can get away with coarser meshes
+
+//////////////////////////////////////////////// BENCHMARK ////////////////////////////////////////////////
+int benchmarkFrames = 0; // -benchmark N, frames to measure before quitting, 0 to play normally
+int benchmarkWarmupFrames = 10; // measured but left out of the summaries
+string benchmarkOutput = "benchmark"; // -benchout PATH, writes PATH.csv and PATH.json
+string tracePath; // -trace FILE, empty when not tracing
+
+//////////////////////////////////////////////// OFFSCREEN AND CAPTURE ////////////////////////////////////////////////
+int offscreenFrames = 0; // -offscreen N, frames to render without a window before quitting, 0 to use a window
+bool nullBackend = false; // -nullgl, the frames go to a GL that executes nothing (NullGL.hpp), for CPU only benchmarks
+string framePrefix; // -png PREFIX, frames are saved to PREFIX00000.png, PREFIX00001.png... empty to save nothing
+int frameInterval = 1; // -pngevery K, only every K-th frame is saved
+GLuint sceneFramebuffer = 0; // where the scene is drawn, 0 for the window or the render target offscreen
+string videoPath; // -y4m FILE, every frame is recorded to a Y4M video, empty for none
+FrameCapture frameCapture; // reads the frames back without stalling and writes them on its own thread
+
+//////////////////////////////////////////////// GL TRACE ////////////////////////////////////////////////
+string glTracePath; // -gltrace FILE, the GL calls are recorded to FILE (GLTrace.hpp), empty when not recording
+int glTraceFrames = 0; // -gltraceframes N, frames to record after the startup, 0 for all of them
+
+//////////////////////////////////////////////// TEXTURES ////////////////////////////////////////////////
+TextureLoader textureLoader; // decodes the images on the job workers, the render thread uploads them as they are ready
+TextureManager textureManager(textureLoader); // what is not drawn with anymore is evicted past its budget (-texturebudget MB)
+GLuint sceneTextures = 0; // the scene models' textures are layers of this array, 0 while the textures are off (X)
+GLuint skyboxTexture = 0;
+int textureToggleInterval = 0; // -toggletextures K, benchmarks and offscreen runs turn the textures off and on every K frames
+
+//////////////////////////////////////////////// SHADERS ////////////////////////////////////////////////
+ProgramCache programCache; // the programs linked by the last start, loaded as driver binaries instead of compiled again
+
 //////////////////////////////////////////////// OBJECT POSTION CONSTANTS ////////////////////////////////////////////////
 vec3 wallPosOffset = vec3(0.0f, 0.0f, -10.0f);
 vec3 objectStartingPoint = vec3(0.0f, 0.0f, -15.0f);
 vec3 scoreTextPosition = vec3(-0.95f, 0.95f, 0.0f);
 vec3 timeTextPosition = scoreTextPosition + vec3(1.55f, 0.0f, 0.0f);
+vec3 hintTextPosition = vec3(-0.95f, -0.85f, 0.0f);
+vec3 profilerTextPosition = vec3(-0.95f, 0.55f, 0.0f);
 
 //////////////////////////////////////////////// PATHS OF ALL THE OBJECTS ////////////////////////////////////////////////
 vector<string> shapePaths = {
@@ -98,14 +190,29 @@ vector<string> shapePaths = {
     "../Assets/Shapes/SHC/SHC-LVL9.csv",
     "../Assets/Shapes/SHC/SHC-LVL10.csv",
 };
-int currentShape = 0;
+
+//////////////////////////////////////////////// GAME SIMULATION ////////////////////////////////////////////////
+// all of the game logic, the models below only mirror its state for rendering
+GameSimulation simulation = GameSimulation(shapePaths, objectStartingPoint);
+Random effectsRandom; // for the light colors, seeded like the simulation so a replay also looks the same
+InputRecorder inputRecorder; // -record, saves what the simulation is fed
+InputPlayer inputPlayer; // -replay, feeds a recording to the simulation instead of the keyboard
+
+// the simulation always advances by the same step so the game plays the same at any frame rate,
+// the frames in between two ticks are drawn by interpolating the last two states
+const float SIMULATION_STEP = 1.0f / 120.0f;
+const float MAX_FRAME_TIME = 0.25f; // a longer frame (window dragged, breakpoint...) only catches up this much
 
 //////////////////////////////////////////////// GENERATE MODELS ////////////////////////////////////////////////
 Model skyboxModel = Model("../Assets/Shapes/Basic.csv", glm::vec3(0.0f, 0.0f, 0.0f), -100.0f, GL_TRIANGLES);
 
-Model shapeModel = Model(shapePaths[currentShape], objectStartingPoint, 1.0f, GL_TRIANGLES);
+Model shapeModel = Model(shapePaths[simulation.currentShape], objectStartingPoint, 1.0f, GL_TRIANGLES);
+
+Model wallModel = Model(buildWallCubes(shapeModel.getFilePath()), vec3(0.0f), 1.0f, GL_TRIANGLES);
 
-Model wallModel = Model(buildWall(shapeModel.getFilePath()), vec3(0.0f), 1.0f, GL_TRIANGLES);
+// the cubes of every shape in shapePaths and of its wall, made once at the startup so a new shape is only a swap
+vector<vector<cubeInfo>> shapeCubes;
+vector<vector<cubeInfo>> wallCubes;
 
 Model GroundFloor = Model("../Assets/Shapes/Ground.csv", glm::vec3(0.0f, -25.0f, 0.0f), 1.0f, GL_TRIANGLES);
 
@@ -120,6 +227,13 @@ Model pepeModel6 = Model("../Assets/Shapes/Basic.csv", vec3(-20.0f, -22.0f, -5.0
 vector<Model*> pepeModels = { &pepeModel1,&pepeModel2,&pepeModel3,&pepeModel4,&pepeModel5,&pepeModel6 };
 
 
+//////////////////////////////////////////////// COMMAND LISTS ////////////////////////////////////////////////
+// models drawn by renderScene, each is recorded into its own list on the job workers
+vector<Model*> sceneModels = { &pepeModel1,&pepeModel2,&pepeModel3,&pepeModel4,&pepeModel5,&pepeModel6, &wallModel, &shapeModel, &GroundFloor };
+vector<CommandList> modelCommandLists(sceneModels.size());
+CommandList sceneCommands; // all the model lists merged and sorted, what is actually drawn
+
+
 //////////////////////////////////////////////// LIGHTS ////////////////////////////////////////////////
 vec3 pepeLightColor = vec3((float)255 / 255, (float)132 / 255, (float)0 / 255);
 PointLight pepeLight1 = PointLight(pepeModels[0]->POS + vec3(0.0f, 10.0f, 0.0f), 150.0f, 1.0, 0.045, 0.0075, pepeLightColor, SHADOW_HEIGHT);
@@ -138,28 +252,29 @@ Spotlight spotLight1 = Spotlight(shapeModel.POS + vec3(0.0f, 0.0f, -5.0f), vec3(
 
 //////////////////////////////////////////////// CAMERA ////////////////////////////////////////////////
 Camera camera(WINDOW_WIDTH, WINDOW_HEIGHT, glm::vec3(0.0f, 10.0f, 5.0f), 90.0f);
-vec3 cameraPositionBias = vec3(0.0f); // so we can give a bias to the camera around the shape
 
 
 //////////////////////////////////////////////// SOUND ENGINE ////////////////////////////////////////////////
 irrklang::ISoundEngine* soundEngine = irrklang::createIrrKlangDevice();
 
 
+//////////////////////////////////////////////// FRAME STATE ////////////////////////////////////////////////
+// the main thread changes these, the render thread only sees them through the FrameState of each frame
+vec3 mainLightColor = mainLight.color;
+vec3 pepeLightsColor = pepeLightColor;
+quat pepeRotations[PEPE_COUNT]; // set once the models are initialized
+int scoreFlashes = 0; // the score flashes every time this goes up
+int timeFlashes = 0; // the time left flashes every time this goes up
+int screenshotRequests = 0; // F12, the next frame drawn after this goes up is saved
+
+
 //////////////////////////////////////////////// GAME CONSTANTS ////////////////////////////////////////////////
-int score = 0; // total score
-int highScore = 0;
-float totalTime = 60.0f; // total time to get a high score
-float gameLastStartTime;
-float timeSinceLastPassed; // time since shape last passed wall to get time component of the score
-bool flickerScore = false; // tell program we want to flicker the score
 bool explosionOccuring = false; // tells program we want to have the explosion effect
-bool timeWarningGiven = false; // ensures we only give one time warning
 
 bool enableShadows = true; // rendering flag
 bool enableTextures = true; // rendering flag
-
-bool gameRunning = true; // whether or not we still have time in the game
-bool shapeRotating = false; // flag whether or not the shape is currently rotating
+bool showHint = false; // draw the next move the solver suggests
+bool showProfiler = false; // draw the time of each phase of the frame
 
 // placed in case we want to cycle through light colors in SUPERHYPERCUBE game
 vector<vec3> lightColors = {
@@ -191,43 +306,200 @@ vector<char*> successSounds = {
 };
 
 int main(int argc, char* argv[]) {
-    glfwInit(); //initialize GLFW
-    //determine openGL version to initialize
-#if defined(PLATFORM_OSX)	
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#else
-    // On windows, we set OpenGL version to 2.1, to support more hardware
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
-#endif
+    /* command line options
+    *   -benchsolver - times the orientation solver on every shape and orientation, no window needed
+    *   -benchsim - runs the game logic alone as fast as it can, no window needed
+    *   -benchjobs - times transform updates, frustum culling and command list recording of synthetic scenes of 10k+
+    *                models on 1, 2, 4... threads with the job system, no window needed
+    *   -cook - cooks every image in Assets/Textures with its mipmaps (TextureCooker.hpp), the game loads those instead
+    *   -cookbc - same, compressed to BC1 or BC3
+    *   -pack - packs every file in Assets into Assets.shcpak (AssetPack.hpp), the game reads its assets from there
+    *   -texturebudget MB - GPU memory the textures nothing draws with anymore are kept loaded in (TextureManager.hpp)
+    *   -toggletextures K - with -benchmark N or -offscreen N, turns the textures off and on every K frames like X,
+    *                       with a small -texturebudget the textures are evicted and loaded again each time
+    *   -seed N - seed of the game instead of the current time
+    *   -record FILE - saves the seed and every frame of input to FILE
+    *   -replay FILE - plays FILE back instead of reading the keyboard (then goes back to the keyboard)
+    *   -headless - with -replay, runs the recording without a window and prints how the game ended
+    *   -benchmark N - renders N frames with a fixed time step in a hidden window, then writes the frame times,
+    *                  follows the -replay session if there is one or flies a scripted camera around the stage
+    *   -resolution WxH - size of the window, for benchmarks
+    *   -benchout PATH - where the benchmark results go, PATH.csv and PATH.json (default benchmark)
+    *   -offscreen N - renders N frames with a fixed time step without any window or display (EGL surfaceless, llvmpipe
+    *                  without a GPU) into a -resolution render target, follows -replay or the scripted camera
+    *   -png PREFIX - saves the frames to PREFIX00000.png, PREFIX00001.png...
+    *   -pngevery K - saves only every K-th frame
+    *   -y4m FILE - records every frame to a Y4M video (120 fps with -offscreen or -benchmark, 60 otherwise)
+    *   -trace FILE - records a timeline of the startup and every frame, written to FILE when the program ends or T is pressed
+    *   -nullgl - with -benchmark N or -offscreen N, renders on a null GL backend that checks and counts the calls but
+    *             draws nothing, no window, context or GPU needed, to time the CPU side of the frames alone
+    *   -gltrace FILE - records every GL call of the startup and the frames, with the data they send, to FILE
+    *   -gltraceframes N - with -gltrace, stops recording after N frames
+    *   -playgl FILE - plays a GL trace as fast as it can offscreen instead of running the game and prints the frame
+    *                  times, every frame once or N frames (looping) with -benchmark N, which also writes the results
+    */
+    string recordPath, replayPath, playTracePath;
+    bool headless = false;
+    uint64_t seed = (uint64_t)time(NULL);
+
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option == "-benchsolver") {
+            simulation.loadShapes();
+            benchmarkOrientationSolver();
+            return 0;
+        }
+        else if (option == "-benchsim") {
+            benchmarkSimulation();
+            return 0;
+        }
+        else if (option == "-benchjobs") {
+            benchmarkJobSystem();
+            return 0;
+        }
+        else if (option == "-cook" || option == "-cookbc")
+            return cookTextures("../Assets/Textures", option == "-cookbc") == 0 ? 0 : -1;
+        else if (option == "-pack") {
+            assets().unmount(); // the pack is about to be replaced
+            return buildAssetPack("../Assets", ASSET_PACK_PATH) ? 0 : -1;
+        }
+        else if (option == "-texturebudget" && i + 1 < argc)
+            textureManager.budget = (size_t)std::max(atoi(argv[++i]), 0) * 1024 * 1024;
+        else if (option == "-toggletextures" && i + 1 < argc)
+            textureToggleInterval = std::max(atoi(argv[++i]), 0);
+        else if (option == "-seed" && i + 1 < argc)
+            seed = strtoull(argv[++i], NULL, 10);
+        else if (option == "-record" && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (option == "-replay" && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (option == "-headless")
+            headless = true;
+        else if (option == "-benchmark" && i + 1 < argc)
+            benchmarkFrames = atoi(argv[++i]);
+        else if (option == "-resolution" && i + 1 < argc)
+            sscanf(argv[++i], "%dx%d", &WINDOW_WIDTH, &WINDOW_HEIGHT);
+        else if (option == "-benchout" && i + 1 < argc)
+            benchmarkOutput = argv[++i];
+        else if (option == "-offscreen" && i + 1 < argc)
+            offscreenFrames = atoi(argv[++i]);
+        else if (option == "-png" && i + 1 < argc)
+            framePrefix = argv[++i];
+        else if (option == "-pngevery" && i + 1 < argc)
+            frameInterval = std::max(atoi(argv[++i]), 1);
+        else if (option == "-y4m" && i + 1 < argc)
+            videoPath = argv[++i];
+        else if (option == "-trace" && i + 1 < argc)
+            tracePath = argv[++i];
+        else if (option == "-nullgl")
+            nullBackend = true;
+        else if (option == "-gltrace" && i + 1 < argc)
+            glTracePath = argv[++i];
+        else if (option == "-gltraceframes" && i + 1 < argc)
+            glTraceFrames = atoi(argv[++i]);
+        else if (option == "-playgl" && i + 1 < argc)
+            playTracePath = argv[++i];
+        else
+            cerr << "Unknown option " << option << endl;
+    }
 
-    // Create Window and rendering context using GLFW, resolution is 800x600
-    GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Comp371 - Assignment 1", NULL, NULL);
-    if (window == NULL) {
-        cerr << "Failed to create GLFW window" << endl;
-        glfwTerminate();
+    if (!tracePath.empty()) {
+        setTracing(true);
+        traceSetThreadName("main");
+    }
+
+    if (!playTracePath.empty())
+        return playGLTrace(playTracePath);
+
+    if (!replayPath.empty()) {
+        if (!inputPlayer.open(replayPath))
+            return -1;
+        seed = inputPlayer.getSeed(); // the recording only makes sense with the game it was made in
+    }
+    simulation.setSeed(seed);
+    effectsRandom.setSeed(seed);
+
+    if (headless) {
+        if (!inputPlayer.isOpen()) {
+            cerr << "-headless needs a recording to replay" << endl;
+            return -1;
+        }
+        simulation.loadShapes();
+        replaySimulation();
+        if (isTracing())
+            traceWrite(tracePath);
+        return 0;
+    }
+
+    if (!recordPath.empty() && !inputRecorder.open(recordPath, seed))
+        return -1;
+
+    if (nullBackend && benchmarkFrames == 0 && offscreenFrames == 0) {
+        cerr << "-nullgl needs -benchmark N or -offscreen N" << endl;
         return -1;
     }
-    glfwMakeContextCurrent(window);
+
+
+    traceBegin("startup");
+    // no window at all when rendering offscreen, a hidden one if this platform cannot make a context without one,
+    // not even a context on the null backend
+    bool offscreen = offscreenFrames > 0 || nullBackend;
+    OffscreenContext offscreenContext;
+    GLFWwindow* window = NULL;
+    if (nullBackend)
+        installNullGL();
+    else if (!offscreen || !offscreenContext.create(3, 3)) {
+        if (offscreen)
+            cerr << "Rendering offscreen in a hidden window instead" << endl;
+        window = createWindow(benchmarkFrames == 0 && !offscreen);
+        if (window == NULL)
+            return -1;
+    }
   
-    // Initialize GLEW
+    // Initialize GLEW, the null backend already filled in the entry points
     glewExperimental = true; // Needed for core profile
-    if (glewInit() != GLEW_OK) {
+    GLenum glewStatus = nullBackend ? GLEW_OK : glewInit();
+    // GLEW also wants GLX, which an EGL context does not have, the GL functions are loaded before it gives up
+    if (glewStatus != GLEW_OK && !(offscreenContext.isCreated() && glewStatus == GLEW_ERROR_NO_GLX_DISPLAY)) {
         cerr << "Failed to create GLEW" << endl;
         glfwTerminate();
         return -1;
     }
 
+    // the trace has to see every GL object being made, so it starts before any is
+    if (!glTracePath.empty() && !startGLTrace(glTracePath, glTraceFrames, WINDOW_WIDTH, WINDOW_HEIGHT))
+        return -1;
+
+    // benchmarks measure the frame, not the wait for the display refresh
+    if (window != NULL && benchmarkFrames > 0)
+        glfwSwapInterval(0);
+
+    // offscreen the scene goes to a render target, there is no window to draw into
+    RenderTarget renderTarget;
+    if (offscreen) {
+        if (!renderTarget.create(WINDOW_WIDTH, WINDOW_HEIGHT))
+            return -1;
+        sceneFramebuffer = renderTarget.getFramebuffer();
+    }
+
+    // per frame data (the text pixels) is written into a ring of 3 regions, one frame each
+    frameStreamBuffer().create(1024 * 1024);
+
+    // fixed step runs make exactly one frame per simulation step, a live game is assumed to make 60
+    int videoFrameRate = (benchmarkFrames > 0 || offscreen) ? (int)(1.0f / SIMULATION_STEP + 0.5f) : 60;
+    if (!videoPath.empty() && !frameCapture.openVideo(videoPath, WINDOW_WIDTH, WINDOW_HEIGHT, videoFrameRate))
+        return -1;
+    frameCapture.waitForWriter = offscreen; // nobody is playing, every frame has to make it to the files
+
     // Black background
     glClearColor(0.5f * 0.4f, 0.0f, 0.125f * 0.4f, 1.0f);
 
     //get shader programs
+    programCache.open(PROGRAM_CACHE_PATH);
     GLuint sceneShaderProgram = compileAndLinkShaders("../Assets/Shaders/vertexshader.glsl", "../Assets/Shaders/fragmentshader.glsl");
     GLuint shadowShaderProgram = compileAndLinkShaders("../Assets/Shaders/shadowvertexshader.glsl", "../Assets/Shaders/shadowgeometryshader.glsl", "../Assets/Shaders/shadowfragmentshader.glsl");
     GLuint textShaderProgram = compileAndLinkShaders("../Assets/Shaders/textvertexshader.glsl", "../Assets/Shaders/textfragmentshader.glsl");
+    programCache.save();
 
     // creation of the depth map framebuffer and texture [cube map is used since this is a point light and light is in 360 degrees around it]
     GLuint depthMapFBO, depthCubeMap;
@@ -235,16 +507,18 @@ int main(int argc, char* argv[]) {
 
     // make all the models
     initializeModels();
+    simulation.loadShapes();
+    loadShapeCubes();
+    if (benchmarkFrames > 0 || offscreen) // the textures have to be there from the first frame for it to be the same every run
+        textureLoader.finish();
 
     // make direction of the spotlight
     spotLight1.direction = -normalize(spotLight1.POS - wallModel.POS);
 
-    // seed random number generator
-    srand(time(NULL)); 
-
     //make the textures point to the right position
     glUseProgram(sceneShaderProgram);
     glUniform1i(glGetUniformLocation(sceneShaderProgram, "modelTexture"), 0);
+    glUniform1i(glGetUniformLocation(sceneShaderProgram, "modelTextures"), TEXTURE_ARRAY_UNIT - GL_TEXTURE0);
     glUniform1i(glGetUniformLocation(sceneShaderProgram, "shadowMap"), 1);
 
     // enable openGL effects
@@ -252,49 +526,333 @@ int main(int argc, char* argv[]) {
     glEnable(GL_CULL_FACE);
 
     // play music
-    soundEngine->play2D("../Assets/Sounds/Breakout.mp3", true); // music courtesy of https://learnopengl.com
+    if (soundEngine != NULL) // no sound device on build servers
+        playSound("../Assets/Sounds/Breakout.mp3", true); // music courtesy of https://learnopengl.com
 
-    // For frame time
-    float lastFrameTime = glfwGetTime();
+    // window size callback called when window size changes
+    if (window != NULL && !offscreen) // the render target keeps its size
+        glfwSetWindowSizeCallback(window, window_size_callback);
 
-    // making text renderer objects with flickering effect
-    vec3 scoreBaseColor(1.0f);
-    vec3 scoreFlashColor(1.0f, 0.0f, 0.0f);
-    stringFlickeringEngine scoreTextEngine = stringFlickeringEngine(scoreBaseColor, scoreFlashColor, 0.05f, 10); // creation of score flicker effect
-    stringFlickeringEngine timeTextEngine = stringFlickeringEngine(scoreBaseColor, scoreFlashColor, 0.5f, 20); // creation of text flicker effect
+    // the end screen spins the pepes from where initializeModels left them
+    for (int i = 0; i < PEPE_COUNT; i++)
+        pepeRotations[i] = pepeModels[i]->rotationQuat;
+
+    // For frame time
+    float lastFrameTime = window != NULL ? glfwGetTime() : 0.0f;
 
-    // for scoring the time aspect of the score
-    timeSinceLastPassed = lastFrameTime;
-    gameLastStartTime = lastFrameTime;
-    
     // for explosion
     float curExplosionTime = 0.0f;
     float lengthOfExplosion = 0.35f;
     float lightIntensityFactor = 12.5f;
-    vec3 lightInitialColor = mainLight.color;
+    vec3 lightInitialColor = mainLightColor;
+
+    simulation.startGame();
+    traceEnd("startup");
+
+    // fixed step simulation state
+    float simulationAccumulator = 0.0f;
+    SimulationSnapshot previousSnapshot = simulation.getSnapshot();
+    SimulationSnapshot displaySnapshot = previousSnapshot;
+
+    // benchmark state
+    bool benchmarking = benchmarkFrames > 0;
+    bool scriptedCamera = (benchmarking || offscreen) && !inputPlayer.isOpen();
+    int runFrames = benchmarking ? benchmarkFrames : offscreenFrames; // frames of a scripted run
+    int frameNumber = 0;
+    typedef chrono::high_resolution_clock Clock;
+
+    // phases of the frame measured by the profiler, the simulation runs on the main thread and is timed there
+    FrameProfiler profiler;
+    int simulationScope = profiler.addScope("simulation");
+    int shadowScope = profiler.addScope("shadow");
+    int sceneScope = profiler.addScope("scene");
+    int skyboxScope = profiler.addScope("skybox");
+    int textScope = profiler.addScope("text");
+
+    // fixed step runs have to draw every frame they simulate, a live game only draws the latest state
+    bool lockstep = benchmarking || offscreen;
+    FrameMailbox mailbox(lockstep);
+
+    // the render thread's own copies, the main thread keeps changing the originals
+    Camera renderCamera = camera;
+    int renderedShape = simulation.currentShape;
+    bool texturesAcquired = true; // by initializeModels
+
+    ////////////////////////////////// RENDER THREAD //////////////////////////////////
+    // draws the states the main thread publishes, the GL context belongs to it until it is done
+    auto renderFrames = [&]() {
+        traceSetThreadName("render");
+        if (window != NULL)
+            glfwMakeContextCurrent(window);
+        else if (offscreenContext.isCreated())
+            offscreenContext.makeCurrent();
+
+        // making text renderer objects with flickering effect
+        vec3 scoreBaseColor(1.0f);
+        vec3 scoreFlashColor(1.0f, 0.0f, 0.0f);
+        stringFlickeringEngine scoreTextEngine = stringFlickeringEngine(scoreBaseColor, scoreFlashColor, 0.05f, 10); // creation of score flicker effect
+        stringFlickeringEngine timeTextEngine = stringFlickeringEngine(scoreBaseColor, scoreFlashColor, 0.5f, 20); // creation of text flicker effect
+        int scoreFlashesShown = 0, timeFlashesShown = 0, screenshotsTaken = 0;
+
+        FrameBenchmark benchmark(benchmarkFrames, std::min(benchmarkWarmupFrames, benchmarkFrames / 2));
+        GpuTimer frameGpuTimer;
+        FrameSample frameSample;
+        Clock::time_point frameStart = Clock::now();
+
+        while (const FrameState* state = mailbox.acquire()) {
+            traceBegin("frame");
+            glTraceBeginFrame();
+            glMetricsEndFrame(); // GL calls are counted per frame from here
+            frameStreamBuffer().beginFrame();
+            textureLoader.update();
+            textureManager.update();
+
+            if (benchmarking)
+                frameGpuTimer.begin();
+            profiler.enabled = state->showProfiler || benchmarking;
+            profiler.addCpuTime(simulationScope, state->simulationMilliseconds);
+
+            // bring the models, lights and camera to the state
+            if (state->currentShape != renderedShape) {
+                shapeModel.updateCubes(shapeCubes[state->currentShape]); // change the shape
+                wallModel.updateCubes(wallCubes[state->currentShape]); // update the wall to correspond to the new shape
+                renderedShape = state->currentShape;
+            }
+            if (state->enableTextures != texturesAcquired) {
+                if (state->enableTextures) {
+                    acquireSceneTextures();
+                    if (lockstep)
+                        textureLoader.finish(); // reloaded right away, like at the startup, for the frames to be the same every run
+                }
+                else
+                    releaseSceneTextures();
+                linkSceneTextures();
+                texturesAcquired = state->enableTextures;
+            }
+            shapeModel.POS = state->shapePosition;
+            shapeModel.rotationQuat = state->shapeRotation;
+            for (int i = 0; i < PEPE_COUNT; i++)
+                pepeModels[i]->rotationQuat = state->pepeRotations[i];
+            mainLight.color = state->mainLightColor;
+            for (PointLight *pepeLight : pepeLights)
+                pepeLight->color = state->pepeLightColor;
+            renderCamera.position = state->cameraPosition;
+            renderCamera.orientation = state->cameraOrientation;
+            renderCamera.up = state->cameraUp;
+            renderCamera.FOV = state->cameraFOV;
+
+            ////////////////////////////////// GENERATE SHADOW MAP //////////////////////////////////
+            // render the depth map
+            profiler.begin(shadowScope);
+            glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT); // change view to the size of the shadow texture
+            glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO); // bind the framebuffer
+            glClear(GL_DEPTH_BUFFER_BIT);
+            glUseProgram(shadowShaderProgram); // use proper shaders
+            // update values in shadow shader
+            mainLight.updateShadowShader(shadowShaderProgram);
+            // pick LODs as seen from the light, each cube face covers 90 degrees of the shadow map
+            LODSettings shadowLODs;
+            shadowLODs.viewPosition = mainLight.POS;
+            shadowLODs.pixelsPerUnit = SHADOW_HEIGHT / (2.0f * tan(radians(45.0f)));
+            shadowLODs.errorThreshold = lodErrorThreshold;
+            shadowLODs.errorScale = shadowLODErrorScale;
+            renderScene(shadowShaderProgram, state->enableTextures, shadowLODs); // render to make the texture
+            glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer); // unbind depth map FBO
+            profiler.end(shadowScope);
+
+
+            ////////////////////////////////// RENDER SCENE //////////////////////////////////
+            // render the scene as normal with the shadow mapping using the depth map
+            profiler.begin(sceneScope);
+            glViewport(0, 0, state->width, state->height); // reset viewport tot hte size of the window
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glUseProgram(sceneShaderProgram);
+            // update the values in the scene shader
+            renderCamera.createMatrices(0.01f, 200.0f, sceneShaderProgram, state->width, state->height);
+            LODSettings sceneLODs;
+            sceneLODs.viewPosition = renderCamera.position;
+            sceneLODs.pixelsPerUnit = state->height / (2.0f * tan(radians(renderCamera.FOV) / 2.0f));
+            sceneLODs.errorThreshold = lodErrorThreshold;
+            mainLight.updateSceneShader(sceneShaderProgram, "pointlight1", state->enableShadows);
+            spotLight1.updateSceneShader(sceneShaderProgram, "spotlight1");
+            // update all the pepe lights
+            int pepeNum = 1;
+            for (PointLight *pepelight : pepeLights) {
+                pepelight->updateSceneShader(sceneShaderProgram, "lightPepe" + to_string(pepeNum++), state->enableShadows);
+            }
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubeMap);
+            renderScene(sceneShaderProgram, state->enableTextures, sceneLODs);
+            profiler.end(sceneScope);
+
+            // Render fully lit space skybox without shadows
+            profiler.begin(skyboxScope);
+            glUniform1i(glGetUniformLocation(sceneShaderProgram, "fullLight"), true);
+            skyboxModel.render(sceneShaderProgram, state->enableTextures);
+            glUniform1i(glGetUniformLocation(sceneShaderProgram, "fullLight"), false);
+            profiler.end(skyboxScope);
+
+
+            ////////////////////////////////// DRAW TEXT ////////////////////////////////
+            profiler.begin(textScope);
+            if (state->showProfiler)
+                drawString(profiler.getReport() + textureManager.getReport(), profilerTextPosition, vec3(1.0f), 0.006f, textShaderProgram);
+
+            // play effects when time is running out
+            bool flashTime = state->timeFlashes != timeFlashesShown;
+            timeFlashesShown = state->timeFlashes;
+            timeTextEngine.drawText(flashTime, state->timeText, timeTextPosition, 0.01f, textShaderProgram);
+
+            if (state->gameRunning) {
+                // send textEngine a flicker signal when the player scores
+                if (state->scoreFlashes != scoreFlashesShown) // start flickering the text
+                    scoreTextEngine.drawText(true, state->scoreText, scoreTextPosition, 0.01f, textShaderProgram);
+                else // draw normally
+                    scoreTextEngine.drawText(state->scoreText, scoreTextPosition, 0.01f, textShaderProgram);
+
+                if (!state->hintText.empty())
+                    scoreTextEngine.drawText(state->hintText, hintTextPosition, 0.01f, textShaderProgram);
+            }
+            else // what to render when the game is done running (the end screen), change draw size and position
+                scoreTextEngine.drawText(true, state->scoreText + "\nRestart? (Y/N)", vec3(-0.85f, 0.35f, 0.0f), 0.01f * 3, textShaderProgram);
+            scoreFlashesShown = state->scoreFlashes;
+
+            profiler.end(textScope);
+            frameStreamBuffer().endFrame(); // nothing drawn after this reads the frame's streamed data
+
+            //end frame
+            if (benchmarking) {
+                frameGpuTimer.end();
+                frameSample.cpuMilliseconds = chrono::duration<double, milli>(Clock::now() - frameStart).count();
+                frameSample.drawCalls = glMetrics().drawCalls;
+                frameSample.stateChanges = glMetrics().stateChanges;
+                frameSample.uniformCalls = glMetrics().uniformCalls;
+                frameSample.uploadBytes = glMetrics().bufferBytes + glMetrics().textureBytes;
+            }
+            captureFrame(state->frameNumber, state->screenshots != screenshotsTaken, state->width, state->height); // before the swap, the back buffer is undefined after it
+            screenshotsTaken = state->screenshots;
+            if (window != NULL)
+                glfwSwapBuffers(window); //swap the front buffer with back buffer
+            else
+                glFinish(); // nothing paces the frames without a swap, and a frame's time has to include its rendering
+            profiler.collect();
+            frameCapture.update();
+            traceEnd("frame");
+
+            ////////////////////////////////// BENCHMARK //////////////////////////////////
+            if (benchmarking) {
+                Clock::time_point frameEnd = Clock::now();
+                frameSample.frameMilliseconds = chrono::duration<double, milli>(frameEnd - frameStart).count();
+                frameStart = frameEnd;
+                benchmark.addFrame(frameSample);
+
+                int gpuFrame;
+                double gpuMilliseconds;
+                while (frameGpuTimer.collect(gpuFrame, gpuMilliseconds))
+                    benchmark.setGpuTime(gpuFrame, gpuMilliseconds);
+
+                if (benchmark.isDone()) {
+                    while (frameGpuTimer.collectBlocking(gpuFrame, gpuMilliseconds))
+                        benchmark.setGpuTime(gpuFrame, gpuMilliseconds);
+
+                    // average time and GL calls of each phase over the whole run
+                    profiler.collect(true);
+                    for (int scope = 0; scope < profiler.getScopeCount(); scope++) {
+                        const ProfileScope& phase = profiler.getScope(scope);
+                        double runs = std::max(phase.cpu.totalCount, 1);
+                        PhaseSummary summary = { phase.name, phase.cpu.getRunAverage(), phase.gpu.getRunAverage(),
+                            phase.glTotal.drawCalls / runs, phase.glTotal.stateChanges / runs, phase.glTotal.uniformCalls / runs,
+                            (phase.glTotal.bufferBytes + phase.glTotal.textureBytes) / runs };
+                        benchmark.addPhase(summary);
+                    }
+                    for (const TextureStats& texture : textureManager.getStats()) {
+                        TextureSummary summary = { texture.name, (long long)texture.bytes, texture.references, texture.loads, texture.evictions };
+                        benchmark.addTexture(summary);
+                    }
+
+                    string session = scriptedCamera ? "scripted camera" : "replay " + replayPath;
+                    benchmark.writeCSV(benchmarkOutput + ".csv");
+                    benchmark.writeJSON(benchmarkOutput + ".json", session, (const char*)glGetString(GL_RENDERER), state->width, state->height);
+
+                    SampleSummary cpu = benchmark.summarize(&FrameSample::cpuMilliseconds);
+                    SampleSummary frame = benchmark.summarize(&FrameSample::frameMilliseconds);
+                    cout << "Benchmark: " << benchmarkFrames << " frames at " << state->width << "x" << state->height << " on " << glGetString(GL_RENDERER) << endl;
+                    cout << "  cpu ms p50/p95/p99: " << cpu.p50 << " / " << cpu.p95 << " / " << cpu.p99 << endl;
+                    cout << "  frame ms p50/p95/p99: " << frame.p50 << " / " << frame.p95 << " / " << frame.p99 << endl;
+                    cout << "  draw calls / uniform calls per frame p50: " << benchmark.summarize(&FrameSample::drawCalls).p50 << " / "
+                        << benchmark.summarize(&FrameSample::uniformCalls).p50 << endl;
+                }
+            }
+
+            if (state->last)
+                break;
+        }
+
+        // the GL objects go with the context, before it is handed back
+        finishGLTrace(); // the trace ends with the last frame, without the clean up
+        frameCapture.finish(); // the last frames are still on the GPU or waiting to be written
+        frameStreamBuffer().destroy();
+        frameGpuTimer.release();
+        profiler.release();
+        textureManager.destroy();
+        textureLoader.destroy();
+        renderTarget.destroy();
+        if (window != NULL)
+            glfwMakeContextCurrent(NULL);
+        else if (offscreenContext.isCreated())
+            offscreenContext.release();
+        mailbox.close(); // the main thread stops making states
+    };
 
-    shapeModel.rotationQuat = generateStartingAngle();
+    // a context is current on one thread at a time
+    if (window != NULL)
+        glfwMakeContextCurrent(NULL);
+    else if (offscreenContext.isCreated())
+        offscreenContext.release();
+    thread renderThread(renderFrames);
+
+    //Main loop, everything but the drawing: input, simulation and effects, handed to the render thread every frame
+    Clock::time_point nextStep = Clock::now();
+    while (window == NULL || !glfwWindowShouldClose(window)) {
+        traceBegin("simulate");
+        Clock::time_point simulationStart = Clock::now();
 
-    //Main loop
-    while (!glfwWindowShouldClose(window)) {
         // Frame time calculation
-        float dt = glfwGetTime() - lastFrameTime;
+        float dt = window != NULL ? glfwGetTime() - lastFrameTime : SIMULATION_STEP;
         lastFrameTime += dt;
+        if (lockstep)
+            dt = SIMULATION_STEP; // every run simulates the same frames whatever the speed of the machine
+
+        // get inputs
+        if (window != NULL) {
+            glfwPollEvents();
+            executeEvents(window, camera, dt);
+        }
+
+        ////////////////////////////////// SIMULATION //////////////////////////////////
+        // run as many fixed steps as the frame time covers, from the keyboard or from the recording being replayed
+        simulationAccumulator += std::min(dt, MAX_FRAME_TIME);
+        while (simulationAccumulator >= SIMULATION_STEP) {
+            SimulationInput input = readSimulationInput(window);
+            float simulationDt = SIMULATION_STEP;
+            if (inputPlayer.isOpen() && !inputPlayer.next(input, simulationDt)) {
+                cout << "Replay finished, back to the keyboard" << endl;
+                inputPlayer.close();
+            }
+            inputRecorder.record(input, simulationDt);
 
-		// window size callback called when window size changes
-		glfwSetWindowSizeCallback(window, window_size_callback);
+            previousSnapshot = simulation.getSnapshot();
+            unsigned int events = simulation.tick(input, simulationDt);
+            if (events & (EVENT_NEW_SHAPE | EVENT_GAME_OVER))
+                previousSnapshot = simulation.getSnapshot(); // the shape teleported, do not draw it sliding back
 
+            // let the renderer and sound react to what happened
+            handleSimulationEvents(events);
+            simulationAccumulator -= SIMULATION_STEP;
+        }
 
-        ////////////////////////////////// GENERATE SHADOW MAP //////////////////////////////////
-        // render the depth map
-        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT); // change view to the size of the shadow texture
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO); // bind the framebuffer
-        glClear(GL_DEPTH_BUFFER_BIT);
-        glUseProgram(shadowShaderProgram); // use proper shaders
-        // update values in shadow shader
-        mainLight.updateShadowShader(shadowShaderProgram);
-        renderScene(shadowShaderProgram); // render to make the texture
-        glBindFramebuffer(GL_FRAMEBUFFER, 0); // unbind depth map FBO
+        // place the shape where it is between the last two ticks
+        displaySnapshot = interpolateSnapshots(previousSnapshot, simulation.getSnapshot(), simulationAccumulator / SIMULATION_STEP);
 
 
         ////////////////////////////////// EXPLOSION EFFECT //////////////////////////////////
@@ -302,100 +860,104 @@ int main(int argc, char* argv[]) {
             if (curExplosionTime >= lengthOfExplosion) {// end explosion
                 explosionOccuring = false;
                 curExplosionTime = 0.0f;
-                mainLight.color = lightInitialColor;
+                mainLightColor = lightInitialColor;
             }
             else {
-                mainLight.color = (1 + (lightIntensityFactor * dt)) * mainLight.color;
+                mainLightColor = (1 + (lightIntensityFactor * dt)) * mainLightColor;
                 curExplosionTime += dt;
             }
         }
 
 
-        ////////////////////////////////// RENDER SCENE //////////////////////////////////
-        // render the scene as normal with the shadow mapping using the depth map
-        glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT); // reset viewport tot hte size of the window
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glUseProgram(sceneShaderProgram);
-        // update the values in the scene shader
-        camera.createMatrices(0.01f, 200.0f, sceneShaderProgram, WINDOW_WIDTH, WINDOW_HEIGHT);
-        mainLight.updateSceneShader(sceneShaderProgram, "pointlight1", enableShadows);
-        spotLight1.updateSceneShader(sceneShaderProgram, "spotlight1");
-        // update all the pepe lights
-        int pepeNum = 1;
-        for (PointLight *pepelight : pepeLights) {
-            pepelight->updateSceneShader(sceneShaderProgram, "lightPepe" + to_string(pepeNum++), enableShadows);
-        }
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubeMap);
-        renderScene(sceneShaderProgram);
-
-        // Render fully lit space skybox without shadows
-        glUniform1i(glGetUniformLocation(sceneShaderProgram, "fullLight"), true);
-        skyboxModel.render(sceneShaderProgram, enableTextures);
-        glUniform1i(glGetUniformLocation(sceneShaderProgram, "fullLight"), false);
-
-
-        ////////////////////////////////// DRAW TEXT ////////////////////////////////
-        // play effects when time is running out
-        if (totalTime - (lastFrameTime - gameLastStartTime) < 10 && !timeWarningGiven) {
-            timeTextEngine.drawText(true, "Time Left: \n" + to_string((int)(totalTime - lastFrameTime)), timeTextPosition, 0.01f, textShaderProgram);
-            timeWarningGiven = true;
-            soundEngine->play2D("../Assets/Sounds/running_out_of_time.wav", false); // from https://freesound.org/people/acclivity/sounds/32243/
-        }
-        else {
-            if(gameRunning)
-                timeTextEngine.drawText(false, "Time Left: \n" + to_string((int)(totalTime - (lastFrameTime - gameLastStartTime))), timeTextPosition, 0.01f, textShaderProgram);
-            else
-                timeTextEngine.drawText(false, "Time Left: \n0", timeTextPosition, 0.01f, textShaderProgram);
-        }
-
-
         ////////////////////////////////// GAME TIME EVNETS //////////////////////////////////
-        if (gameRunning) {
+        if (scriptedCamera)
+            placeBenchmarkCamera(frameNumber, runFrames);
+        if (lockstep && textureToggleInterval > 0 && frameNumber > 0 && frameNumber % textureToggleInterval == 0)
+            enableTextures = !enableTextures; // what X does, so the texture manager releases and acquires again
+        if (simulation.gameRunning) {
             // bind camera to object
-            camera.position = shapeModel.POS + vec3(0.0f, 4.5f, -8.0f) + cameraPositionBias;
-            camera.orientation = normalize(shapeModel.POS - camera.position);
-
-            // send textEngine a flicker signal when the player scores
-            if (flickerScore) { // start flickering the text
-                scoreTextEngine.drawText(true, "Score: \n" + to_string(score) + "\nHigh Score: \n" + to_string(highScore), scoreTextPosition, 0.01f, textShaderProgram);
-                flickerScore = false;
+            if (!scriptedCamera) {
+                camera.position = displaySnapshot.shapePosition + vec3(0.0f, 4.5f, -8.0f) + displaySnapshot.cameraPositionBias;
+                camera.orientation = normalize(displaySnapshot.shapePosition - camera.position);
             }
-            else // draw normally
-                scoreTextEngine.drawText("Score: \n" + to_string(score) + "\nHigh Score: \n" + to_string(highScore), scoreTextPosition, 0.01f, textShaderProgram);
-
-            if (totalTime - (lastFrameTime - gameLastStartTime) < 0)
-                endGame();
         }
-        else { // what to render when the game is done running (the end screen)
-            // change draw size and position when the game is over
-            scoreTextEngine.drawText(true, "Score: \n" + to_string(score) + "\nHigh Score: \n" + to_string(highScore) + "\nRestart? (Y/N)", vec3(-0.85f, 0.35f, 0.0f), 0.01f * 3, textShaderProgram);
-
+        else {
             // rotate pepes when game is done on end screen
             float rateOfRotation = 120.0f;
-            pepeModel1.rotationQuat *= angleAxis(radians(rateOfRotation * dt), vec3(0.0f, 1.0f, 0.0f));
-            pepeModel3.rotationQuat *= angleAxis(-radians(rateOfRotation * dt), vec3(0.0f, 1.0f, 0.0f));
-            pepeModel5.rotationQuat *= angleAxis(radians(rateOfRotation * dt), vec3(0.0f, 1.0f, 0.0f));
+            pepeRotations[0] *= angleAxis(radians(rateOfRotation * dt), vec3(0.0f, 1.0f, 0.0f));
+            pepeRotations[2] *= angleAxis(-radians(rateOfRotation * dt), vec3(0.0f, 1.0f, 0.0f));
+            pepeRotations[4] *= angleAxis(radians(rateOfRotation * dt), vec3(0.0f, 1.0f, 0.0f));
         }
 
-        //end frame
-        glfwSwapBuffers(window); //swap the front buffer with back buffer
-        glfwPollEvents(); //get inputs
-
-        // get inputs
-        executeEvents(window, camera, dt);
 
+        ////////////////////////////////// HAND THE FRAME OVER //////////////////////////////////
+        FrameState& state = mailbox.getWriteState();
+        state.frameNumber = frameNumber;
+        state.last = lockstep && frameNumber + 1 >= runFrames; // offscreen runs and benchmarks end after their frames
+        state.width = WINDOW_WIDTH;
+        state.height = WINDOW_HEIGHT;
+        state.cameraPosition = camera.position;
+        state.cameraOrientation = camera.orientation;
+        state.cameraUp = camera.up;
+        state.cameraFOV = camera.FOV;
+        state.currentShape = simulation.currentShape;
+        state.shapePosition = displaySnapshot.shapePosition;
+        state.shapeRotation = displaySnapshot.shapeRotation;
+        for (int i = 0; i < PEPE_COUNT; i++)
+            state.pepeRotations[i] = pepeRotations[i];
+        state.mainLightColor = mainLightColor;
+        state.pepeLightColor = pepeLightsColor;
+        state.enableShadows = enableShadows;
+        state.enableTextures = enableTextures;
+        state.showProfiler = showProfiler;
+        state.gameRunning = simulation.gameRunning;
+        state.timeText = "Time Left: \n" + to_string(simulation.gameRunning ? (int)simulation.getTimeLeft() : 0);
+        state.scoreText = "Score: \n" + to_string(simulation.score) + "\nHigh Score: \n" + to_string(simulation.highScore);
+        state.hintText = showHint && simulation.gameRunning ? getHintText() : "";
+        state.scoreFlashes = scoreFlashes;
+        state.timeFlashes = timeFlashes;
+        state.screenshots = screenshotRequests;
+        state.simulationMilliseconds = chrono::duration<double, milli>(Clock::now() - simulationStart).count();
+        traceEnd("simulate");
+        if (isTracing())
+            traceFlush(); // empties the rings before they fill up
+
+        // the state belongs to the render thread once published
+        bool last = state.last;
+        if (!mailbox.publish() || last)
+            break;
+        frameNumber++;
+
+        // a live game makes one state per step, the render thread draws the latest whenever it is ready
+        if (!lockstep) {
+            nextStep = std::max(nextStep + chrono::duration_cast<Clock::duration>(chrono::duration<float>(SIMULATION_STEP)), Clock::now());
+            this_thread::sleep_until(nextStep);
+        }
     }
 
+    mailbox.close();
+    renderThread.join();
+
+    if (nullBackend && getNullGLErrorCount() > 0)
+        cerr << "Null GL: " << getNullGLErrorCount() << " invalid calls" << endl;
+
+    if (isTracing())
+        traceWrite(tracePath);
+
+    offscreenContext.destroy();
+
     // Shutdown GLFW
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (window != NULL) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 
     return 0;
 }
 
 void executeEvents(GLFWwindow* window, Camera& camera, float dt) {
-    /* This function is used to execute all the inputs of the program
+    /* This function is used to execute all the inputs of the program that are not part of the game itself,
+    * the game keys are read by readSimulationInput
     * This program should only be called AFTER glfwPollEvents() was already called
     *
     *   window - current window of the program
@@ -404,170 +966,14 @@ void executeEvents(GLFWwindow* window, Camera& camera, float dt) {
     */
 
     //Note: these have to be static so that their state does not get reset on each function call
-    static bool BLastReleased = true, XLastReleased = true, SpaceLastReleased = true;
-    float rotationFactor = 5.0f;
-    static float modelMovementSpeed = 1.0f;
-    float slowMovementSpeed = 2.0f;
-    float fastMovementSpeed = 10.0f;
-
-    //variables for game
-    static float currentDeg = 0.0f; // tracks how much has been rotated 
-    float goalDeg = 90.0f; // how big a rotation will be
-    float rateOfRotation = 270.0f; // how fast the model will rotate
-    static vec3 rotationAxis = vec3(1.0f, 0.0f, 0.0f);
+    static bool BLastReleased = true, XLastReleased = true, HLastReleased = true, PLastReleased = true, TLastReleased = true;
+    static bool F12LastReleased = true;
 
     camera.processInputs(window, dt); // processes all camera inputs
 
-    if (gameRunning) {
-
-        // make shape go towards wall
-        shapeModel.POS += vec3(0.0f, 0.0f, modelMovementSpeed * dt);
-
-        if (shapeModel.POS.z > 0.0f) {
-            modelMovementSpeed = slowMovementSpeed;
-            shapePassedWall(); // called when we need a reset and a new model
-        }
-
-
-
-        if (shapeRotating) {
-            if (currentDeg < goalDeg) { // continue rotation loop
-                // if else checks if we are allowed to increase the rotation by the full allowed amount or not
-                if (currentDeg + rateOfRotation * dt > goalDeg)
-                    shapeModel.rotationQuat = angleAxis(radians(goalDeg - currentDeg), rotationAxis) * shapeModel.rotationQuat;
-                else
-                    shapeModel.rotationQuat = angleAxis(radians(rateOfRotation * dt), rotationAxis) * shapeModel.rotationQuat;
-            
-                currentDeg += rateOfRotation * dt;
-            }
-            else { // end rotation loop
-                // reset flags for next rotation
-                currentDeg = 0.0f;
-                shapeRotating = false;
-            }
-        }
-        else{
-            currentDeg = 0.0f;
-            if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-                shapeRotating = true;
-                rotationAxis = vec3(1.0f, 0.0f, 0.0f); // direction of rotation
-            }
- 
-            else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-                shapeRotating = true;
-                rotationAxis = -vec3(1.0f, 0.0f, 0.0f); // direction of rotation
-            }
-            else if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-                shapeRotating = true;
-                rotationAxis = vec3(0.0f, 1.0f, 0.0f); // direction of rotation
-            }
-            else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-                shapeRotating = true;
-                rotationAxis = -vec3(0.0f, 1.0f, 0.0f); // direction of rotation
-            }
-            else if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) {
-                shapeRotating = true;
-                rotationAxis = -vec3(0.0f, 0.0f, 1.0f); // direction of rotation
-            }
-            else if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) {
-                shapeRotating = true;
-                rotationAxis = vec3(0.0f, 0.0f, 1.0f); // direction of rotation
-            }
-        } 
-
-        // speed up model
-        if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_RELEASE)
-            SpaceLastReleased = true;
-        else if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && SpaceLastReleased) {
-            modelMovementSpeed = fastMovementSpeed;
-            SpaceLastReleased = false;
-        }
-
-        // for camera movement
-        static bool cameraMoving = false;
-        static vec3 initialBias;
-        static float overallCameraMovement = 0.0f;
-        static vec3 movementDirection;
-        static string cameraPositionX = "center";
-        static string cameraPositionY = "center";
-        float cameraMoveSpeed = 6.0f;
-        float desiredMovement = 2.0f;
-        
-
-        if (cameraMoving) {
-            if (overallCameraMovement >= desiredMovement) { // we finish moving
-                cameraPositionBias = initialBias + (desiredMovement * movementDirection); // snap into the proper position
-                overallCameraMovement = 0.0f; // reset counter
-                cameraMoving = false;
-            }
-            else { // we continue to move
-                cameraPositionBias += cameraMoveSpeed * dt * movementDirection;
-                overallCameraMovement += cameraMoveSpeed * dt;
-            }
-        }
-        else {
-            initialBias = cameraPositionBias;
-
-            if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) {
-                if (cameraPositionX != "left") { // make sure the camera is not all the way to the left
-                    cameraMoving = true;
-                    movementDirection = vec3(1.0f, 0.0f, 0.0f);
-
-                    if (cameraPositionX == "right")
-                        cameraPositionX = "center";
-                    else
-                        cameraPositionX = "left";
-                }
-            }
-            else if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) {
-                if (cameraPositionX != "right") { // make sure the camera is not all the way to the right
-                    cameraMoving = true;
-                    movementDirection = vec3(-1.0f, 0.0f, 0.0f);
-
-                    if (cameraPositionX == "left")
-                        cameraPositionX = "center";
-                    else
-                        cameraPositionX = "right";
-                }
-            }
-            else if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
-                if (cameraPositionY != "up") { // make sure the camera is not all the way to the top
-                    cameraMoving = true;
-                    movementDirection = vec3(0.0f, 1.0f, 0.0f);
-
-                    if (cameraPositionY == "down")
-                        cameraPositionY = "center";
-                    else
-                        cameraPositionY = "up";
-                }
-            }
-            else if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
-                if (cameraPositionY != "down") { // make sure the camera is not all the way to the top
-                    cameraMoving = true;
-                    movementDirection = vec3(0.0f, -1.0f, 0.0f);
-
-                    if (cameraPositionY == "up")
-                        cameraPositionY = "center";
-                    else
-                        cameraPositionY = "down";
-                }
-            }
-        }
-
-    } 
-    else {
-        if (glfwGetKey(window, GLFW_KEY_Y) == GLFW_PRESS) {
-            score = 0;
-            totalTime = 60.0f;
-            gameLastStartTime = glfwGetTime();
-            timeWarningGiven = false;
-            shapePassedWall();
-            gameRunning = true;
-        }
-        else if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS) {
-            glfwSetWindowShouldClose(window, GLFW_TRUE);
-        }
-    }
+    // quit from the end screen
+    if (!simulation.gameRunning && glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, GLFW_TRUE);
 
     // toggle shadows off and on
     if (glfwGetKey(window, GLFW_KEY_B) == GLFW_RELEASE)
@@ -585,37 +991,124 @@ void executeEvents(GLFWwindow* window, Camera& camera, float dt) {
         XLastReleased = false;
     }
 
+    // toggle the move hint off and on
+    if (glfwGetKey(window, GLFW_KEY_H) == GLFW_RELEASE)
+        HLastReleased = true;
+    else if (glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS && HLastReleased) {
+        showHint = !showHint;
+        HLastReleased = false;
+    }
+
+    // toggle the frame profiler off and on
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_RELEASE)
+        PLastReleased = true;
+    else if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS && PLastReleased) {
+        showProfiler = !showProfiler;
+        PLastReleased = false;
+    }
+
+    // write the trace recorded so far, the recording goes on
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_RELEASE)
+        TLastReleased = true;
+    else if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS && TLastReleased) {
+        if (isTracing() && traceWrite(tracePath))
+            cout << "Trace written to " << tracePath << endl;
+        TLastReleased = false;
+    }
+
+    // save the next frame
+    if (glfwGetKey(window, GLFW_KEY_F12) == GLFW_RELEASE)
+        F12LastReleased = true;
+    else if (glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS && F12LastReleased) {
+        screenshotRequests++;
+        F12LastReleased = false;
+    }
+
     // close the window on escape
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GLFW_TRUE);
 
 }
 
-void renderScene(GLuint shaderProgram) {
+SimulationInput readSimulationInput(GLFWwindow* window) {
+    // snapshot of the game keys for the next simulation tick, nothing is pressed without a window
+    SimulationInput input;
+    if (window == NULL)
+        return input;
+    input.rotate[MOVE_W] = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+    input.rotate[MOVE_S] = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+    input.rotate[MOVE_A] = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+    input.rotate[MOVE_D] = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+    input.rotate[MOVE_E] = glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS;
+    input.rotate[MOVE_Q] = glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS;
+    input.speedUp = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+    input.cameraLeft = glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS;
+    input.cameraRight = glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS;
+    input.cameraUp = glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS;
+    input.cameraDown = glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS;
+    input.restart = glfwGetKey(window, GLFW_KEY_Y) == GLFW_PRESS;
+    return input;
+}
+
+void handleSimulationEvents(unsigned int events) {
+    /* sound and visual effects for what happened during a simulation tick
+    *   events - SimulationEvent flags returned by GameSimulation::tick
+    */
+
+    // keeps track of what announcer track to play
+    static int announcerIndex = 0;
+
+    if (events & EVENT_WALL_PASSED) {
+        if (soundEngine != NULL)
+            playSound(successSounds[announcerIndex++ % successSounds.size()]); // playing success sound
+        scoreFlashes++; // the render thread starts the score flash effect
+    }
 
-    for (Model *pepe : pepeModels)
-        pepe->render(shaderProgram, enableTextures);
+    if (events & EVENT_WALL_HIT) {
+        if (soundEngine != NULL)
+            playSound("../Assets/Sounds/explosion.wav"); // from freesound.org
+        explosionOccuring = true;
+    }
 
-    wallModel.render(shaderProgram, enableTextures);
+    if (events & EVENT_NEW_SHAPE) {
+        // the render thread builds the new shape and its wall when it sees currentShape change
+        // change the main light for dramatic effect
+        mainLightColor = lightColors[effectsRandom.nextInt((int)lightColors.size())];
+    }
 
-    shapeModel.render(shaderProgram, enableTextures);
+    if (events & EVENT_TIME_WARNING) {
+        timeFlashes++;
+        if (soundEngine != NULL)
+            playSound("../Assets/Sounds/running_out_of_time.wav", false); // from https://freesound.org/people/acclivity/sounds/32243/
+    }
 
-    GroundFloor.render(shaderProgram, enableTextures);
+    if (events & EVENT_GAME_OVER)
+        endGame();
+}
 
+void renderScene(GLuint shaderProgram, bool enableTextures, const LODSettings& lodSettings) {
+    // recording only reads the models, the GL calls all happen below on this thread
+    jobSystem().parallelFor((int)sceneModels.size(), 1, [enableTextures, &lodSettings](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            TRACE_SCOPE("record model");
+            modelCommandLists[i].clear();
+            sceneModels[i]->record(modelCommandLists[i], enableTextures, lodSettings);
+        }
+    });
+
+    // merged in a fixed order so the frame is the same whichever thread recorded what
+    sceneCommands.clear();
+    for (CommandList& list : modelCommandLists)
+        sceneCommands.append(list);
+    sceneCommands.sort();
+    sceneCommands.execute(shaderProgram);
 }
 
 void initializeModels() {
+    TRACE_SCOPE("initialize models");
     // get VAOs
     GLuint cubeModelVAO = getCubeModel();
-
-    // generate the textures needed
-    GLuint blankTexture = loadTexture("../Assets/Textures/blank.jpg");
-    GLuint metalTexture = loadTexture("../Assets/Textures/wood_texture.jpg"); // from https://www.filterforge.com/filters/9452.jpg
-    GLuint explosiveTexture = loadTexture("../Assets/Textures/explosives.jpg"); // from https://i.pinimg.com/236x/52/27/9f/52279f962d19968863ab1448fa973466.jpg
-    GLuint dirtTexture = loadTexture("../Assets/Textures/dirt.jpg"); // from http://1.bp.blogspot.com/-dXMlsHE-rUI/UbWXQcc8aVI/AAAAAAAAEHw/fHwfk_zjVNQ/s1600/Seamless+ground+dirt+texture.jpg
-    GLuint whiteTex = loadTexture("../Assets/Textures/WhiteTex2.jpg"); // from https://seamless-pixels.blogspot.com/2012/07/seamless-wall-white-paint-stucco.html
-    GLuint spaceTexture = loadTexture("../Assets/Textures/space.jpg"); // from https://earth.google.com/web/data=CiQSIhIgMTU0MjhiZDQ3MjZiMTFlOWFjZjc5NWNjZjZlMjU3MDc
-    GLuint spaceTextureNEW = loadTexture("../Assets/Textures/spaceNEW.jpg");// from https://render.fineartamerica.com/images/rendered/medium/print/images/artworkimages/medium/2/space-stars-texture-sololos.jpg
+    acquireSceneTextures();
 
     // initialize Materials
     vec3 goldVec(0.780392f * 1.5f, 0.568627f * 1.5f, 0.113725f * 1.5f);
@@ -626,24 +1119,22 @@ void initializeModels() {
 
     shapeModel.setMaterial(explosiveMaterial);
     shapeModel.linkVAO(cubeModelVAO, 36);
-    shapeModel.linkTexture(explosiveTexture);
 
     wallModel.setMaterial(brickMaterial);
     wallModel.linkVAO(cubeModelVAO, 36);
-    wallModel.linkTexture(metalTexture);
 
     skyboxModel.linkVAO(cubeModelVAO, 36);
-    skyboxModel.linkTexture(spaceTextureNEW);
 
     int pepeVertices;
+    LODChain pepeLODs;
     Material pepeMaterial = Material(vec3((float)43 / 255, (float)106 / 255, (float)64 / 255), 0.2f);
-    GLuint pepeVAO = setupModelVBO("../Assets/Models/Pepe.obj", pepeVertices);
+    GLuint pepeVAO = setupModelVBO("../Assets/Models/Pepe.obj", pepeVertices, &pepeLODs);
     bool oddPepe = true;
 
     for (Model *pepe : pepeModels) {
         pepe->linkVAO(pepeVAO, pepeVertices);
+        pepe->linkLODs(pepeLODs);
         pepe->setMaterial(pepeMaterial);
-        pepe->linkTexture(whiteTex);
 
         if (oddPepe)
             pepe->rotationQuat = angleAxis(radians(180.0f), vec3(0.0f, 1.0f, 0.0f)) * pepe->rotationQuat;
@@ -654,209 +1145,456 @@ void initializeModels() {
     GroundFloor.linkVAO(cubeModelVAO, 36);
     GroundFloor.texWrapX = 8.0f;
     GroundFloor.texWrapY = 8.0f;
-    GroundFloor.linkTexture(dirtTexture);
     GroundFloor.setMaterial(tileMaterial);
+
+    linkSceneTextures();
+}
+
+void acquireSceneTextures() {
+    // the scene models' textures are layers of one array so they all draw with the same bind
+    // (blank.jpg and space.jpg are not drawn with, they are not loaded)
+    vector<string> sceneLayers = {
+        "../Assets/Textures/wood_texture.jpg", // from https://www.filterforge.com/filters/9452.jpg
+        "../Assets/Textures/explosives.jpg", // from https://i.pinimg.com/236x/52/27/9f/52279f962d19968863ab1448fa973466.jpg
+        "../Assets/Textures/dirt.jpg", // from http://1.bp.blogspot.com/-dXMlsHE-rUI/UbWXQcc8aVI/AAAAAAAAEHw/fHwfk_zjVNQ/s1600/Seamless+ground+dirt+texture.jpg
+        "../Assets/Textures/WhiteTex2.jpg" // from https://seamless-pixels.blogspot.com/2012/07/seamless-wall-white-paint-stucco.html
+    };
+    sceneTextures = textureManager.acquireArray("scene", 1024, 1024, sceneLayers);
+    skyboxTexture = textureManager.acquire("../Assets/Textures/spaceNEW.jpg");// from https://render.fineartamerica.com/images/rendered/medium/print/images/artworkimages/medium/2/space-stars-texture-sololos.jpg
 }
 
-void shapePassedWall() {
-    // scoring factors
-    int scoreForPassingWall = 100;
-    int timeScoreBonus = 300;
-    float timeBonusFactor = 0.9;
+void releaseSceneTextures() {
+    // nothing draws with them while the textures are off, past the budget the texture manager frees them until they are back on
+    textureManager.release(sceneTextures);
+    textureManager.release(skyboxTexture);
+    sceneTextures = skyboxTexture = 0;
+}
 
-    // keeps track of what announcer track to play
-    static int announcerIndex = 0;
+void linkSceneTextures() {
+    // to the names acquired last, they change when a texture was evicted in between
+    int metalTexture = 0, explosiveTexture = 1, dirtTexture = 2, whiteTex = 3; // layers of sceneTextures
+    shapeModel.linkTexture(sceneTextures, explosiveTexture);
+    wallModel.linkTexture(sceneTextures, metalTexture);
+    skyboxModel.linkTexture(skyboxTexture);
+    for (Model* pepe : pepeModels)
+        pepe->linkTexture(sceneTextures, whiteTex);
+    GroundFloor.linkTexture(sceneTextures, dirtTexture);
+}
 
-    if (gameRunning) {
-        // check if the shape was the correct orientation
-        float bias = radians(1.0f); // degrees off of a pure 0 deg due to floating point errors
-        bool passedThroughWall = true;
-        vec3 endingOrientation = eulerAngles(shapeModel.rotationQuat); // convert the quarternion to euler angles to make easier to conceptualize
-
-        if (!(endingOrientation.x > -bias && endingOrientation.x < bias)) // check x component
-            passedThroughWall = false;
-        if (!(endingOrientation.y > -bias && endingOrientation.y < bias)) // check y component
-            passedThroughWall = false;
-        if (!(endingOrientation.z > -bias && endingOrientation.z < bias)) // check z component
-            passedThroughWall = false;
-
-        if (passedThroughWall) { // events happening if the shape successfully passes the wall
-            soundEngine->play2D(successSounds[announcerIndex++ % successSounds.size()]); // playing success sound
-
-            // score calculations
-            int scoreToAdd = scoreForPassingWall + (int)(timeScoreBonus * pow(timeBonusFactor, glfwGetTime() - timeSinceLastPassed));
-            score += scoreToAdd;
-            highScore = score > highScore ? score : highScore;
-            totalTime += (score <= 1000 ? 5.0f : (5000.0f / (float)score));
-
-            flickerScore = true; // flag to begin score flash effect in the main loop
-        }
-        else { // events that happen if the shape fails to go through the wall
-            soundEngine->play2D("../Assets/Sounds/explosion.wav"); // from freesound.org
+vector<cubeInfo> buildWallCubes(string shapeFilePath) {
+    // the cubes of the wall for the shape, straight from its mask so there is no file to go stale in the asset pack
+    Bitmask2D wallMask = buildWallMask(shapeFilePath);
+    const int width = wallMask.getWidth(), height = wallMask.getHeight();
 
-            explosionOccuring = true;
+    vector<cubeInfo> cubes;
+    for (int y = -(height / 2); y <= height / 2; y++) {
+        for (int x = -(width / 2); x <= width / 2; x++) {
+            if (wallMask.test(x, y))
+                cubes.push_back(cubeInfo((GLfloat)x, (GLfloat)y, 0.0f, 1.0f, 1.0f, 1.0f));
         }
     }
+    return cubes;
+}
 
+void loadShapeCubes() {
+    // reads every shape and builds its wall, one job per shape like GameSimulation::loadShapes
+    TRACE_SCOPE("load shape cubes");
+    shapeCubes.assign(shapePaths.size(), vector<cubeInfo>());
+    wallCubes.assign(shapePaths.size(), vector<cubeInfo>());
+
+    jobSystem().parallelFor((int)shapePaths.size(), 1, [](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            shapeCubes[i] = Model::readCubes(shapePaths[i]);
+            wallCubes[i] = buildWallCubes(shapePaths[i]);
+        }
+    });
+}
 
-    timeSinceLastPassed = glfwGetTime(); // used for scoring the time component
+string getHintText() {
+    // the moves left to fit through the current wall, the turn in progress is already counted
+    RotationMove path[MAX_SOLUTION_LENGTH];
+    int length = getSolutionPath(simulation.getCurrentSolution(), simulation.targetOrientation, path);
 
-    shapeRotating = false; // stops errors that occur from the shape being in mid rotation when it passes the wall
+    if (length < 0)
+        return "Hint: no way through";
+    if (length == 0)
+        return "Hint: it fits!";
 
-	shapeModel.resetModel(); // brings shape to intial position
-    shapeModel.rotationQuat = generateStartingAngle(); // creates a random orientation for the new shape
+    string hint = "Hint:";
+    for (int i = 0; i < length; i++)
+        hint += string(" ") + getMoveKey(path[i]);
+    return hint;
+}
 
-    int filePathIndex = rand() % shapePaths.size();
-    while(shapeModel.getFilePath() == shapePaths[filePathIndex]) // ensure past shape is not the same as the new one
-        filePathIndex = rand() % shapePaths.size();
+void benchmarkOrientationSolver() {
+    /* times building the solution tables and answering every (shape, orientation) query, and checks that following
+    * the answer always ends in an orientation that passes in exactly the number of moves it promised
+    */
+    typedef chrono::high_resolution_clock Clock;
+    vector<ShapeOccupancy>& shapeOccupancies = simulation.shapeOccupancies;
+    vector<OrientationSolution>& orientationSolutions = simulation.orientationSolutions;
+    const int buildRepeats = 1000;
+    const int queryRepeats = 10000;
+
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < buildRepeats; r++) {
+        for (size_t s = 0; s < shapeOccupancies.size(); s++)
+            orientationSolutions[s] = solveOrientations(shapeOccupancies[s].passingOrientations);
+    }
+    double buildTime = chrono::duration<double, micro>(Clock::now() - start).count() / (buildRepeats * shapeOccupancies.size());
+
+    int failures = 0;
+    int longest = 0;
+    long long checksum = 0; // keeps the query loop from being optimized away
+    start = Clock::now();
+    for (int r = 0; r < queryRepeats; r++) {
+        for (size_t s = 0; s < orientationSolutions.size(); s++) {
+            for (int orientation = 0; orientation < CUBE_ROTATION_COUNT; orientation++) {
+                RotationMove path[MAX_SOLUTION_LENGTH];
+                checksum += getSolutionPath(orientationSolutions[s], orientation, path);
+            }
+        }
+    }
+    double queryTime = chrono::duration<double, nano>(Clock::now() - start).count() / (queryRepeats * orientationSolutions.size() * CUBE_ROTATION_COUNT);
+
+    for (size_t s = 0; s < orientationSolutions.size(); s++) {
+        for (int orientation = 0; orientation < CUBE_ROTATION_COUNT; orientation++) {
+            RotationMove path[MAX_SOLUTION_LENGTH];
+            int length = getSolutionPath(orientationSolutions[s], orientation, path);
+            int end = orientation;
+            for (int i = 0; i < length; i++)
+                end = applyMove(path[i], end);
+
+            if (length < 0 || !orientationPasses(shapeOccupancies[s], end)) {
+                cerr << "No solution for " << shapePaths[s] << " from orientation " << orientation << endl;
+                failures++;
+            }
+            longest = std::max(longest, length);
+        }
+    }
 
-	shapeModel.updateFilePath(shapePaths[filePathIndex]); // change the shape
+    cout << "Orientation solver: " << orientationSolutions.size() << " shapes x " << CUBE_ROTATION_COUNT << " orientations" << endl;
+    cout << "  solve per shape: " << buildTime << " us" << endl;
+    cout << "  full path query: " << queryTime << " ns (checksum " << checksum << ")" << endl;
+    cout << "  longest solution: " << longest << " moves, failures: " << failures << endl;
+}
 
-	wallModel.updateFilePath(buildWall(shapeModel.getFilePath())); // update the wall to correspond to the new shape
+void benchmarkSimulation() {
+    /* plays the game headless with a bot that follows the solver hints, at the same fixed step as the game,
+    * and reports how many ticks per real second the game logic can do
+    */
+    typedef chrono::high_resolution_clock Clock;
+    const int tickCount = 10000000;
+    const float dt = SIMULATION_STEP;
+
+    GameSimulation bot = GameSimulation(shapePaths, objectStartingPoint);
+    bot.loadShapes();
+    bot.startGame();
+
+    int wallsPassed = 0, wallsHit = 0, gamesPlayed = 1;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < tickCount; i++) {
+        SimulationInput input;
+        int move = getNextMove(bot.getCurrentSolution(), bot.targetOrientation);
+        if (move != -1 && bot.currentShape % 3 != 0) // the bot ignores some shapes on purpose so walls get hit too
+            input.rotate[move] = true;
+        input.speedUp = i % 2 == 0;
+        input.restart = true;
+
+        unsigned int events = bot.tick(input, dt);
+        wallsPassed += (events & EVENT_WALL_PASSED) != 0;
+        wallsHit += (events & EVENT_WALL_HIT) != 0;
+        gamesPlayed += (events & EVENT_GAME_RESTARTED) != 0;
+    }
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
 
-    // change the main light for dramatic effect
-    mainLight.color = lightColors[rand() % lightColors.size()];
+    cout << "Simulation: " << tickCount << " ticks (" << bot.time / 3600.0f << " hours of play) in " << seconds << " s" << endl;
+    cout << "  ticks per second: " << tickCount / seconds << endl;
+    cout << "  walls passed: " << wallsPassed << ", walls hit: " << wallsHit << ", games: " << gamesPlayed << ", high score: " << bot.highScore << endl;
 }
 
-void endGame() {
-    // handles the events to occur at the end of the game
-    shapeModel.resetModel();
-    gameRunning = false;
+void benchmarkJobSystem() {
+    /* the CPU side of a frame for scenes far bigger than the game's: every model turns a little, gets its world matrix
+    * rebuilt, its bounding sphere tested against the view frustum and, when visible, its draw recorded into the command
+    * list of its batch. The lists are then merged and sorted like renderScene does (nothing is executed).
+    * Each scene runs on one thread without the job system first, then split across 1, 2, 4... threads, and the
+    * visible counts have to match the single thread's
+    */
+    typedef chrono::high_resolution_clock Clock;
+    const int frameCount = 100;
+    const int sceneSizes[] = { 10000, 50000, 200000 };
+    const float dt = SIMULATION_STEP;
+    const int batchSize = 1024; // models per job, and per command list
+    const int meshCount = 4, textureCount = 3; // the synthetic models share a few meshes and textures
+
+    struct SyntheticModel {
+        vec3 position;
+        quat rotation;
+        float scale;
+        float spin; // radians per second around y
+    };
 
-    // ominous coloring
-    mainLight.color = vec3(0.0f, 0.5f , 0.0f); 
-    for (PointLight *pepeLight : pepeLights) {
-        pepeLight->color = vec3(0.85f, 0.25f, 0.0f);
+    // camera above the middle of the scene, looking down -z like the game's
+    mat4 viewProjection = perspective(radians(70.0f), 4.0f / 3.0f, 0.1f, 500.0f) * lookAt(vec3(0.0f, 10.0f, 0.0f), vec3(0.0f, 10.0f, -1.0f), vec3(0.0f, 1.0f, 0.0f));
+    mat4 rows = transpose(viewProjection);
+    vec4 frustum[6] = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2] };
+    for (vec4& plane : frustum)
+        plane /= length(vec3(plane));
+
+    vector<int> threadCounts;
+    int hardwareThreads = std::max((int)thread::hardware_concurrency(), 1);
+    for (int threads = 1; threads < hardwareThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(hardwareThreads);
+
+    cout << "Job system: " << frameCount << " frames per scene, " << hardwareThreads << " hardware threads" << endl;
+    for (int modelCount : sceneSizes) {
+        Random random(modelCount);
+        vector<SyntheticModel> initialModels(modelCount);
+        for (SyntheticModel& model : initialModels) {
+            model.position = vec3(random.nextInt(400) - 200.0f, random.nextInt(20) * 1.0f, random.nextInt(400) - 200.0f);
+            model.rotation = angleAxis(radians((float)random.nextInt(360)), vec3(0.0f, 1.0f, 0.0f));
+            model.scale = 0.5f + random.nextInt(100) / 50.0f;
+            model.spin = radians(random.nextInt(180) - 90.0f);
+        }
+
+        vector<SyntheticModel> models;
+        vector<mat4> worldMatrices(modelCount);
+        vector<CommandList> batchCommands((modelCount + batchSize - 1) / batchSize);
+        CommandList frameCommands;
+        auto updateModels = [&](int begin, int end) {
+            CommandList& commands = batchCommands[begin / batchSize];
+            commands.clear();
+            for (int i = begin; i < end; i++) {
+                SyntheticModel& model = models[i];
+                model.rotation = angleAxis(model.spin * dt, vec3(0.0f, 1.0f, 0.0f)) * model.rotation;
+                worldMatrices[i] = translate(mat4(1.0f), model.position) * mat4_cast(model.rotation) * glm::scale(mat4(1.0f), vec3(model.scale));
+
+                float radius = model.scale * 0.866f; // half the diagonal of a unit cube
+                bool inside = true;
+                for (int p = 0; p < 6 && inside; p++)
+                    inside = dot(vec3(frustum[p]), model.position) + frustum[p].w > -radius;
+
+                if (inside) {
+                    DrawUniforms uniforms;
+                    uniforms.worldMatrix = worldMatrices[i];
+                    uniforms.materialColor = vec3(1.0f);
+                    uniforms.materialShininess = 0.1f;
+                    uniforms.texWrapX = uniforms.texWrapY = 1.0f;
+                    uniforms.enableTextures = true;
+                    uniforms.textureLayer = -1.0f;
+
+                    GLuint mesh = 1 + i % meshCount, texture = 1 + i % textureCount;
+                    uint64_t sortKey = CommandList::makeSortKey(mesh, texture);
+                    commands.bind(sortKey, mesh, texture);
+                    commands.setUniformBlock(sortKey, uniforms);
+                    commands.draw(sortKey, GL_TRIANGLES, 0, 36);
+                }
+            }
+        };
+
+        // threads == 0 is the plain loop
+        double serialTime = 0.0;
+        int serialVisible = 0;
+        cout << "  " << modelCount << " models" << endl;
+        for (int threads = 0; threads <= (int)threadCounts.size(); threads++) {
+            int threadCount = threads == 0 ? 1 : threadCounts[threads - 1];
+            unique_ptr<JobSystem> jobs(threads == 0 ? NULL : new JobSystem(threadCount - 1));
+            models = initialModels;
+
+            Clock::time_point start = Clock::now();
+            for (int frame = 0; frame < frameCount; frame++) {
+                if (jobs)
+                    jobs->parallelFor(modelCount, batchSize, updateModels);
+                else {
+                    for (int begin = 0; begin < modelCount; begin += batchSize)
+                        updateModels(begin, std::min(begin + batchSize, modelCount));
+                }
+
+                frameCommands.clear();
+                for (CommandList& commands : batchCommands)
+                    frameCommands.append(commands);
+                frameCommands.sort();
+            }
+            double frameTime = chrono::duration<double, milli>(Clock::now() - start).count() / frameCount;
+
+            int visibleCount = frameCommands.getDrawCount();
+
+            if (threads == 0) {
+                serialTime = frameTime;
+                serialVisible = visibleCount;
+                cout << "    single thread: " << frameTime << " ms per frame, " << visibleCount << " visible" << endl;
+            }
+            else {
+                cout << "    " << threadCount << " threads: " << frameTime << " ms per frame, " << serialTime / frameTime << "x";
+                if (visibleCount != serialVisible)
+                    cout << " (" << visibleCount << " visible, expected " << serialVisible << ")";
+                cout << endl;
+            }
+        }
     }
+}
 
-    // set the scene for ending
-    cameraPositionBias = vec3(0.0f);
-    camera.position = pepeModel3.POS + vec3(-7.5f, 0.0f, 0.0f);
-    camera.orientation = normalize(pepeModel3.POS - camera.position);
+void replaySimulation() {
+    /* plays the whole recording opened in inputPlayer without a window and prints where the game ended up,
+    * the same recording has to print the same thing on every run and every machine
+    */
+    SimulationInput input;
+    float dt;
+    int frameCount = 0, wallsPassed = 0, wallsHit = 0;
+
+    simulation.startGame();
+    while (inputPlayer.next(input, dt)) {
+        unsigned int events = simulation.tick(input, dt);
+        wallsPassed += (events & EVENT_WALL_PASSED) != 0;
+        wallsHit += (events & EVENT_WALL_HIT) != 0;
+        frameCount++;
+    }
+    inputPlayer.close();
 
+    cout << "Replayed " << frameCount << " frames (" << simulation.time << " s), seed " << simulation.getSeed() << endl;
+    cout << "  score: " << simulation.score << ", high score: " << simulation.highScore << ", walls passed: " << wallsPassed << ", walls hit: " << wallsHit << endl;
+    cout << "  shape " << simulation.currentShape << " in orientation " << simulation.shapeOrientation << " at z " << simulation.shapePosition.z << (simulation.gameRunning ? "" : ", game over") << endl;
 }
 
-GLuint compileAndLinkShaders(string vertexShaderFilePath, string fragmentShaderFilePath){
-    /* compile and link shader program
-    * return shader program id
+int playGLTrace(string filePath) {
+    /* -playgl, plays a trace recorded with -gltrace (GLTrace.hpp) without the game: no models, sound or simulation,
+    * only the GL calls, on an offscreen context (a hidden window where there is none) into a render target of the
+    * trace's size. Nothing waits for a display so the frames go as fast as the driver takes them.
+    * Plays every frame once, or -benchmark N frames going around the trace and writes the results like a benchmark.
     */
+    GLTracePlayer player;
+    if (!player.open(filePath))
+        return -1;
 
-    // create vertex shader
-    const char* vertexShaderSource = readFile(vertexShaderFilePath);
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-
-    // check for shader compile errors
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << endl;
+    OffscreenContext offscreenContext;
+    GLFWwindow* window = NULL;
+    if (nullBackend)
+        installNullGL();
+    else if (!offscreenContext.create(3, 3)) {
+        cerr << "Playing the GL trace in a hidden window instead" << endl;
+        window = createWindow(false);
+        if (window == NULL)
+            return -1;
+        glfwSwapInterval(0);
     }
 
-    // create fragment shader
-    const char* fragmentShaderSource = readFile(fragmentShaderFilePath);
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-
-    // check for shader compile errors
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << endl;
+    glewExperimental = true;
+    GLenum glewStatus = nullBackend ? GLEW_OK : glewInit();
+    if (glewStatus != GLEW_OK && !(offscreenContext.isCreated() && glewStatus == GLEW_ERROR_NO_GLX_DISPLAY)) {
+        cerr << "Failed to create GLEW" << endl;
+        glfwTerminate();
+        return -1;
     }
 
-    //create shader program
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    //link the shader program
-    glLinkProgram(shaderProgram);
-
-    // check for linking errors
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << endl;
+    RenderTarget renderTarget;
+    if (!renderTarget.create(player.getWidth(), player.getHeight()))
+        return -1;
+    player.setDefaultFramebuffer(renderTarget.getFramebuffer());
+
+    typedef chrono::high_resolution_clock Clock;
+    Clock::time_point startupStart = Clock::now();
+    if (!player.playStartup())
+        return -1;
+    glFinish();
+    double startupMilliseconds = chrono::duration<double, milli>(Clock::now() - startupStart).count();
+
+    int frameCount = benchmarkFrames > 0 ? benchmarkFrames : player.getFrameCount();
+    FrameBenchmark benchmark(frameCount, benchmarkFrames > 0 ? std::min(benchmarkWarmupFrames, frameCount / 2) : 0);
+    GpuTimer frameGpuTimer;
+    FrameSample frameSample;
+    Clock::time_point frameStart = Clock::now();
+    while (!benchmark.isDone()) {
+        glMetricsEndFrame();
+        frameGpuTimer.begin();
+        if (!player.playFrame())
+            return -1;
+        frameGpuTimer.end();
+
+        Clock::time_point frameEnd = Clock::now();
+        frameSample.cpuMilliseconds = frameSample.frameMilliseconds = chrono::duration<double, milli>(frameEnd - frameStart).count();
+        frameSample.drawCalls = glMetrics().drawCalls;
+        frameSample.stateChanges = glMetrics().stateChanges;
+        frameSample.uniformCalls = glMetrics().uniformCalls;
+        frameSample.uploadBytes = glMetrics().bufferBytes + glMetrics().textureBytes;
+        frameStart = frameEnd;
+        benchmark.addFrame(frameSample);
+
+        int gpuFrame;
+        double gpuMilliseconds;
+        while (frameGpuTimer.collect(gpuFrame, gpuMilliseconds))
+            benchmark.setGpuTime(gpuFrame, gpuMilliseconds);
+    }
+    glFinish();
+    int gpuFrame;
+    double gpuMilliseconds;
+    while (frameGpuTimer.collectBlocking(gpuFrame, gpuMilliseconds))
+        benchmark.setGpuTime(gpuFrame, gpuMilliseconds);
+
+    string renderer = (const char*)glGetString(GL_RENDERER);
+    if (benchmarkFrames > 0) {
+        benchmark.writeCSV(benchmarkOutput + ".csv");
+        benchmark.writeJSON(benchmarkOutput + ".json", "gl trace " + filePath, renderer, player.getWidth(), player.getHeight());
     }
 
-    //delete shaders since they are already in the program
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    SampleSummary frame = benchmark.summarize(&FrameSample::frameMilliseconds);
+    SampleSummary gpu = benchmark.summarize(&FrameSample::gpuMilliseconds);
+    cout << "GL trace: " << frameCount << " frames of " << filePath << " at " << player.getWidth() << "x" << player.getHeight() << " on " << renderer << endl;
+    cout << "  startup ms: " << startupMilliseconds << endl;
+    cout << "  frame ms p50/p95/p99: " << frame.p50 << " / " << frame.p95 << " / " << frame.p99 << endl;
+    if (frameGpuTimer.isSupported())
+        cout << "  gpu ms p50/p95/p99: " << gpu.p50 << " / " << gpu.p95 << " / " << gpu.p99 << endl;
+    cout << "  draw calls / uniform calls per frame p50: " << benchmark.summarize(&FrameSample::drawCalls).p50 << " / "
+        << benchmark.summarize(&FrameSample::uniformCalls).p50 << endl;
+
+    frameGpuTimer.release();
+    renderTarget.destroy();
+    offscreenContext.destroy();
+    if (window != NULL) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+    return 0;
+}
 
-    return shaderProgram;
+void placeBenchmarkCamera(int frame, int frameCount) {
+    /* scripted fly around of the stage for benchmarks that do not replay a session, one full turn over the run
+    * with the height going up and down so the shadows, the pepes, the wall and the sky all get on screen
+    */
+    vec3 stageCenter = vec3(0.0f, -8.0f, -5.0f);
+    float progress = (float)frame / (float)std::max(frameCount, 1);
+    float angle = radians(360.0f) * progress;
+
+    camera.position = stageCenter + vec3(30.0f * sin(angle), 6.0f + 10.0f * sin(2.0f * angle), 30.0f * cos(angle));
+    camera.orientation = normalize(stageCenter - camera.position);
 }
 
-GLuint compileAndLinkShaders(string vertexShaderFilePath, string geometryShaderFilePath, string fragmentShaderFilePath) {
-    /* compile and link shader program
-* return shader program id
-*/
-
-// create vertex shader
-    const char* vertexShaderSource = readFile(vertexShaderFilePath);
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-
-    // check for shader compile errors
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << endl;
-    }
+void endGame() {
+    // handles the events to occur at the end of the game, the simulation already stopped the game itself
 
-    // create geometry shader
-    const char* geometryShaderSource = readFile(geometryShaderFilePath);
-    GLuint geometryShader = glCreateShader(GL_GEOMETRY_SHADER);
-    glShaderSource(geometryShader, 1, &geometryShaderSource, NULL);
-    glCompileShader(geometryShader);
-
-    // check for shader compile errors
-    glGetShaderiv(geometryShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(geometryShader, 512, NULL, infoLog);
-        cerr << "ERROR::SHADER::GEOMETRY::COMPILATION_FAILED\n" << infoLog << endl;
-    }
+    // ominous coloring
+    mainLightColor = vec3(0.0f, 0.5f , 0.0f); 
+    pepeLightsColor = vec3(0.85f, 0.25f, 0.0f);
 
-    // create fragment shader
-    const char* fragmentShaderSource = readFile(fragmentShaderFilePath);
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-
-    // check for shader compile errors
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << endl;
-    }
+    // set the scene for ending
+    camera.position = pepeModel3.POS + vec3(-7.5f, 0.0f, 0.0f);
+    camera.orientation = normalize(pepeModel3.POS - camera.position);
 
-    //create shader program
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, geometryShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    //link the shader program
-    glLinkProgram(shaderProgram);
-
-    // check for linking errors
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << endl;
-    }
+}
 
-    //delete shaders since they are already in the program
-    glDeleteShader(vertexShader);
-    glDeleteShader(geometryShader);
-    glDeleteShader(fragmentShader);
+GLuint compileAndLinkShaders(string vertexShaderFilePath, string fragmentShaderFilePath){
+    /* compile and link shader program, or load it from the program cache
+    * return shader program id
+    */
+    return programCache.getProgram({ { GL_VERTEX_SHADER, vertexShaderFilePath }, { GL_FRAGMENT_SHADER, fragmentShaderFilePath } });
+}
 
-    return shaderProgram;
+GLuint compileAndLinkShaders(string vertexShaderFilePath, string geometryShaderFilePath, string fragmentShaderFilePath) {
+    /* compile and link shader program, or load it from the program cache
+    * return shader program id
+    */
+    return programCache.getProgram({ { GL_VERTEX_SHADER, vertexShaderFilePath }, { GL_GEOMETRY_SHADER, geometryShaderFilePath },
+        { GL_FRAGMENT_SHADER, fragmentShaderFilePath } });
 }
 
 void renderGrid(GLuint shaderProgram) {
@@ -962,70 +1700,16 @@ GLuint getCubeModel() {
     return VAO;
 }
 
-char* readFile(string filePath) { //credit: https://badvertex.com/2012/11/20/how-to-load-a-glsl-shader-in-opengl-using-c.html
-    string content;
-    ifstream fileStream(filePath, ios::in);
 
-    if (!fileStream.is_open()) {
-        cerr << "Could not read file " << filePath << ". File does not exist." << endl;
-        return "";
-    }
-
-    string line = "";
-    while (!fileStream.eof()) {
-        getline(fileStream, line);
-        content.append(line + "\n");
-    }
-
-    fileStream.close();
-
-    char* chars = new char[content.length() + 1];
-    strcpy(chars, content.c_str());
-
-    return chars;
-}
-
-quat generateStartingAngle() {
-    float possibleAngles[] = { 0.0f, 90.0f, 180.0f, 270.0f };
-    int arraySize = 4;
-    return quat(vec3(radians(possibleAngles[rand() % arraySize]), radians(possibleAngles[rand() % arraySize]), radians(possibleAngles[rand() % arraySize])));
-}
-
-GLuint loadTexture(const char* filename) {
-    // Step1 Create and bind textures
-    GLuint textureId;
-    glGenTextures(1, &textureId);
-    
-    glBindTexture(GL_TEXTURE_2D, textureId);
-
-    // Step2 Set filter parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // Step3 Load Textures with dimension data
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(filename, &width, &height, &nrChannels, 0);
-    if (!data)
-    {
-        std::cerr << "Error::Texture could not load texture file:" << filename << std::endl;
-        return 0;
+void playSound(const char* filePath, bool looped) {
+    /* plays a sound on soundEngine, the first time a sound of the asset pack is played irrKlang is given its view of the
+    * pack instead of the file name, it decodes it from there without copying it
+    */
+    if (soundEngine->getSoundSource(filePath, false) == NULL && assets().isPacked(filePath)) {
+        AssetView sound = assets().open(filePath);
+        soundEngine->addSoundSourceFromMemory((void*)sound.getData(), (irrklang::ik_s32)sound.getSize(), filePath, false);
     }
-
-    // Step4 Upload the texture to the PU
-    GLenum format = 0;
-    if (nrChannels == 1)
-        format = GL_RED;
-    else if (nrChannels == 3)
-        format = GL_RGB;
-    else if (nrChannels == 4)
-        format = GL_RGBA;
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height,
-        0, format, GL_UNSIGNED_BYTE, data);
-
-    // Step5 Free resources
-    stbi_image_free(data);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    return textureId;
+    soundEngine->play2D(filePath, looped);
 }
 
 void getShadowCubeMap(GLuint* depthMapFBO, GLuint* depthCubeMap) {
@@ -1053,13 +1737,76 @@ void getShadowCubeMap(GLuint* depthMapFBO, GLuint* depthCubeMap) {
 
 }
 
+GLFWwindow* createWindow(bool visible) {
+    /* initializes GLFW and makes the window the GL context belongs to
+    * returns NULL when it fails
+    */
+    glfwInit(); //initialize GLFW
+    //determine openGL version to initialize
+#if defined(PLATFORM_OSX)	
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#else
+    // On windows, we set OpenGL version to 2.1, to support more hardware
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+#endif
+
+    // benchmarks run unattended (build servers, xvfb-run), nothing needs to be shown
+    if (!visible)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    // Create Window and rendering context using GLFW, resolution is 800x600
+    GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Comp371 - Assignment 1", NULL, NULL);
+    if (window == NULL) {
+        cerr << "Failed to create GLFW window" << endl;
+        glfwTerminate();
+        return NULL;
+    }
+    glfwMakeContextCurrent(window);
+    return window;
+}
+
+void captureFrame(int frame, bool screenshot, int width, int height) {
+    /* hands what was drawn this frame to the capture when something wants it: a screenshot, the -png frames
+    * (numbered, zero padded so the files sort in order) or the -y4m video
+    */
+    string imagePath;
+    if (screenshot) {
+        char name[64];
+        time_t now = time(NULL);
+        strftime(name, sizeof(name), "screenshot_%Y%m%d_%H%M%S.png", localtime(&now));
+        imagePath = name;
+        cout << "Saving a screenshot to " << imagePath << endl;
+    }
+    else if (!framePrefix.empty() && frame % frameInterval == 0) {
+        char number[16];
+        snprintf(number, sizeof(number), "%05d", frame);
+        imagePath = framePrefix + number + ".png";
+    }
+
+    if (!imagePath.empty() || frameCapture.hasVideo())
+        frameCapture.capture(sceneFramebuffer, width, height, imagePath, true);
+}
+
 void window_size_callback(GLFWwindow* window, int width, int height)
 {
 	WINDOW_WIDTH = width;
 	WINDOW_HEIGHT = height;
 }
 
-GLuint setupModelVBO(string path, int& vertexCount) {
+GLuint setupModelVBO(string path, int& vertexCount, LODChain* lodChain) {
+    /* loads an OBJ model into a VAO
+    *
+    *   path - path of the OBJ file
+    *   vertexCount - set to the number of vertices of the full detail mesh
+    *   lodChain - when given, filled with simplified versions of the mesh for distance based LOD selection
+    *
+    * returns the VAO of the full detail mesh
+    */
+    TRACE_SCOPE("load OBJ");
     std::vector<glm::vec3> vertices;
     std::vector<glm::vec3> normals;
     std::vector<glm::vec2> UVs;
@@ -1067,6 +1814,24 @@ GLuint setupModelVBO(string path, int& vertexCount) {
     //read the vertex data from the model's OBJ file
     loadOBJ(path.c_str(), vertices, normals, UVs);
 
+    GLuint VAO = createMeshVAO(vertices, normals, UVs);
+    vertexCount = vertices.size();
+
+    if (lodChain != NULL) {
+        // each level keeps half the triangles of the previous one
+        vector<SimplifiedMesh> meshes = buildLODChain(vertices, normals, UVs, 5, 0.5f, 64);
+
+        lodChain->levels.clear();
+        lodChain->boundingRadius = getBoundingRadius(vertices);
+        lodChain->levels.push_back({ VAO, vertexCount, 0.0f });
+        for (size_t i = 1; i < meshes.size(); i++)
+            lodChain->levels.push_back({ createMeshVAO(meshes[i].vertices, meshes[i].normals, meshes[i].UVs), (int)meshes[i].vertices.size(), meshes[i].geometricError });
+    }
+
+    return VAO;
+}
+
+GLuint createMeshVAO(vector<vec3>& vertices, vector<vec3>& normals, vector<vec2>& UVs) {
     GLuint VAO;
     glGenVertexArrays(1, &VAO);
     glBindVertexArray(VAO); //Becomes active VAO
@@ -1098,6 +1863,5 @@ GLuint setupModelVBO(string path, int& vertexCount) {
     
 
     glBindVertexArray(0); // Unbind VAO (it's always a good thing to unbind any buffer/array to prevent strange bugs, as we are using multiple VAOs)
-    vertexCount = vertices.size();
     return VAO;
 }
@@ -0,0 +1,145 @@
+#include "Benchmark.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <cmath>
+
+FrameBenchmark::FrameBenchmark(int pFrameCount, int pWarmupFrames) {
+    frameCount = pFrameCount;
+    warmupFrames = pWarmupFrames;
+    samples.reserve(frameCount);
+}
+
+void FrameBenchmark::addFrame(const FrameSample& sample) {
+    samples.push_back(sample);
+}
+
+void FrameBenchmark::setGpuTime(int frame, double milliseconds) {
+    if (frame >= 0 && frame < (int)samples.size())
+        samples[frame].gpuMilliseconds = milliseconds;
+}
+
+void FrameBenchmark::addPhase(const PhaseSummary& phase) {
+    phases.push_back(phase);
+}
+
+void FrameBenchmark::addTexture(const TextureSummary& texture) {
+    textures.push_back(texture);
+}
+
+SampleSummary FrameBenchmark::summarizeValues(std::vector<double> values) {
+    /* nearest rank percentiles, all zeros when there is nothing to summarize */
+    SampleSummary summary = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+    if (values.empty())
+        return summary;
+
+    std::sort(values.begin(), values.end());
+    double total = 0.0;
+    for (double value : values)
+        total += value;
+
+    int count = (int)values.size();
+    summary.mean = total / count;
+    summary.p50 = values[std::min(count - 1, (int)std::ceil(0.50 * count) - 1)];
+    summary.p95 = values[std::min(count - 1, (int)std::ceil(0.95 * count) - 1)];
+    summary.p99 = values[std::min(count - 1, (int)std::ceil(0.99 * count) - 1)];
+    summary.max = values.back();
+    return summary;
+}
+
+SampleSummary FrameBenchmark::summarize(double FrameSample::* field) const {
+    std::vector<double> values;
+    for (size_t i = warmupFrames; i < samples.size(); i++) {
+        if (samples[i].*field >= 0.0) // skips the frames without a GPU time
+            values.push_back(samples[i].*field);
+    }
+    return summarizeValues(values);
+}
+
+SampleSummary FrameBenchmark::summarize(int FrameSample::* field) const {
+    std::vector<double> values;
+    for (size_t i = warmupFrames; i < samples.size(); i++)
+        values.push_back(samples[i].*field);
+    return summarizeValues(values);
+}
+
+SampleSummary FrameBenchmark::summarize(long long FrameSample::* field) const {
+    std::vector<double> values;
+    for (size_t i = warmupFrames; i < samples.size(); i++)
+        values.push_back((double)(samples[i].*field));
+    return summarizeValues(values);
+}
+
+bool FrameBenchmark::writeCSV(std::string filePath) const {
+    std::ofstream file(filePath, std::ios::out);
+    if (!file.is_open()) {
+        std::cerr << "Could not create file " << filePath << "." << std::endl;
+        return false;
+    }
+
+    file << "frame,warmup,cpu_ms,frame_ms,gpu_ms,draw_calls,state_changes,uniform_calls,upload_bytes\n";
+    for (size_t i = 0; i < samples.size(); i++) {
+        const FrameSample& sample = samples[i];
+        file << i << "," << ((int)i < warmupFrames ? 1 : 0) << "," << sample.cpuMilliseconds << "," << sample.frameMilliseconds << ","
+            << sample.gpuMilliseconds << "," << sample.drawCalls << "," << sample.stateChanges << "," << sample.uniformCalls << ","
+            << sample.uploadBytes << "\n";
+    }
+    return true;
+}
+
+static void writeSummary(std::ofstream& file, std::string name, SampleSummary summary, bool last) {
+    file << "    \"" << name << "\": { \"mean\": " << summary.mean << ", \"p50\": " << summary.p50 << ", \"p95\": " << summary.p95
+        << ", \"p99\": " << summary.p99 << ", \"max\": " << summary.max << " }" << (last ? "\n" : ",\n");
+}
+
+static std::string escapeJSON(std::string text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+bool FrameBenchmark::writeJSON(std::string filePath, std::string session, std::string renderer, int width, int height) const {
+    std::ofstream file(filePath, std::ios::out);
+    if (!file.is_open()) {
+        std::cerr << "Could not create file " << filePath << "." << std::endl;
+        return false;
+    }
+
+    file << "{\n";
+    file << "  \"session\": \"" << escapeJSON(session) << "\",\n";
+    file << "  \"renderer\": \"" << escapeJSON(renderer) << "\",\n";
+    file << "  \"width\": " << width << ",\n";
+    file << "  \"height\": " << height << ",\n";
+    file << "  \"frames\": " << samples.size() << ",\n";
+    file << "  \"warmup_frames\": " << warmupFrames << ",\n";
+    file << "  \"summary\": {\n";
+    writeSummary(file, "cpu_ms", summarize(&FrameSample::cpuMilliseconds), false);
+    writeSummary(file, "frame_ms", summarize(&FrameSample::frameMilliseconds), false);
+    writeSummary(file, "gpu_ms", summarize(&FrameSample::gpuMilliseconds), false);
+    writeSummary(file, "draw_calls", summarize(&FrameSample::drawCalls), false);
+    writeSummary(file, "state_changes", summarize(&FrameSample::stateChanges), false);
+    writeSummary(file, "uniform_calls", summarize(&FrameSample::uniformCalls), false);
+    writeSummary(file, "upload_bytes", summarize(&FrameSample::uploadBytes), true);
+    file << "  },\n";
+    file << "  \"phases\": {\n";
+    for (size_t i = 0; i < phases.size(); i++) {
+        const PhaseSummary& phase = phases[i];
+        file << "    \"" << escapeJSON(phase.name) << "\": { \"cpu_ms\": " << phase.cpuMilliseconds << ", \"gpu_ms\": " << phase.gpuMilliseconds
+            << ", \"draw_calls\": " << phase.drawCalls << ", \"state_changes\": " << phase.stateChanges << ", \"uniform_calls\": " << phase.uniformCalls
+            << ", \"upload_bytes\": " << phase.uploadBytes << " }" << (i + 1 < phases.size() ? ",\n" : "\n");
+    }
+    file << "  },\n";
+    file << "  \"textures\": {\n";
+    for (size_t i = 0; i < textures.size(); i++) {
+        const TextureSummary& texture = textures[i];
+        file << "    \"" << escapeJSON(texture.name) << "\": { \"bytes\": " << texture.bytes << ", \"references\": " << texture.references
+            << ", \"loads\": " << texture.loads << ", \"evictions\": " << texture.evictions << " }" << (i + 1 < textures.size() ? ",\n" : "\n");
+    }
+    file << "  }\n";
+    file << "}\n";
+    return true;
+}
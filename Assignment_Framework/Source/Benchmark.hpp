@@ -0,0 +1,67 @@
+#ifndef BENCHMARK_CLASS_H
+#define BENCHMARK_CLASS_H
+
+#include <string>
+#include <vector>
+
+struct FrameSample {
+	double cpuMilliseconds = 0.0; // frame start until everything is submitted, before the buffer swap
+	double frameMilliseconds = 0.0; // frame start until the next frame starts, swap included
+	double gpuMilliseconds = -1.0; // GPU time of the frame, -1 when timer queries are not supported
+	int drawCalls = 0;
+	int stateChanges = 0;
+	int uniformCalls = 0;
+	long long uploadBytes = 0; // buffer and texture data sent to the GPU, as wide as the GLCounters it adds up
+};
+
+struct PhaseSummary {
+	std::string name;
+	double cpuMilliseconds, gpuMilliseconds; // averages over the run, -1 when not measured
+	double drawCalls, stateChanges, uniformCalls, uploadBytes; // averages per frame
+};
+
+struct TextureSummary {
+	std::string name;
+	long long bytes; // GPU memory at the end of the run, 0 when evicted
+	int references;
+	int loads; // 1, plus one per reload after an eviction
+	int evictions;
+};
+
+struct SampleSummary {
+	double mean, p50, p95, p99, max;
+};
+
+class FrameBenchmark {
+	/* collects one FrameSample per frame of a benchmark run and writes them out with percentile summaries
+	* the first warmupFrames samples are written to the CSV but left out of the summaries (shader and driver warm up)
+	*/
+public:
+	FrameBenchmark(int pFrameCount, int pWarmupFrames);
+
+	void addFrame(const FrameSample& sample);
+	void setGpuTime(int frame, double milliseconds); // GPU times arrive a few frames late
+	void addPhase(const PhaseSummary& phase); // see FrameProfiler
+	void addTexture(const TextureSummary& texture); // see TextureManager
+
+	int getFrameCount() const { return (int)samples.size(); }
+	bool isDone() const { return (int)samples.size() >= frameCount; }
+
+	SampleSummary summarize(double FrameSample::* field) const;
+	SampleSummary summarize(int FrameSample::* field) const;
+	SampleSummary summarize(long long FrameSample::* field) const;
+
+	bool writeCSV(std::string filePath) const;
+	bool writeJSON(std::string filePath, std::string session, std::string renderer, int width, int height) const;
+
+private:
+	int frameCount;
+	int warmupFrames;
+	std::vector<FrameSample> samples;
+	std::vector<PhaseSummary> phases;
+	std::vector<TextureSummary> textures;
+
+	static SampleSummary summarizeValues(std::vector<double> values);
+};
+
+#endif
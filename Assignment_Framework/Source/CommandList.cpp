@@ -0,0 +1,152 @@
+#include "CommandList.hpp"
+#include "GLMetrics.hpp"
+#include <algorithm>
+
+void CommandList::clear() {
+    // keeps the memory, the same lists are recorded again every frame
+    commands.clear();
+    uniformBlocks.clear();
+}
+
+RenderCommand& CommandList::add(uint64_t sortKey, RenderCommandType type) {
+    commands.push_back(RenderCommand());
+    RenderCommand& command = commands.back();
+    command.sortKey = sortKey;
+    command.type = type;
+    return command;
+}
+
+void CommandList::bind(uint64_t sortKey, GLuint vertexArray, GLuint texture, GLenum textureTarget) {
+    RenderCommand& command = add(sortKey, COMMAND_BIND);
+    command.vertexArray = vertexArray;
+    command.texture = texture;
+    command.textureTarget = textureTarget;
+}
+
+void CommandList::setUniformBlock(uint64_t sortKey, const DrawUniforms& uniforms) {
+    add(sortKey, COMMAND_UNIFORM_BLOCK).uniformBlock = (int)uniformBlocks.size();
+    uniformBlocks.push_back(uniforms);
+}
+
+void CommandList::draw(uint64_t sortKey, GLenum mode, GLint first, GLsizei count, GLenum polygonMode) {
+    drawInstanced(sortKey, mode, first, count, 1, polygonMode);
+    commands.back().type = COMMAND_DRAW;
+}
+
+void CommandList::drawInstanced(uint64_t sortKey, GLenum mode, GLint first, GLsizei count, GLsizei instanceCount, GLenum polygonMode) {
+    RenderCommand& command = add(sortKey, COMMAND_DRAW_INSTANCED);
+    command.mode = mode;
+    command.polygonMode = polygonMode;
+    command.first = first;
+    command.count = count;
+    command.instanceCount = instanceCount;
+}
+
+void CommandList::append(const CommandList& other) {
+    int blockOffset = (int)uniformBlocks.size();
+    uniformBlocks.insert(uniformBlocks.end(), other.uniformBlocks.begin(), other.uniformBlocks.end());
+
+    size_t start = commands.size();
+    commands.insert(commands.end(), other.commands.begin(), other.commands.end());
+    for (size_t i = start; i < commands.size(); i++) {
+        if (commands[i].type == COMMAND_UNIFORM_BLOCK)
+            commands[i].uniformBlock += blockOffset;
+    }
+}
+
+void CommandList::sort() {
+    std::stable_sort(commands.begin(), commands.end(), [](const RenderCommand& a, const RenderCommand& b) { return a.sortKey < b.sortKey; });
+}
+
+int CommandList::getDrawCount() const {
+    int draws = 0;
+    for (const RenderCommand& command : commands)
+        draws += command.type == COMMAND_DRAW || command.type == COMMAND_DRAW_INSTANCED;
+    return draws;
+}
+
+void CommandList::execute(GLuint shaderProgram) const {
+    // -1 for the uniforms the program does not have, they are skipped
+    GLint worldMatrixLocation = glGetUniformLocation(shaderProgram, "worldMatrix");
+    GLint colorLocation = glGetUniformLocation(shaderProgram, "material.color");
+    GLint shininessLocation = glGetUniformLocation(shaderProgram, "material.shininess");
+    GLint texWrapXLocation = glGetUniformLocation(shaderProgram, "texWrapX");
+    GLint texWrapYLocation = glGetUniformLocation(shaderProgram, "texWrapY");
+    GLint enableTexturesLocation = glGetUniformLocation(shaderProgram, "enableTextures");
+    GLint textureLayerLocation = glGetUniformLocation(shaderProgram, "textureLayer");
+
+    // what is bound right now, so only the changes are sent (the first bind always is)
+    GLuint vertexArray = 0, texture = 0, textureArray = 0;
+    bool bound = false, arrayBound = false;
+    GLenum polygonMode = GL_FILL;
+    const DrawUniforms* uniforms = NULL;
+    glActiveTexture(GL_TEXTURE0);
+
+    for (const RenderCommand& command : commands) {
+        switch (command.type) {
+        case COMMAND_BIND:
+            if (!bound || command.vertexArray != vertexArray) {
+                glBindVertexArray(command.vertexArray);
+                vertexArray = command.vertexArray;
+            }
+            if (command.textureTarget == GL_TEXTURE_2D_ARRAY) {
+                // the array has its own unit, the 2D texture bound before it stays where it is
+                if (!arrayBound || command.texture != textureArray) {
+                    glActiveTexture(TEXTURE_ARRAY_UNIT);
+                    glBindTexture(GL_TEXTURE_2D_ARRAY, command.texture);
+                    glActiveTexture(GL_TEXTURE0);
+                    textureArray = command.texture;
+                    arrayBound = true;
+                }
+            }
+            else if (!bound || command.texture != texture) {
+                glBindTexture(GL_TEXTURE_2D, command.texture);
+                texture = command.texture;
+            }
+            bound = true;
+            break;
+
+        case COMMAND_UNIFORM_BLOCK: {
+            const DrawUniforms& block = uniformBlocks[command.uniformBlock];
+            if (worldMatrixLocation != -1)
+                glUniformMatrix4fv(worldMatrixLocation, 1, GL_FALSE, &block.worldMatrix[0][0]);
+            if (colorLocation != -1 && (uniforms == NULL || block.materialColor != uniforms->materialColor))
+                glUniform3fv(colorLocation, 1, &block.materialColor[0]);
+            if (shininessLocation != -1 && (uniforms == NULL || block.materialShininess != uniforms->materialShininess))
+                glUniform1f(shininessLocation, block.materialShininess);
+            if (texWrapXLocation != -1 && (uniforms == NULL || block.texWrapX != uniforms->texWrapX))
+                glUniform1f(texWrapXLocation, block.texWrapX);
+            if (texWrapYLocation != -1 && (uniforms == NULL || block.texWrapY != uniforms->texWrapY))
+                glUniform1f(texWrapYLocation, block.texWrapY);
+            if (enableTexturesLocation != -1 && (uniforms == NULL || block.enableTextures != uniforms->enableTextures))
+                glUniform1i(enableTexturesLocation, block.enableTextures);
+            if (textureLayerLocation != -1 && (uniforms == NULL || block.textureLayer != uniforms->textureLayer))
+                glUniform1f(textureLayerLocation, block.textureLayer);
+            uniforms = &block;
+            break;
+        }
+
+        case COMMAND_DRAW:
+        case COMMAND_DRAW_INSTANCED:
+            if (command.polygonMode != polygonMode) {
+                glPolygonMode(GL_FRONT_AND_BACK, command.polygonMode);
+                polygonMode = command.polygonMode;
+            }
+            if (command.type == COMMAND_DRAW)
+                glDrawArrays(command.mode, command.first, command.count);
+            else
+                glDrawArraysInstanced(command.mode, command.first, command.count, command.instanceCount);
+            break;
+        }
+    }
+
+    if (polygonMode != GL_FILL)
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    if (arrayBound) {
+        glActiveTexture(TEXTURE_ARRAY_UNIT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    glBindVertexArray(0);
+}
@@ -0,0 +1,75 @@
+#ifndef COMMAND_LIST_CLASS_H
+#define COMMAND_LIST_CLASS_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// 2D textures are bound on unit 0, the shadow map on unit 1 and texture arrays here, a program samples both kinds
+const GLenum TEXTURE_ARRAY_UNIT = GL_TEXTURE2;
+
+enum RenderCommandType {
+	COMMAND_BIND, // vertex array and texture of the draws that follow
+	COMMAND_UNIFORM_BLOCK, // per draw values, see DrawUniforms
+	COMMAND_DRAW,
+	COMMAND_DRAW_INSTANCED
+};
+
+struct DrawUniforms {
+	// what the scene and shadow shaders take per draw, a program that lacks one of them ignores it
+	glm::mat4 worldMatrix;
+	glm::vec3 materialColor;
+	float materialShininess;
+	float texWrapX, texWrapY;
+	bool enableTextures;
+	float textureLayer; // of the bound texture array, -1 when the texture is a plain 2D one
+};
+
+struct RenderCommand {
+	uint64_t sortKey; // commands with the same key stay in the order they were recorded
+	RenderCommandType type;
+
+	GLuint vertexArray, texture; // COMMAND_BIND
+	GLenum textureTarget; // GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY
+	int uniformBlock; // COMMAND_UNIFORM_BLOCK, index in the list's blocks
+	GLenum mode, polygonMode; // COMMAND_DRAW(_INSTANCED)
+	GLint first;
+	GLsizei count, instanceCount;
+};
+
+class CommandList {
+	/* Draws recorded as plain data instead of GL calls, so any thread can record its part of the scene while only
+	* the thread that owns the context executes them. A draw is recorded as a bind, a uniform block and the draw
+	* itself under one sort key, usually built from what it binds (makeSortKey), so sorting a merged list puts the
+	* draws that share a mesh and a texture next to each other and execute() skips the binds that change nothing.
+	* Models whose textures are layers of one texture array (TextureLoader::createArray) share its bind as well, only
+	* their DrawUniforms::textureLayer differs.
+	*/
+public:
+	void clear();
+
+	void bind(uint64_t sortKey, GLuint vertexArray, GLuint texture, GLenum textureTarget = GL_TEXTURE_2D);
+	void setUniformBlock(uint64_t sortKey, const DrawUniforms& uniforms);
+	void draw(uint64_t sortKey, GLenum mode, GLint first, GLsizei count, GLenum polygonMode = GL_FILL);
+	void drawInstanced(uint64_t sortKey, GLenum mode, GLint first, GLsizei count, GLsizei instanceCount, GLenum polygonMode = GL_FILL);
+
+	void append(const CommandList& other); // for merging the lists recorded by several threads, in a fixed order
+	void sort(); // stable, by sort key
+
+	// runs the commands on the current context with shaderProgram already in use, then unbinds what it bound
+	void execute(GLuint shaderProgram) const;
+
+	int getCommandCount() const { return (int)commands.size(); }
+	int getDrawCount() const;
+
+	static uint64_t makeSortKey(GLuint vertexArray, GLuint texture) { return ((uint64_t)vertexArray << 32) | texture; }
+
+private:
+	std::vector<RenderCommand> commands;
+	std::vector<DrawUniforms> uniformBlocks;
+
+	RenderCommand& add(uint64_t sortKey, RenderCommandType type);
+};
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef CUBE_ROTATION_HEADER
+#define CUBE_ROTATION_HEADER
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include "VoxelGrid.hpp"
+
+/* The player can only turn the shape by 90 degrees about the world axes, so every orientation it can reach is one of
+* the 24 rotations of a cube. Orientations are tracked as an index in that group and every operation on them is a
+* table lookup, the quaternion on the model is only used to animate the turn on screen.
+*
+* A rotation is stored as the signed axis each of the x, y and z axes is sent to (the columns of its matrix):
+* 0 = +x, 1 = -x, 2 = +y, 3 = -y, 4 = +z, 5 = -z
+*/
+
+const int CUBE_ROTATION_COUNT = 24;
+const int IDENTITY_ROTATION = 0;
+
+enum RotationMove { // the six keys that turn the shape, see executeEvents
+	MOVE_W, // positive x axis
+	MOVE_S, // negative x axis
+	MOVE_A, // positive y axis
+	MOVE_D, // negative y axis
+	MOVE_E, // positive z axis
+	MOVE_Q, // negative z axis
+	MOVE_COUNT
+};
+
+struct CubeRotationTables {
+	int columns[CUBE_ROTATION_COUNT][3];
+	int multiply[CUBE_ROTATION_COUNT][CUBE_ROTATION_COUNT]; // multiply[a][b] is the rotation b followed by a
+	int inverse[CUBE_ROTATION_COUNT];
+	int moves[MOVE_COUNT]; // rotation applied by each move
+
+	constexpr CubeRotationTables() : columns(), multiply(), inverse(), moves(), lookup() {
+		for (int i = 0; i < 216; i++)
+			lookup[i] = -1;
+
+		// enumerate the signed permutation matrices with a determinant of +1, +x then +y first so 0 is the identity
+		int count = 0;
+		for (int x = 0; x < 6; x++) {
+			for (int y = 0; y < 6; y++) {
+				if (y / 2 == x / 2)
+					continue;
+				int zAxis = 3 - x / 2 - y / 2;
+				for (int zSign = 0; zSign < 2; zSign++) {
+					int z = 2 * zAxis + zSign;
+					if (determinant(x, y, z) != 1)
+						continue;
+					columns[count][0] = x;
+					columns[count][1] = y;
+					columns[count][2] = z;
+					lookup[code(x, y, z)] = count++;
+				}
+			}
+		}
+
+		for (int a = 0; a < CUBE_ROTATION_COUNT; a++) {
+			for (int b = 0; b < CUBE_ROTATION_COUNT; b++) {
+				int c[3] = {};
+				for (int i = 0; i < 3; i++) // a applied to the axis b sends i to, keeping b's sign
+					c[i] = columns[a][columns[b][i] / 2] ^ (columns[b][i] & 1);
+				multiply[a][b] = lookup[code(c[0], c[1], c[2])];
+			}
+		}
+
+		for (int a = 0; a < CUBE_ROTATION_COUNT; a++) {
+			for (int b = 0; b < CUBE_ROTATION_COUNT; b++) {
+				if (multiply[a][b] == IDENTITY_ROTATION)
+					inverse[a] = b;
+			}
+		}
+
+		// quarter turns matching angleAxis(radians(90.0f), axis) for the axis of each key
+		moves[MOVE_W] = lookup[code(0, 4, 3)];
+		moves[MOVE_S] = lookup[code(0, 5, 2)];
+		moves[MOVE_A] = lookup[code(5, 2, 0)];
+		moves[MOVE_D] = lookup[code(4, 2, 1)];
+		moves[MOVE_E] = lookup[code(2, 1, 4)];
+		moves[MOVE_Q] = lookup[code(3, 0, 4)];
+	}
+
+private:
+	int lookup[216];
+
+	static constexpr int code(int x, int y, int z) { return (x * 6 + y) * 6 + z; }
+
+	static constexpr int determinant(int x, int y, int z) {
+		// sign of the permutation times the sign of every column
+		int ax = x / 2, ay = y / 2, az = z / 2;
+		int inversions = (ax > ay) + (ax > az) + (ay > az);
+		int sign = inversions % 2 == 0 ? 1 : -1;
+		if (x & 1) sign = -sign;
+		if (y & 1) sign = -sign;
+		if (z & 1) sign = -sign;
+		return ax == ay || ay == az || ax == az ? 0 : sign;
+	}
+};
+
+constexpr CubeRotationTables cubeRotations = CubeRotationTables();
+
+static_assert(cubeRotations.multiply[IDENTITY_ROTATION][7] == 7, "rotation 0 has to be the identity");
+static_assert(cubeRotations.multiply[cubeRotations.moves[MOVE_W]][cubeRotations.moves[MOVE_S]] == IDENTITY_ROTATION, "W and S have to undo each other");
+
+inline int applyMove(RotationMove move, int orientation) {
+	// moves turn about the world axes, same as angleAxis(...) * rotationQuat
+	return cubeRotations.multiply[cubeRotations.moves[move]][orientation];
+}
+
+inline int inverseRotation(int orientation) { return cubeRotations.inverse[orientation]; }
+
+inline void getRotationMatrix(int orientation, int out[3][3]) {
+	// rows of the integer rotation matrix, the layout VoxelSet::rotated expects
+	for (int row = 0; row < 3; row++) {
+		for (int col = 0; col < 3; col++) {
+			int column = cubeRotations.columns[orientation][col];
+			out[row][col] = column / 2 != row ? 0 : (column & 1 ? -1 : 1);
+		}
+	}
+}
+
+inline glm::quat getRotationQuat(int orientation) {
+	int matrix[3][3];
+	getRotationMatrix(orientation, matrix);
+
+	glm::mat3 m(1.0f);
+	for (int row = 0; row < 3; row++) {
+		for (int col = 0; col < 3; col++)
+			m[col][row] = (float)matrix[row][col]; // glm matrices are column major
+	}
+	return glm::normalize(glm::quat_cast(m));
+}
+
+inline int getRotationIndex(glm::quat rotation) {
+	/* orientation of an axis aligned quaternion, -1 when the quaternion is not a multiple of 90 degrees about every axis */
+	int matrix[3][3];
+	if (!snapToVoxelRotation(rotation, matrix))
+		return -1;
+
+	for (int i = 0; i < CUBE_ROTATION_COUNT; i++) {
+		int candidate[3][3];
+		getRotationMatrix(i, candidate);
+		bool same = true;
+		for (int row = 0; row < 3; row++) {
+			for (int col = 0; col < 3; col++)
+				same = same && candidate[row][col] == matrix[row][col];
+		}
+		if (same)
+			return i;
+	}
+	return -1;
+}
+
+struct ShapeOccupancy {
+	VoxelSet orientations[CUBE_ROTATION_COUNT]; // voxels of the shape turned into each orientation
+	Bitmask2D wall; // filled cells of the wall built for the shape
+	uint32_t passingOrientations = 0; // bit i is set when orientation i fits through the wall
+};
+
+inline ShapeOccupancy buildShapeOccupancy(const VoxelSet& shape, const Bitmask2D& wall) {
+	/* precomputes the voxels of every orientation of a shape so checking a pass is a single lookup */
+	ShapeOccupancy occupancy;
+	occupancy.wall = wall;
+
+	for (int i = 0; i < CUBE_ROTATION_COUNT; i++) {
+		int matrix[3][3];
+		getRotationMatrix(i, matrix);
+		occupancy.orientations[i] = shape.rotated(matrix);
+
+		if (fitsThroughWall(occupancy.orientations[i], wall))
+			occupancy.passingOrientations |= (uint32_t)1 << i;
+	}
+	return occupancy;
+}
+
+inline bool orientationPasses(const ShapeOccupancy& occupancy, int orientation) {
+	return (occupancy.passingOrientations >> orientation) & 1;
+}
+
+#endif
@@ -0,0 +1,223 @@
+#include "FrameCapture.hpp"
+#include "GLMetrics.hpp"
+#include "ImageWriter.hpp"
+#include "Trace.hpp"
+#include <cstring>
+#include <iostream>
+
+FrameCapture::FrameCapture(int pRingSize, int pMaxQueuedFrames) {
+    ringSize = pRingSize;
+    maxQueuedFrames = pMaxQueuedFrames;
+}
+
+FrameCapture::~FrameCapture() {
+    // no GL here, the context can already be gone
+    stopWriter();
+    if (video != NULL)
+        fclose(video);
+}
+
+bool FrameCapture::openVideo(std::string filePath, int width, int height, int framesPerSecond) {
+    video = fopen(filePath.c_str(), "wb");
+    if (video == NULL) {
+        std::cerr << "Could not create file " << filePath << "." << std::endl;
+        return false;
+    }
+
+    // YUV 4:2:0, BT.601 studio range, square pixels, progressive
+    videoWidth = width;
+    videoHeight = height;
+    fprintf(video, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, framesPerSecond);
+    return true;
+}
+
+void FrameCapture::initialize() {
+    // the buffers are made the first time they are needed since the capture can be declared before the context exists
+    initialized = true;
+    fencesSupported = GLEW_VERSION_3_2 || GLEW_ARB_sync;
+    slots.resize(ringSize);
+    for (Slot& slot : slots)
+        glGenBuffers(1, &slot.buffer);
+}
+
+void FrameCapture::capture(GLuint framebuffer, int width, int height, std::string imagePath, bool toVideo) {
+    TRACE_SCOPE("capture");
+    if (!initialized)
+        initialize();
+
+    // the ring is full, the oldest capture has to come out before its buffer is reused
+    if (pending == ringSize)
+        readSlot(slots[oldest], true);
+
+    Slot& slot = slots[(oldest + pending) % ringSize];
+    int size = width * height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (slot.size != size) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+        slot.size = size;
+    }
+
+    // with a pack buffer bound glReadPixels only queues a copy into it
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (fencesSupported)
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.frame.width = width;
+    slot.frame.height = height;
+    slot.frame.imagePath = imagePath;
+    slot.frame.toVideo = toVideo && video != NULL;
+    pending++;
+}
+
+void FrameCapture::update() {
+    // in capture order, a later copy is never done before an earlier one
+    while (fencesSupported && pending > 0) {
+        GLenum status = glClientWaitSync(slots[oldest].fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        readSlot(slots[oldest], false);
+    }
+}
+
+void FrameCapture::readSlot(Slot& slot, bool wait) {
+    /* maps the oldest capture and hands its pixels to the writer
+    *   wait - the copy may not be done yet, flush the commands and wait for it
+    */
+    if (slot.fence != 0) {
+        if (wait) {
+            TRACE_SCOPE("capture wait");
+            while (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+                ;
+        }
+        glDeleteSync(slot.fence);
+        slot.fence = 0;
+    }
+
+    CapturedFrame frame = slot.frame;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const unsigned char* mapped = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT);
+    if (mapped != NULL) {
+        frame.pixels.assign(mapped, mapped + slot.size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    oldest = (oldest + 1) % ringSize;
+    pending--;
+    if (mapped == NULL) {
+        std::cerr << "Could not map a captured frame" << std::endl;
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(queueMutex);
+    if (!writer.joinable())
+        writer = std::thread(&FrameCapture::writerLoop, this);
+    if (waitForWriter)
+        queueChanged.wait(lock, [this] { return (int)queue.size() < maxQueuedFrames; });
+    else if ((int)queue.size() >= maxQueuedFrames) {
+        droppedFrames++;
+        return;
+    }
+    queue.push_back(std::move(frame));
+    queueChanged.notify_all();
+}
+
+void FrameCapture::finish() {
+    while (pending > 0)
+        readSlot(slots[oldest], true);
+
+    stopWriter();
+    if (video != NULL) {
+        fclose(video);
+        video = NULL;
+    }
+    if (droppedFrames > 0)
+        std::cerr << "Frame capture dropped " << droppedFrames << " frames, the writer could not keep up" << std::endl;
+}
+
+void FrameCapture::stopWriter() {
+    if (!writer.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueChanged.notify_all();
+    writer.join();
+    stopping = false;
+}
+
+void FrameCapture::writerLoop() {
+    traceSetThreadName("frame writer");
+    while (true) {
+        CapturedFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueChanged.wait(lock, [this] { return !queue.empty() || stopping; });
+            if (queue.empty())
+                return; // stopping, and everything queued is written
+            frame = std::move(queue.front());
+            queue.pop_front();
+        }
+        queueChanged.notify_all(); // room for a frame that was waiting
+
+        TRACE_SCOPE("write frame");
+        if (!frame.imagePath.empty())
+            writePNG(frame.imagePath, frame.width, frame.height, &frame.pixels[0], true);
+        if (frame.toVideo)
+            writeVideoFrame(frame);
+        if (isTracing())
+            traceFlush(); // nobody else empties this thread's ring
+    }
+}
+
+void FrameCapture::writeVideoFrame(const CapturedFrame& frame) {
+    // Y4M frames are planar YUV from the top row down, chroma averaged over 2x2 pixels
+    if (frame.width != videoWidth || frame.height != videoHeight) {
+        std::cerr << "Captured frame is " << frame.width << "x" << frame.height << ", the video is " << videoWidth << "x" << videoHeight << std::endl;
+        return;
+    }
+
+    int width = frame.width, height = frame.height;
+    int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+    std::vector<unsigned char> planes(width * height + 2 * chromaWidth * chromaHeight);
+    unsigned char* yPlane = &planes[0];
+    unsigned char* uPlane = yPlane + width * height;
+    unsigned char* vPlane = uPlane + chromaWidth * chromaHeight;
+
+    for (int y = 0; y < height; y++) {
+        const unsigned char* row = &frame.pixels[(size_t)(height - 1 - y) * width * 4];
+        for (int x = 0; x < width; x++) {
+            const unsigned char* pixel = row + x * 4;
+            yPlane[y * width + x] = (unsigned char)(((66 * pixel[0] + 129 * pixel[1] + 25 * pixel[2] + 128) >> 8) + 16);
+        }
+    }
+
+    for (int y = 0; y < chromaHeight; y++) {
+        for (int x = 0; x < chromaWidth; x++) {
+            int r = 0, g = 0, b = 0, count = 0;
+            for (int dy = 0; dy < 2 && 2 * y + dy < height; dy++) {
+                for (int dx = 0; dx < 2 && 2 * x + dx < width; dx++) {
+                    const unsigned char* pixel = &frame.pixels[((size_t)(height - 1 - (2 * y + dy)) * width + 2 * x + dx) * 4];
+                    r += pixel[0];
+                    g += pixel[1];
+                    b += pixel[2];
+                    count++;
+                }
+            }
+            r /= count;
+            g /= count;
+            b /= count;
+            uPlane[y * chromaWidth + x] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            vPlane[y * chromaWidth + x] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+
+    fputs("FRAME\n", video);
+    fwrite(&planes[0], 1, planes.size(), video);
+}
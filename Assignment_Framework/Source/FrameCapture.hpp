@@ -0,0 +1,79 @@
+#ifndef FRAME_CAPTURE_CLASS_H
+#define FRAME_CAPTURE_CLASS_H
+
+#include <GL/glew.h>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct CapturedFrame {
+	int width, height;
+	std::vector<unsigned char> pixels; // RGBA, bottom row first like GL gives them
+	std::string imagePath; // PNG to write, empty for none
+	bool toVideo;
+};
+
+class FrameCapture {
+	/* Screenshots and gameplay capture without stalling the frame.
+	* capture() only queues a glReadPixels into one of a ring of pixel buffer objects and puts a fence after it,
+	* update() (once per frame) maps the buffers whose fence has passed, by then the copy is done and mapping does
+	* not wait. The pixels then go to a writer thread that encodes the PNG stills and the Y4M video.
+	* Frames come out in the order they were captured. When the writer falls more than maxQueuedFrames behind the new
+	* frames are dropped rather than making the game wait (unless waitForWriter), finish() reports how many.
+	* Without fences (before GL 3.2) a buffer is only read when the ring comes back around to it.
+	*/
+public:
+	FrameCapture(int pRingSize = 3, int pMaxQueuedFrames = 16);
+	~FrameCapture(); // stops the writer thread, call finish() first to write what is still in flight
+
+	bool openVideo(std::string filePath, int width, int height, int framesPerSecond); // every frame captured toVideo goes to it
+	bool hasVideo() const { return video != NULL; }
+
+	// reads the whole framebuffer (0 for the window's back buffer, so before the swap)
+	void capture(GLuint framebuffer, int width, int height, std::string imagePath, bool toVideo);
+	void update();
+	void finish(); // waits for the GPU and the writer, then closes the video
+
+	int getDroppedFrames() const { return droppedFrames; }
+
+	bool waitForWriter = false; // wait instead of dropping frames, for offscreen runs where the video must have every frame
+
+private:
+	struct Slot {
+		GLuint buffer = 0;
+		GLsync fence = 0;
+		int size = 0; // bytes allocated for the buffer
+		CapturedFrame frame; // everything but the pixels until it is read back
+	};
+
+	int ringSize;
+	int maxQueuedFrames;
+	bool initialized = false;
+	bool fencesSupported = false;
+	std::vector<Slot> slots;
+	int oldest = 0; // slot of the oldest capture still on the GPU
+	int pending = 0; // captures still on the GPU
+	int droppedFrames = 0;
+
+	FILE* video = NULL;
+	int videoWidth = 0, videoHeight = 0;
+
+	// writer thread, only what is below the mutex is shared with it
+	std::thread writer;
+	std::mutex queueMutex;
+	std::condition_variable queueChanged;
+	std::deque<CapturedFrame> queue;
+	bool stopping = false;
+
+	void initialize();
+	void readSlot(Slot& slot, bool wait);
+	void stopWriter();
+	void writerLoop();
+	void writeVideoFrame(const CapturedFrame& frame);
+};
+
+#endif
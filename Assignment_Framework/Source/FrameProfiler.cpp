@@ -0,0 +1,88 @@
+#include "FrameProfiler.hpp"
+#include <cstdio>
+
+int FrameProfiler::addScope(std::string name) {
+    ProfileScope scope;
+    scope.name = name;
+    scopes.push_back(scope);
+    gpuTimers.push_back(std::unique_ptr<GpuTimer>(new GpuTimer()));
+    starts.push_back(Clock::now());
+    glStarts.push_back(GLCounters());
+    open.push_back(false);
+    traceNames.push_back(traceIntern(name));
+    return (int)scopes.size() - 1;
+}
+
+int FrameProfiler::findScope(std::string name) const {
+    for (size_t i = 0; i < scopes.size(); i++) {
+        if (scopes[i].name == name)
+            return (int)i;
+    }
+    return -1;
+}
+
+void FrameProfiler::begin(int scope) {
+    traceBegin(traceNames[scope]); // the trace gets every phase even while the overlay is off
+    if (!enabled)
+        return;
+
+    open[scope] = true;
+    gpuTimers[scope]->begin();
+    starts[scope] = Clock::now();
+    glStarts[scope] = glMetrics();
+}
+
+void FrameProfiler::end(int scope) {
+    traceEnd(traceNames[scope]);
+    if (!open[scope])
+        return;
+
+    open[scope] = false;
+    scopes[scope].cpu.add(std::chrono::duration<double, std::milli>(Clock::now() - starts[scope]).count());
+    scopes[scope].gl = glMetrics() - glStarts[scope];
+    scopes[scope].glTotal += scopes[scope].gl;
+    gpuTimers[scope]->end();
+}
+
+void FrameProfiler::addCpuTime(int scope, double milliseconds) {
+    if (enabled)
+        scopes[scope].cpu.add(milliseconds);
+}
+
+void FrameProfiler::collect(bool wait) {
+    // keeps reading after the profiler is disabled so the spans already in flight are not lost
+    for (size_t i = 0; i < scopes.size(); i++) {
+        int span;
+        double milliseconds;
+        while (wait ? gpuTimers[i]->collectBlocking(span, milliseconds) : gpuTimers[i]->collect(span, milliseconds))
+            scopes[i].gpu.add(milliseconds);
+    }
+}
+
+void FrameProfiler::release() {
+    for (std::unique_ptr<GpuTimer>& timer : gpuTimers)
+        timer->release();
+}
+
+std::string FrameProfiler::getReport() const {
+    std::string report = "cpu / gpu ms - draws binds uniforms\n";
+    char line[128];
+    for (const ProfileScope& scope : scopes) {
+        double gpu = scope.gpu.getAverage();
+        if (gpu < 0.0)
+            snprintf(line, sizeof(line), "%s: %.2f / - - %d %d %d\n", scope.name.c_str(), scope.cpu.getAverage(),
+                scope.gl.drawCalls, scope.gl.stateChanges, scope.gl.uniformCalls);
+        else
+            snprintf(line, sizeof(line), "%s: %.2f / %.2f - %d %d %d\n", scope.name.c_str(), scope.cpu.getAverage(), gpu,
+                scope.gl.drawCalls, scope.gl.stateChanges, scope.gl.uniformCalls);
+        report += line;
+    }
+
+    // the overlay is drawn before the frame ends, so the totals are the previous frame's
+    const GLCounters& frame = glLastFrameMetrics();
+    snprintf(line, sizeof(line), "frame: %d draws %d binds %d uniforms\n", frame.drawCalls, frame.stateChanges, frame.uniformCalls);
+    report += line;
+    snprintf(line, sizeof(line), "uploads: %lld kb buffers %lld kb textures\n", frame.bufferBytes / 1024, frame.textureBytes / 1024);
+    report += line;
+    return report;
+}
@@ -0,0 +1,80 @@
+#ifndef FRAME_PROFILER_CLASS_H
+#define FRAME_PROFILER_CLASS_H
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "GLMetrics.hpp"
+#include "GpuTimer.hpp"
+#include "Trace.hpp"
+
+const int PROFILER_HISTORY = 60; // frames in the rolling averages
+
+struct RollingAverage {
+	/* mean of the last PROFILER_HISTORY values, plus the mean of everything since the start for benchmarks */
+	double values[PROFILER_HISTORY] = {};
+	int count = 0;
+	double total = 0.0;
+	int totalCount = 0;
+
+	void add(double value) {
+		values[count++ % PROFILER_HISTORY] = value;
+		total += value;
+		totalCount++;
+	}
+
+	double getAverage() const {
+		int size = count < PROFILER_HISTORY ? count : PROFILER_HISTORY;
+		double sum = 0.0;
+		for (int i = 0; i < size; i++)
+			sum += values[i];
+		return size == 0 ? -1.0 : sum / size;
+	}
+
+	double getRunAverage() const { return totalCount == 0 ? -1.0 : total / totalCount; }
+};
+
+struct ProfileScope {
+	std::string name;
+	RollingAverage cpu; // milliseconds between begin and end on the CPU
+	RollingAverage gpu; // milliseconds the GPU spent on the commands issued between begin and end
+	GLCounters gl; // GL calls made between begin and end, the last time the scope ran
+	GLCounters glTotal; // summed over every time it ran, cpu.totalCount times
+};
+
+class FrameProfiler {
+	/* CPU and GPU time and GL calls (see GLMetrics.hpp) of the phases of a frame (shadow pass, scene, skybox, text...)
+	* phases are registered once with addScope, then every frame wrapped in begin(scope) / end(scope),
+	* collect() once per frame picks up the GPU times that are ready, they are a few frames behind the CPU ones
+	* scopes must not nest in themselves but different scopes can overlap
+	*/
+public:
+	int addScope(std::string name);
+
+	void begin(int scope);
+	void end(int scope);
+	void addCpuTime(int scope, double milliseconds); // for a phase measured on another thread, it has no GPU time or GL calls
+	void collect(bool wait = false); // wait for the GPU to finish everything measured, for the end of a benchmark
+	void release(); // deletes the GPU timers' queries, before the context goes
+
+	int getScopeCount() const { return (int)scopes.size(); }
+	const ProfileScope& getScope(int scope) const { return scopes[scope]; }
+	int findScope(std::string name) const; // -1 when there is no scope with that name
+
+	std::string getReport() const; // one line per scope with the rolling averages and GL calls, then the whole frame, for the overlay
+
+	bool enabled = true; // begin and end do nothing when false
+
+private:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	std::vector<ProfileScope> scopes;
+	std::vector<std::unique_ptr<GpuTimer> > gpuTimers; // GpuTimer owns GL queries so it is not copied around
+	std::vector<Clock::time_point> starts;
+	std::vector<GLCounters> glStarts; // glMetrics() when the scope began
+	std::vector<bool> open; // begin was called and end was not yet, end is ignored otherwise
+	std::vector<const char*> traceNames; // the scope names as trace event names
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef FRAME_STATE_CLASS_H
+#define FRAME_STATE_CLASS_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <utility>
+
+const int PEPE_COUNT = 6;
+
+struct FrameState {
+	/* everything the render thread needs to draw a frame, filled in by the main thread (simulation, input, effects)
+	* and not touched by it again once published, so the two threads never share the game itself.
+	* One off events are counts since the start rather than flags: the renderer skips the states published while it
+	* was busy and would miss a flag set in one of them, a count that went up is seen in the next state it draws.
+	*/
+	int frameNumber = 0;
+	bool last = false; // the render thread stops after drawing it
+	double simulationMilliseconds = 0.0; // main thread time spent making the state, for the profiler
+
+	int width = 0, height = 0; // of the window or the render target
+
+	glm::vec3 cameraPosition, cameraOrientation, cameraUp;
+	float cameraFOV = 90.0f;
+
+	int currentShape = 0; // the shape and wall models are rebuilt when it changes
+	glm::vec3 shapePosition;
+	glm::quat shapeRotation;
+	glm::quat pepeRotations[PEPE_COUNT];
+
+	glm::vec3 mainLightColor, pepeLightColor;
+
+	bool enableShadows = true, enableTextures = true, showProfiler = false;
+
+	bool gameRunning = true;
+	std::string timeText, scoreText, hintText; // hintText is empty when the hint is hidden
+	int scoreFlashes = 0, timeFlashes = 0, screenshots = 0;
+};
+
+class FrameMailbox {
+	/* Hands FrameStates from the main thread to the render thread. There are three of them: the one the main thread
+	* is filling, the one the render thread is drawing and the latest published one in between, so publishing and
+	* picking a state up only swap indices under the lock and neither thread waits for the other to finish a frame.
+	* The render thread always gets the newest state and skips the ones published while it was drawing.
+	* In lockstep (fixed step runs, where every simulated frame has to be drawn) publish() instead waits until the
+	* previous state was picked up, the threads still work on two consecutive frames at the same time.
+	* The writer's state holds whatever was in it three frames ago, every field has to be filled in again.
+	*/
+public:
+	FrameMailbox(bool pLockstep) : lockstep(pLockstep) {}
+
+	FrameState& getWriteState() { return states[writing]; }
+
+	bool publish() {
+		// false once the mailbox is closed, the state was not handed over
+		std::unique_lock<std::mutex> lock(mutex);
+		if (lockstep)
+			changed.wait(lock, [this] { return !fresh || closed; });
+		if (closed)
+			return false;
+		std::swap(writing, ready);
+		fresh = true;
+		changed.notify_all();
+		return true;
+	}
+
+	const FrameState* acquire() {
+		// waits for a state newer than the last one, NULL once the mailbox is closed and the last state was drawn
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait(lock, [this] { return fresh || closed; });
+		if (!fresh)
+			return NULL;
+		std::swap(reading, ready);
+		fresh = false;
+		changed.notify_all();
+		return &states[reading];
+	}
+
+	void close() {
+		// either thread can close it, the other one stops at its next publish or acquire
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+		changed.notify_all();
+	}
+
+private:
+	FrameState states[3];
+	int writing = 0, ready = 1, reading = 2;
+	bool fresh = false; // states[ready] was published and not picked up yet
+	bool closed = false;
+	bool lockstep;
+
+	std::mutex mutex;
+	std::condition_variable changed;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef GL_DISPATCH_HEADER
+#define GL_DISPATCH_HEADER
+
+#include <GL/glew.h>
+
+/* The GL 1.1 functions the game calls are not GLEW pointers like the later ones, they are linked directly, so they
+* cannot be swapped for other versions the way installNullGL() and the trace recorder (GLTrace.hpp) swap the GLEW
+* entry points. Including this header sends them through this table instead, which starts out pointing at the
+* driver's and is changed along with the GLEW pointers. GLMetrics.hpp includes it.
+* Like the GLEW pointers it is only changed before the frames start, while nothing else is calling GL.
+*/
+
+struct GL11Functions {
+	void (GLAPIENTRY *bindTexture)(GLenum target, GLuint texture) = glBindTexture;
+	void (GLAPIENTRY *clear)(GLbitfield mask) = glClear;
+	void (GLAPIENTRY *clearColor)(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha) = glClearColor;
+	void (GLAPIENTRY *deleteTextures)(GLsizei n, const GLuint* textures) = glDeleteTextures;
+	void (GLAPIENTRY *drawArrays)(GLenum mode, GLint first, GLsizei count) = glDrawArrays;
+	void (GLAPIENTRY *drawBuffer)(GLenum mode) = glDrawBuffer;
+	void (GLAPIENTRY *enable)(GLenum cap) = glEnable;
+	void (GLAPIENTRY *finish)() = glFinish;
+	void (GLAPIENTRY *genTextures)(GLsizei n, GLuint* textures) = glGenTextures;
+	const GLubyte* (GLAPIENTRY *getString)(GLenum name) = glGetString;
+	void (GLAPIENTRY *pixelStorei)(GLenum pname, GLint param) = glPixelStorei;
+	void (GLAPIENTRY *polygonMode)(GLenum face, GLenum mode) = glPolygonMode;
+	void (GLAPIENTRY *readBuffer)(GLenum mode) = glReadBuffer;
+	void (GLAPIENTRY *readPixels)(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels) = glReadPixels;
+	void (GLAPIENTRY *texImage2D)(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border,
+		GLenum format, GLenum type, const void* pixels) = glTexImage2D;
+	void (GLAPIENTRY *texParameteri)(GLenum target, GLenum pname, GLint param) = glTexParameteri;
+	void (GLAPIENTRY *viewport)(GLint x, GLint y, GLsizei width, GLsizei height) = glViewport;
+};
+
+inline GL11Functions& gl11() {
+	static GL11Functions functions;
+	return functions;
+}
+
+#define glBindTexture gl11().bindTexture
+#define glClear gl11().clear
+#define glClearColor gl11().clearColor
+#define glDeleteTextures gl11().deleteTextures
+#define glDrawArrays gl11().drawArrays
+#define glDrawBuffer gl11().drawBuffer
+#define glEnable gl11().enable
+#define glFinish gl11().finish
+#define glGenTextures gl11().genTextures
+#define glGetString gl11().getString
+#define glPixelStorei gl11().pixelStorei
+#define glPolygonMode gl11().polygonMode
+#define glReadBuffer gl11().readBuffer
+#define glReadPixels gl11().readPixels
+#define glTexImage2D gl11().texImage2D
+#define glTexParameteri gl11().texParameteri
+#define glViewport gl11().viewport
+
+#endif
@@ -0,0 +1,236 @@
+#ifndef GL_METRICS_HEADER
+#define GL_METRICS_HEADER
+
+#include <GL/glew.h>
+#include "GLDispatch.hpp" // the GL 1.1 calls below go through its table
+
+/* Counts the GL calls that cost the most on the CPU side of the driver, and the bytes sent to the GPU. Including
+* this header after GLEW swaps the calls below for versions that bump a counter first, so the code that draws does
+* not change.
+* Only calls made in files that include this header are counted, an image read from a pixel unpack buffer is only
+* counted when the buffer was bound in one of them too.
+*/
+
+struct GLCounters {
+	int drawCalls = 0;
+	long long vertices = 0; // vertices submitted by the draw calls
+	int stateChanges = 0; // program, VAO, buffer, texture and framebuffer binds
+	int uniformCalls = 0;
+	long long uniformBytes = 0;
+	int bufferUploads = 0; // glBufferData and glBufferSubData calls
+	long long bufferBytes = 0;
+	int textureUploads = 0; // glTexImage2D and glTexImage3D calls
+	long long textureBytes = 0; // only the images that were given pixels, a NULL image without an unpack buffer only allocates
+
+	void reset() { *this = GLCounters(); }
+
+	GLCounters& operator+=(const GLCounters& other) {
+		drawCalls += other.drawCalls;
+		vertices += other.vertices;
+		stateChanges += other.stateChanges;
+		uniformCalls += other.uniformCalls;
+		uniformBytes += other.uniformBytes;
+		bufferUploads += other.bufferUploads;
+		bufferBytes += other.bufferBytes;
+		textureUploads += other.textureUploads;
+		textureBytes += other.textureBytes;
+		return *this;
+	}
+
+	GLCounters operator-(const GLCounters& other) const {
+		// calls made between two readings of the counters
+		GLCounters difference;
+		difference.drawCalls = drawCalls - other.drawCalls;
+		difference.vertices = vertices - other.vertices;
+		difference.stateChanges = stateChanges - other.stateChanges;
+		difference.uniformCalls = uniformCalls - other.uniformCalls;
+		difference.uniformBytes = uniformBytes - other.uniformBytes;
+		difference.bufferUploads = bufferUploads - other.bufferUploads;
+		difference.bufferBytes = bufferBytes - other.bufferBytes;
+		difference.textureUploads = textureUploads - other.textureUploads;
+		difference.textureBytes = textureBytes - other.textureBytes;
+		return difference;
+	}
+};
+
+struct GLFrameCounters {
+	GLCounters current; // since the frame started
+	GLCounters lastFrame; // the whole previous frame, for displays drawn before the current one is done
+};
+
+inline GLFrameCounters& glFrameCounters() {
+	static GLFrameCounters counters; // one set for the whole program, whatever translation unit counts into it
+	return counters;
+}
+
+inline GLCounters& glMetrics() { return glFrameCounters().current; }
+
+inline const GLCounters& glLastFrameMetrics() { return glFrameCounters().lastFrame; }
+
+inline GLuint& glUnpackBuffer() {
+	// bound to GL_PIXEL_UNPACK_BUFFER through countedBindBuffer, an image pointer is then an offset in it and NULL its start
+	static GLuint buffer = 0;
+	return buffer;
+}
+
+inline bool glImageHasPixels(const void* pixels) { return pixels != NULL || glUnpackBuffer() != 0; }
+
+inline void glMetricsEndFrame() {
+	// call once at the start of every frame
+	glFrameCounters().lastFrame = glFrameCounters().current;
+	glFrameCounters().current.reset();
+}
+
+inline int glTexelBytes(GLenum format, GLenum type) {
+	int components;
+	switch (format) {
+	case GL_RG: components = 2; break;
+	case GL_RGB: case GL_BGR: components = 3; break;
+	case GL_RGBA: case GL_BGRA: components = 4; break;
+	default: components = 1; break; // GL_RED, GL_DEPTH_COMPONENT...
+	}
+
+	switch (type) {
+	case GL_UNSIGNED_BYTE: case GL_BYTE: return components;
+	case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: return components * 2;
+	default: return components * 4; // GL_FLOAT, GL_UNSIGNED_INT...
+	}
+}
+
+inline void countedDrawArrays(GLenum mode, GLint first, GLsizei count) {
+	glMetrics().drawCalls++;
+	glMetrics().vertices += count;
+	glDrawArrays(mode, first, count);
+}
+
+inline void countedDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount) {
+	glMetrics().drawCalls++;
+	glMetrics().vertices += (long long)count * instanceCount;
+	glDrawArraysInstanced(mode, first, count, instanceCount);
+}
+
+inline void countedUseProgram(GLuint program) {
+	glMetrics().stateChanges++;
+	glUseProgram(program);
+}
+
+inline void countedBindVertexArray(GLuint array) {
+	glMetrics().stateChanges++;
+	glBindVertexArray(array);
+}
+
+inline void countedBindBuffer(GLenum target, GLuint buffer) {
+	glMetrics().stateChanges++;
+	if (target == GL_PIXEL_UNPACK_BUFFER)
+		glUnpackBuffer() = buffer;
+	glBindBuffer(target, buffer);
+}
+
+inline void countedBindTexture(GLenum target, GLuint texture) {
+	glMetrics().stateChanges++;
+	glBindTexture(target, texture);
+}
+
+inline void countedBindFramebuffer(GLenum target, GLuint framebuffer) {
+	glMetrics().stateChanges++;
+	glBindFramebuffer(target, framebuffer);
+}
+
+inline void countUniform(long long bytes) {
+	glMetrics().uniformCalls++;
+	glMetrics().uniformBytes += bytes;
+}
+
+inline void countedUniform1i(GLint location, GLint value) {
+	countUniform(sizeof(GLint));
+	glUniform1i(location, value);
+}
+
+inline void countedUniform1f(GLint location, GLfloat value) {
+	countUniform(sizeof(GLfloat));
+	glUniform1f(location, value);
+}
+
+inline void countedUniform3fv(GLint location, GLsizei count, const GLfloat* value) {
+	countUniform(count * 3 * sizeof(GLfloat));
+	glUniform3fv(location, count, value);
+}
+
+inline void countedUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+	countUniform(count * 16 * sizeof(GLfloat));
+	glUniformMatrix4fv(location, count, transpose, value);
+}
+
+inline void countedBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+	glMetrics().bufferUploads++;
+	if (data != NULL)
+		glMetrics().bufferBytes += size;
+	glBufferData(target, size, data, usage);
+}
+
+inline void countedBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+	glMetrics().bufferUploads++;
+	glMetrics().bufferBytes += size;
+	glBufferSubData(target, offset, size, data);
+}
+
+inline void countedTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border,
+	GLenum format, GLenum type, const void* pixels) {
+	glMetrics().textureUploads++;
+	if (glImageHasPixels(pixels))
+		glMetrics().textureBytes += (long long)width * height * glTexelBytes(format, type);
+	glTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+}
+
+inline void countedCompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLint border,
+	GLsizei imageSize, const void* data) {
+	glMetrics().textureUploads++;
+	if (glImageHasPixels(data))
+		glMetrics().textureBytes += imageSize;
+	glCompressedTexImage2D(target, level, internalFormat, width, height, border, imageSize, data);
+}
+
+inline void countedTexImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth, GLint border,
+	GLenum format, GLenum type, const void* pixels) {
+	glMetrics().textureUploads++;
+	if (glImageHasPixels(pixels))
+		glMetrics().textureBytes += (long long)width * height * depth * glTexelBytes(format, type);
+	glTexImage3D(target, level, internalFormat, width, height, depth, border, format, type, pixels);
+}
+
+// GLEW already defines the extension entry points as macros and GLDispatch.hpp the GL 1.1 ones, they have to go before they can be replaced
+#undef glDrawArrays
+#undef glBindTexture
+#undef glTexImage2D
+#undef glCompressedTexImage2D
+#undef glTexImage3D
+#undef glUseProgram
+#undef glBindVertexArray
+#undef glBindBuffer
+#undef glBindFramebuffer
+#undef glUniform1i
+#undef glUniform1f
+#undef glUniform3fv
+#undef glUniformMatrix4fv
+#undef glBufferData
+#undef glBufferSubData
+#undef glDrawArraysInstanced
+
+#define glDrawArrays countedDrawArrays
+#define glDrawArraysInstanced countedDrawArraysInstanced
+#define glUseProgram countedUseProgram
+#define glBindVertexArray countedBindVertexArray
+#define glBindBuffer countedBindBuffer
+#define glBindTexture countedBindTexture
+#define glBindFramebuffer countedBindFramebuffer
+#define glUniform1i countedUniform1i
+#define glUniform1f countedUniform1f
+#define glUniform3fv countedUniform3fv
+#define glUniformMatrix4fv countedUniformMatrix4fv
+#define glBufferData countedBufferData
+#define glBufferSubData countedBufferSubData
+#define glTexImage2D countedTexImage2D
+#define glCompressedTexImage2D countedCompressedTexImage2D
+#define glTexImage3D countedTexImage3D
+
+#endif
@@ -0,0 +1,955 @@
+#include "GLTrace.hpp"
+#include "GLMetrics.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+const size_t FLUSH_BYTES = 1024 * 1024; // the commands are written out at the start of the first frame past this
+
+struct TraceMapping {
+    unsigned char* pointer;
+    GLsizeiptr length;
+    bool written; // mapped for writing, what is in it is saved at the unmap
+};
+
+struct GLTraceRecorder {
+    FILE* file = NULL;
+    std::string filePath;
+    GLTraceHeader header;
+    std::vector<unsigned char> commands; // not written to the file yet
+    bool recording = false;
+    int frames = 0; // to record, 0 for all of them
+
+    // what tells how much data is behind the pointers the calls get
+    std::unordered_map<GLenum, GLuint> boundBuffers; // by target
+    std::unordered_map<GLuint, TraceMapping> mappings; // by buffer
+    GLint unpackAlignment = 4;
+};
+
+struct GLTraceNext {
+    // what the entry points pointed at before the recorder, the calls go on to them
+    PFNGLGENBUFFERSPROC genBuffers;
+    PFNGLBINDBUFFERPROC bindBuffer;
+    PFNGLBUFFERDATAPROC bufferData;
+    PFNGLBUFFERSUBDATAPROC bufferSubData;
+    PFNGLBUFFERSTORAGEPROC bufferStorage;
+    PFNGLMAPBUFFERRANGEPROC mapBufferRange;
+    PFNGLUNMAPBUFFERPROC unmapBuffer;
+    PFNGLDELETEBUFFERSPROC deleteBuffers;
+
+    PFNGLGENVERTEXARRAYSPROC genVertexArrays;
+    PFNGLBINDVERTEXARRAYPROC bindVertexArray;
+    PFNGLVERTEXATTRIBPOINTERPROC vertexAttribPointer;
+    PFNGLENABLEVERTEXATTRIBARRAYPROC enableVertexAttribArray;
+    PFNGLVERTEXATTRIBDIVISORPROC vertexAttribDivisor;
+    PFNGLDRAWARRAYSINSTANCEDPROC drawArraysInstanced;
+
+    PFNGLCREATESHADERPROC createShader;
+    PFNGLSHADERSOURCEPROC shaderSource;
+    PFNGLCOMPILESHADERPROC compileShader;
+    PFNGLDELETESHADERPROC deleteShader;
+    PFNGLCREATEPROGRAMPROC createProgram;
+    PFNGLATTACHSHADERPROC attachShader;
+    PFNGLLINKPROGRAMPROC linkProgram;
+    PFNGLUSEPROGRAMPROC useProgram;
+    PFNGLGETUNIFORMLOCATIONPROC getUniformLocation;
+    PFNGLUNIFORM1IPROC uniform1i;
+    PFNGLUNIFORM1FPROC uniform1f;
+    PFNGLUNIFORM3FVPROC uniform3fv;
+    PFNGLUNIFORMMATRIX4FVPROC uniformMatrix4fv;
+
+    PFNGLACTIVETEXTUREPROC activeTexture;
+    PFNGLGENERATEMIPMAPPROC generateMipmap;
+    PFNGLCOMPRESSEDTEXIMAGE2DPROC compressedTexImage2D;
+    PFNGLTEXIMAGE3DPROC texImage3D;
+    PFNGLGENFRAMEBUFFERSPROC genFramebuffers;
+    PFNGLBINDFRAMEBUFFERPROC bindFramebuffer;
+    PFNGLFRAMEBUFFERTEXTUREPROC framebufferTexture;
+    PFNGLFRAMEBUFFERRENDERBUFFERPROC framebufferRenderbuffer;
+    PFNGLCHECKFRAMEBUFFERSTATUSPROC checkFramebufferStatus;
+    PFNGLDELETEFRAMEBUFFERSPROC deleteFramebuffers;
+    PFNGLGENRENDERBUFFERSPROC genRenderbuffers;
+    PFNGLBINDRENDERBUFFERPROC bindRenderbuffer;
+    PFNGLRENDERBUFFERSTORAGEPROC renderbufferStorage;
+    PFNGLDELETERENDERBUFFERSPROC deleteRenderbuffers;
+
+    PFNGLGENQUERIESPROC genQueries;
+    PFNGLQUERYCOUNTERPROC queryCounter;
+    PFNGLGETQUERYOBJECTIVPROC getQueryObjectiv;
+    PFNGLGETQUERYOBJECTUI64VPROC getQueryObjectui64v;
+    PFNGLFENCESYNCPROC fenceSync;
+    PFNGLCLIENTWAITSYNCPROC clientWaitSync;
+    PFNGLDELETESYNCPROC deleteSync;
+
+    GL11Functions gl11;
+};
+
+static GLTraceRecorder recorder;
+static GLTraceNext next;
+
+//////////////////////////////////////////////// WRITING ////////////////////////////////////////////////
+
+template <typename T>
+static void put(T value) {
+    size_t at = recorder.commands.size();
+    recorder.commands.resize(at + sizeof(T));
+    memcpy(&recorder.commands[at], &value, sizeof(T));
+}
+
+static void putCommand(GLTraceCommand command) {
+    put((unsigned char)command);
+}
+
+static void putSize(long long size) {
+    // GLsizeiptr, GLintptr and pointers change size with the platform, the file does not
+    put(size);
+}
+
+static void putData(const void* data, size_t size) {
+    put((unsigned int)size);
+    if (size > 0)
+        recorder.commands.insert(recorder.commands.end(), (const unsigned char*)data, (const unsigned char*)data + size);
+}
+
+static void putOptionalData(const void* data, size_t size) {
+    // a NULL pointer (allocate only) is not the same as no bytes
+    put((unsigned char)(data != NULL));
+    if (data != NULL)
+        putData(data, size);
+}
+
+static void putNames(GLsizei n, const GLuint* names) {
+    put((int)n);
+    for (GLsizei i = 0; i < n; i++)
+        put(names[i]);
+}
+
+static void putSync(GLsync sync) {
+    put((unsigned long long)(uintptr_t)sync);
+}
+
+static bool flush() {
+    // the header keeps the count of frames in the file up to date, a trace cut short by a crash still plays
+    bool ok = fwrite(recorder.commands.data(), 1, recorder.commands.size(), recorder.file) == recorder.commands.size();
+    recorder.commands.clear();
+    long end = ftell(recorder.file);
+    ok = ok && fseek(recorder.file, 0, SEEK_SET) == 0 && fwrite(&recorder.header, sizeof(GLTraceHeader), 1, recorder.file) == 1;
+    ok = ok && fseek(recorder.file, end, SEEK_SET) == 0 && fflush(recorder.file) == 0;
+    if (!ok) {
+        std::cerr << "Could not write the GL trace " << recorder.filePath << ", recording stopped" << std::endl;
+        fclose(recorder.file);
+        recorder.file = NULL;
+        recorder.recording = false;
+    }
+    return ok;
+}
+
+static bool recording() {
+    return recorder.recording;
+}
+
+static GLuint boundBuffer(GLenum target) {
+    std::unordered_map<GLenum, GLuint>::iterator bound = recorder.boundBuffers.find(target);
+    return bound == recorder.boundBuffers.end() ? 0 : bound->second;
+}
+
+//////////////////////////////////////////////// BUFFERS ////////////////////////////////////////////////
+
+static void GLAPIENTRY traceGenBuffers(GLsizei n, GLuint* buffers) {
+    next.genBuffers(n, buffers);
+    if (recording()) {
+        putCommand(TRACE_GEN_BUFFERS);
+        putNames(n, buffers);
+    }
+}
+
+static void GLAPIENTRY traceBindBuffer(GLenum target, GLuint buffer) {
+    next.bindBuffer(target, buffer);
+    if (recording()) {
+        recorder.boundBuffers[target] = buffer;
+        putCommand(TRACE_BIND_BUFFER);
+        put(target);
+        put(buffer);
+    }
+}
+
+static void GLAPIENTRY traceBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    next.bufferData(target, size, data, usage);
+    if (recording()) {
+        putCommand(TRACE_BUFFER_DATA);
+        put(target);
+        putSize(size);
+        putOptionalData(data, size);
+        put(usage);
+    }
+}
+
+static void GLAPIENTRY traceBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    next.bufferSubData(target, offset, size, data);
+    if (recording()) {
+        putCommand(TRACE_BUFFER_SUB_DATA);
+        put(target);
+        putSize(offset);
+        putData(data, size);
+    }
+}
+
+static void GLAPIENTRY traceBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) {
+    next.bufferStorage(target, size, data, flags);
+    if (recording()) {
+        putCommand(TRACE_BUFFER_STORAGE);
+        put(target);
+        putSize(size);
+        putOptionalData(data, size);
+        put(flags);
+    }
+}
+
+static void* GLAPIENTRY traceMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    void* pointer = next.mapBufferRange(target, offset, length, access);
+    if (recording() && pointer != NULL) {
+        TraceMapping mapping = { (unsigned char*)pointer, length, (access & GL_MAP_WRITE_BIT) != 0 };
+        recorder.mappings[boundBuffer(target)] = mapping;
+        putCommand(TRACE_MAP_BUFFER_RANGE);
+        put(target);
+        putSize(offset);
+        putSize(length);
+        put(access);
+    }
+    return pointer;
+}
+
+static GLboolean GLAPIENTRY traceUnmapBuffer(GLenum target) {
+    // before the memory goes away
+    if (recording()) {
+        std::unordered_map<GLuint, TraceMapping>::iterator mapping = recorder.mappings.find(boundBuffer(target));
+        bool written = mapping != recorder.mappings.end() && mapping->second.written;
+        putCommand(TRACE_UNMAP_BUFFER);
+        put(target);
+        putOptionalData(written ? mapping->second.pointer : NULL, written ? mapping->second.length : 0);
+        if (mapping != recorder.mappings.end())
+            recorder.mappings.erase(mapping);
+    }
+    return next.unmapBuffer(target);
+}
+
+static void GLAPIENTRY traceDeleteBuffers(GLsizei n, const GLuint* buffers) {
+    next.deleteBuffers(n, buffers);
+    if (recording()) {
+        for (GLsizei i = 0; i < n; i++)
+            recorder.mappings.erase(buffers[i]);
+        putCommand(TRACE_DELETE_BUFFERS);
+        putNames(n, buffers);
+    }
+}
+
+//////////////////////////////////////////////// VERTEX ARRAYS ////////////////////////////////////////////////
+
+static void GLAPIENTRY traceGenVertexArrays(GLsizei n, GLuint* arrays) {
+    next.genVertexArrays(n, arrays);
+    if (recording()) {
+        putCommand(TRACE_GEN_VERTEX_ARRAYS);
+        putNames(n, arrays);
+    }
+}
+
+static void GLAPIENTRY traceBindVertexArray(GLuint array) {
+    next.bindVertexArray(array);
+    if (recording()) {
+        putCommand(TRACE_BIND_VERTEX_ARRAY);
+        put(array);
+    }
+}
+
+static void GLAPIENTRY traceVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer) {
+    // the core profile has no client arrays, the pointer is an offset in the bound array buffer
+    next.vertexAttribPointer(index, size, type, normalized, stride, pointer);
+    if (recording()) {
+        putCommand(TRACE_VERTEX_ATTRIB_POINTER);
+        put(index);
+        put(size);
+        put(type);
+        put(normalized);
+        put(stride);
+        putSize((long long)(uintptr_t)pointer);
+    }
+}
+
+static void GLAPIENTRY traceEnableVertexAttribArray(GLuint index) {
+    next.enableVertexAttribArray(index);
+    if (recording()) {
+        putCommand(TRACE_ENABLE_VERTEX_ATTRIB_ARRAY);
+        put(index);
+    }
+}
+
+static void GLAPIENTRY traceVertexAttribDivisor(GLuint index, GLuint divisor) {
+    next.vertexAttribDivisor(index, divisor);
+    if (recording()) {
+        putCommand(TRACE_VERTEX_ATTRIB_DIVISOR);
+        put(index);
+        put(divisor);
+    }
+}
+
+static void GLAPIENTRY traceDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount) {
+    next.drawArraysInstanced(mode, first, count, instanceCount);
+    if (recording()) {
+        putCommand(TRACE_DRAW_ARRAYS_INSTANCED);
+        put(mode);
+        put(first);
+        put(count);
+        put(instanceCount);
+    }
+}
+
+//////////////////////////////////////////////// SHADERS AND PROGRAMS ////////////////////////////////////////////////
+
+static void traceName(GLTraceCommand command, GLuint name) {
+    if (recording()) {
+        putCommand(command);
+        put(name);
+    }
+}
+
+static GLuint GLAPIENTRY traceCreateShader(GLenum type) {
+    GLuint shader = next.createShader(type);
+    if (recording()) {
+        putCommand(TRACE_CREATE_SHADER);
+        put(type);
+        put(shader);
+    }
+    return shader;
+}
+
+static void GLAPIENTRY traceShaderSource(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths) {
+    next.shaderSource(shader, count, strings, lengths);
+    if (recording()) {
+        // the strings are joined, the player hands GL a single one
+        std::string source;
+        for (GLsizei i = 0; i < count; i++)
+            source.append(strings[i], lengths != NULL && lengths[i] >= 0 ? lengths[i] : strlen(strings[i]));
+        putCommand(TRACE_SHADER_SOURCE);
+        put(shader);
+        putData(source.data(), source.size());
+    }
+}
+
+static void GLAPIENTRY traceCompileShader(GLuint shader) {
+    next.compileShader(shader);
+    traceName(TRACE_COMPILE_SHADER, shader);
+}
+
+static void GLAPIENTRY traceDeleteShader(GLuint shader) {
+    next.deleteShader(shader);
+    traceName(TRACE_DELETE_SHADER, shader);
+}
+
+static GLuint GLAPIENTRY traceCreateProgram() {
+    GLuint program = next.createProgram();
+    traceName(TRACE_CREATE_PROGRAM, program);
+    return program;
+}
+
+static void GLAPIENTRY traceAttachShader(GLuint program, GLuint shader) {
+    next.attachShader(program, shader);
+    if (recording()) {
+        putCommand(TRACE_ATTACH_SHADER);
+        put(program);
+        put(shader);
+    }
+}
+
+static void GLAPIENTRY traceLinkProgram(GLuint program) {
+    next.linkProgram(program);
+    traceName(TRACE_LINK_PROGRAM, program);
+}
+
+static void GLAPIENTRY traceUseProgram(GLuint program) {
+    next.useProgram(program);
+    traceName(TRACE_USE_PROGRAM, program);
+}
+
+static GLint GLAPIENTRY traceGetUniformLocation(GLuint program, const GLchar* name) {
+    GLint location = next.getUniformLocation(program, name);
+    if (recording()) {
+        putCommand(TRACE_GET_UNIFORM_LOCATION);
+        put(program);
+        putData(name, strlen(name));
+        put(location);
+    }
+    return location;
+}
+
+static void GLAPIENTRY traceUniform1i(GLint location, GLint v0) {
+    next.uniform1i(location, v0);
+    if (recording()) {
+        putCommand(TRACE_UNIFORM_1I);
+        put(location);
+        put(v0);
+    }
+}
+
+static void GLAPIENTRY traceUniform1f(GLint location, GLfloat v0) {
+    next.uniform1f(location, v0);
+    if (recording()) {
+        putCommand(TRACE_UNIFORM_1F);
+        put(location);
+        put(v0);
+    }
+}
+
+static void GLAPIENTRY traceUniform3fv(GLint location, GLsizei count, const GLfloat* value) {
+    next.uniform3fv(location, count, value);
+    if (recording()) {
+        putCommand(TRACE_UNIFORM_3FV);
+        put(location);
+        putData(value, count * 3 * sizeof(GLfloat));
+    }
+}
+
+static void GLAPIENTRY traceUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    next.uniformMatrix4fv(location, count, transpose, value);
+    if (recording()) {
+        putCommand(TRACE_UNIFORM_MATRIX_4FV);
+        put(location);
+        put(transpose);
+        putData(value, count * 16 * sizeof(GLfloat));
+    }
+}
+
+//////////////////////////////////////////////// TEXTURES AND FRAMEBUFFERS ////////////////////////////////////////////////
+
+static void GLAPIENTRY traceActiveTexture(GLenum texture) {
+    next.activeTexture(texture);
+    if (recording()) {
+        putCommand(TRACE_ACTIVE_TEXTURE);
+        put(texture);
+    }
+}
+
+static void GLAPIENTRY traceGenerateMipmap(GLenum target) {
+    next.generateMipmap(target);
+    if (recording()) {
+        putCommand(TRACE_GENERATE_MIPMAP);
+        put(target);
+    }
+}
+
+static void GLAPIENTRY traceCompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height,
+    GLint border, GLsizei imageSize, const void* data) {
+    next.compressedTexImage2D(target, level, internalFormat, width, height, border, imageSize, data);
+    if (recording()) {
+        putCommand(TRACE_COMPRESSED_TEX_IMAGE_2D);
+        put(target);
+        put(level);
+        put(internalFormat);
+        put(width);
+        put(height);
+        put(border);
+        put(imageSize);
+        bool unpackBuffer = boundBuffer(GL_PIXEL_UNPACK_BUFFER) != 0;
+        put((unsigned char)unpackBuffer);
+        if (unpackBuffer)
+            putSize((long long)(uintptr_t)data);
+        else
+            putOptionalData(data, imageSize);
+    }
+}
+
+static void GLAPIENTRY traceTexImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth,
+    GLint border, GLenum format, GLenum type, const void* pixels) {
+    next.texImage3D(target, level, internalFormat, width, height, depth, border, format, type, pixels);
+    if (recording()) {
+        putCommand(TRACE_TEX_IMAGE_3D);
+        put(target);
+        put(level);
+        put(internalFormat);
+        put(width);
+        put(height);
+        put(depth);
+        put(border);
+        put(format);
+        put(type);
+        bool unpackBuffer = boundBuffer(GL_PIXEL_UNPACK_BUFFER) != 0;
+        put((unsigned char)unpackBuffer);
+        if (unpackBuffer)
+            putSize((long long)(uintptr_t)pixels);
+        else {
+            size_t rowBytes = ((size_t)width * glTexelBytes(format, type) + recorder.unpackAlignment - 1) / recorder.unpackAlignment * recorder.unpackAlignment;
+            putOptionalData(pixels, rowBytes * height * depth);
+        }
+    }
+}
+
+static void GLAPIENTRY traceGenFramebuffers(GLsizei n, GLuint* framebuffers) {
+    next.genFramebuffers(n, framebuffers);
+    if (recording()) {
+        putCommand(TRACE_GEN_FRAMEBUFFERS);
+        putNames(n, framebuffers);
+    }
+}
+
+static void GLAPIENTRY traceBindFramebuffer(GLenum target, GLuint framebuffer) {
+    next.bindFramebuffer(target, framebuffer);
+    if (recording()) {
+        putCommand(TRACE_BIND_FRAMEBUFFER);
+        put(target);
+        put(framebuffer);
+    }
+}
+
+static void GLAPIENTRY traceFramebufferTexture(GLenum target, GLenum attachment, GLuint texture, GLint level) {
+    next.framebufferTexture(target, attachment, texture, level);
+    if (recording()) {
+        putCommand(TRACE_FRAMEBUFFER_TEXTURE);
+        put(target);
+        put(attachment);
+        put(texture);
+        put(level);
+    }
+}
+
+static void GLAPIENTRY traceFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbufferTarget, GLuint renderbuffer) {
+    next.framebufferRenderbuffer(target, attachment, renderbufferTarget, renderbuffer);
+    if (recording()) {
+        putCommand(TRACE_FRAMEBUFFER_RENDERBUFFER);
+        put(target);
+        put(attachment);
+        put(renderbufferTarget);
+        put(renderbuffer);
+    }
+}
+
+static GLenum GLAPIENTRY traceCheckFramebufferStatus(GLenum target) {
+    GLenum status = next.checkFramebufferStatus(target);
+    if (recording()) {
+        putCommand(TRACE_CHECK_FRAMEBUFFER_STATUS);
+        put(target);
+    }
+    return status;
+}
+
+static void GLAPIENTRY traceDeleteFramebuffers(GLsizei n, const GLuint* framebuffers) {
+    next.deleteFramebuffers(n, framebuffers);
+    if (recording()) {
+        putCommand(TRACE_DELETE_FRAMEBUFFERS);
+        putNames(n, framebuffers);
+    }
+}
+
+static void GLAPIENTRY traceGenRenderbuffers(GLsizei n, GLuint* renderbuffers) {
+    next.genRenderbuffers(n, renderbuffers);
+    if (recording()) {
+        putCommand(TRACE_GEN_RENDERBUFFERS);
+        putNames(n, renderbuffers);
+    }
+}
+
+static void GLAPIENTRY traceBindRenderbuffer(GLenum target, GLuint renderbuffer) {
+    next.bindRenderbuffer(target, renderbuffer);
+    if (recording()) {
+        putCommand(TRACE_BIND_RENDERBUFFER);
+        put(target);
+        put(renderbuffer);
+    }
+}
+
+static void GLAPIENTRY traceRenderbufferStorage(GLenum target, GLenum internalFormat, GLsizei width, GLsizei height) {
+    next.renderbufferStorage(target, internalFormat, width, height);
+    if (recording()) {
+        putCommand(TRACE_RENDERBUFFER_STORAGE);
+        put(target);
+        put(internalFormat);
+        put(width);
+        put(height);
+    }
+}
+
+static void GLAPIENTRY traceDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers) {
+    next.deleteRenderbuffers(n, renderbuffers);
+    if (recording()) {
+        putCommand(TRACE_DELETE_RENDERBUFFERS);
+        putNames(n, renderbuffers);
+    }
+}
+
+//////////////////////////////////////////////// QUERIES AND FENCES ////////////////////////////////////////////////
+
+static void GLAPIENTRY traceGenQueries(GLsizei n, GLuint* ids) {
+    next.genQueries(n, ids);
+    if (recording()) {
+        putCommand(TRACE_GEN_QUERIES);
+        putNames(n, ids);
+    }
+}
+
+static void GLAPIENTRY traceQueryCounter(GLuint id, GLenum target) {
+    next.queryCounter(id, target);
+    if (recording()) {
+        putCommand(TRACE_QUERY_COUNTER);
+        put(id);
+        put(target);
+    }
+}
+
+static void GLAPIENTRY traceGetQueryObjectiv(GLuint id, GLenum pname, GLint* params) {
+    // kept because asking for a result waits for the GPU
+    next.getQueryObjectiv(id, pname, params);
+    if (recording()) {
+        putCommand(TRACE_GET_QUERY_OBJECTIV);
+        put(id);
+        put(pname);
+    }
+}
+
+static void GLAPIENTRY traceGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params) {
+    next.getQueryObjectui64v(id, pname, params);
+    if (recording()) {
+        putCommand(TRACE_GET_QUERY_OBJECTUI64V);
+        put(id);
+        put(pname);
+    }
+}
+
+static GLsync GLAPIENTRY traceFenceSync(GLenum condition, GLbitfield flags) {
+    GLsync sync = next.fenceSync(condition, flags);
+    if (recording()) {
+        putCommand(TRACE_FENCE_SYNC);
+        put(condition);
+        put(flags);
+        putSync(sync);
+    }
+    return sync;
+}
+
+static GLenum GLAPIENTRY traceClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+    GLenum status = next.clientWaitSync(sync, flags, timeout);
+    if (recording()) {
+        putCommand(TRACE_CLIENT_WAIT_SYNC);
+        putSync(sync);
+        put(flags);
+        put(timeout);
+    }
+    return status;
+}
+
+static void GLAPIENTRY traceDeleteSync(GLsync sync) {
+    next.deleteSync(sync);
+    if (recording()) {
+        putCommand(TRACE_DELETE_SYNC);
+        putSync(sync);
+    }
+}
+
+//////////////////////////////////////////////// GL 1.1, see GLDispatch.hpp ////////////////////////////////////////////////
+
+static void GLAPIENTRY traceBindTexture(GLenum target, GLuint texture) {
+    next.gl11.bindTexture(target, texture);
+    if (recording()) {
+        putCommand(TRACE_BIND_TEXTURE);
+        put(target);
+        put(texture);
+    }
+}
+
+static void GLAPIENTRY traceClear(GLbitfield mask) {
+    next.gl11.clear(mask);
+    if (recording()) {
+        putCommand(TRACE_CLEAR);
+        put(mask);
+    }
+}
+
+static void GLAPIENTRY traceClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha) {
+    next.gl11.clearColor(red, green, blue, alpha);
+    if (recording()) {
+        putCommand(TRACE_CLEAR_COLOR);
+        put(red);
+        put(green);
+        put(blue);
+        put(alpha);
+    }
+}
+
+static void GLAPIENTRY traceDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    next.gl11.drawArrays(mode, first, count);
+    if (recording()) {
+        putCommand(TRACE_DRAW_ARRAYS);
+        put(mode);
+        put(first);
+        put(count);
+    }
+}
+
+static void GLAPIENTRY traceDrawBuffer(GLenum mode) {
+    next.gl11.drawBuffer(mode);
+    if (recording()) {
+        putCommand(TRACE_DRAW_BUFFER);
+        put(mode);
+    }
+}
+
+static void GLAPIENTRY traceEnable(GLenum cap) {
+    next.gl11.enable(cap);
+    if (recording()) {
+        putCommand(TRACE_ENABLE);
+        put(cap);
+    }
+}
+
+static void GLAPIENTRY traceFinish() {
+    next.gl11.finish();
+    if (recording())
+        putCommand(TRACE_FINISH);
+}
+
+static void GLAPIENTRY traceGenTextures(GLsizei n, GLuint* textures) {
+    next.gl11.genTextures(n, textures);
+    if (recording()) {
+        putCommand(TRACE_GEN_TEXTURES);
+        putNames(n, textures);
+    }
+}
+
+static void GLAPIENTRY traceDeleteTextures(GLsizei n, const GLuint* textures) {
+    next.gl11.deleteTextures(n, textures);
+    if (recording()) {
+        putCommand(TRACE_DELETE_TEXTURES);
+        putNames(n, textures);
+    }
+}
+
+static void GLAPIENTRY tracePixelStorei(GLenum pname, GLint param) {
+    next.gl11.pixelStorei(pname, param);
+    if (recording()) {
+        if (pname == GL_UNPACK_ALIGNMENT)
+            recorder.unpackAlignment = param;
+        putCommand(TRACE_PIXEL_STOREI);
+        put(pname);
+        put(param);
+    }
+}
+
+static void GLAPIENTRY tracePolygonMode(GLenum face, GLenum mode) {
+    next.gl11.polygonMode(face, mode);
+    if (recording()) {
+        putCommand(TRACE_POLYGON_MODE);
+        put(face);
+        put(mode);
+    }
+}
+
+static void GLAPIENTRY traceReadBuffer(GLenum mode) {
+    next.gl11.readBuffer(mode);
+    if (recording()) {
+        putCommand(TRACE_READ_BUFFER);
+        put(mode);
+    }
+}
+
+static void GLAPIENTRY traceReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels) {
+    // the pixels read into memory are not kept, the player reads them into its own
+    next.gl11.readPixels(x, y, width, height, format, type, pixels);
+    if (recording()) {
+        bool packBuffer = boundBuffer(GL_PIXEL_PACK_BUFFER) != 0;
+        putCommand(TRACE_READ_PIXELS);
+        put(x);
+        put(y);
+        put(width);
+        put(height);
+        put(format);
+        put(type);
+        put((unsigned char)packBuffer);
+        putSize(packBuffer ? (long long)(uintptr_t)pixels : 0);
+    }
+}
+
+static void GLAPIENTRY traceTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border,
+    GLenum format, GLenum type, const void* pixels) {
+    next.gl11.texImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+    if (recording()) {
+        putCommand(TRACE_TEX_IMAGE_2D);
+        put(target);
+        put(level);
+        put(internalFormat);
+        put(width);
+        put(height);
+        put(border);
+        put(format);
+        put(type);
+        // the pixels are either in memory (rows padded to the unpack alignment) or in the pixel unpack buffer
+        bool unpackBuffer = boundBuffer(GL_PIXEL_UNPACK_BUFFER) != 0;
+        put((unsigned char)unpackBuffer);
+        if (unpackBuffer)
+            putSize((long long)(uintptr_t)pixels);
+        else {
+            size_t rowBytes = ((size_t)width * glTexelBytes(format, type) + recorder.unpackAlignment - 1) / recorder.unpackAlignment * recorder.unpackAlignment;
+            putOptionalData(pixels, rowBytes * height);
+        }
+    }
+}
+
+static void GLAPIENTRY traceTexParameteri(GLenum target, GLenum pname, GLint param) {
+    next.gl11.texParameteri(target, pname, param);
+    if (recording()) {
+        putCommand(TRACE_TEX_PARAMETERI);
+        put(target);
+        put(pname);
+        put(param);
+    }
+}
+
+static void GLAPIENTRY traceViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    next.gl11.viewport(x, y, width, height);
+    if (recording()) {
+        putCommand(TRACE_VIEWPORT);
+        put(x);
+        put(y);
+        put(width);
+        put(height);
+    }
+}
+
+//////////////////////////////////////////////// RECORDING ////////////////////////////////////////////////
+
+static void install() {
+    // every entry point goes to the recorder, which calls what it pointed at before
+    next.genBuffers = __glewGenBuffers; __glewGenBuffers = traceGenBuffers;
+    next.bindBuffer = __glewBindBuffer; __glewBindBuffer = traceBindBuffer;
+    next.bufferData = __glewBufferData; __glewBufferData = traceBufferData;
+    next.bufferSubData = __glewBufferSubData; __glewBufferSubData = traceBufferSubData;
+    next.bufferStorage = __glewBufferStorage; __glewBufferStorage = traceBufferStorage;
+    next.mapBufferRange = __glewMapBufferRange; __glewMapBufferRange = traceMapBufferRange;
+    next.unmapBuffer = __glewUnmapBuffer; __glewUnmapBuffer = traceUnmapBuffer;
+    next.deleteBuffers = __glewDeleteBuffers; __glewDeleteBuffers = traceDeleteBuffers;
+
+    next.genVertexArrays = __glewGenVertexArrays; __glewGenVertexArrays = traceGenVertexArrays;
+    next.bindVertexArray = __glewBindVertexArray; __glewBindVertexArray = traceBindVertexArray;
+    next.vertexAttribPointer = __glewVertexAttribPointer; __glewVertexAttribPointer = traceVertexAttribPointer;
+    next.enableVertexAttribArray = __glewEnableVertexAttribArray; __glewEnableVertexAttribArray = traceEnableVertexAttribArray;
+    next.vertexAttribDivisor = __glewVertexAttribDivisor; __glewVertexAttribDivisor = traceVertexAttribDivisor;
+    next.drawArraysInstanced = __glewDrawArraysInstanced; __glewDrawArraysInstanced = traceDrawArraysInstanced;
+
+    next.createShader = __glewCreateShader; __glewCreateShader = traceCreateShader;
+    next.shaderSource = __glewShaderSource; __glewShaderSource = traceShaderSource;
+    next.compileShader = __glewCompileShader; __glewCompileShader = traceCompileShader;
+    next.deleteShader = __glewDeleteShader; __glewDeleteShader = traceDeleteShader;
+    next.createProgram = __glewCreateProgram; __glewCreateProgram = traceCreateProgram;
+    next.attachShader = __glewAttachShader; __glewAttachShader = traceAttachShader;
+    next.linkProgram = __glewLinkProgram; __glewLinkProgram = traceLinkProgram;
+    next.useProgram = __glewUseProgram; __glewUseProgram = traceUseProgram;
+    next.getUniformLocation = __glewGetUniformLocation; __glewGetUniformLocation = traceGetUniformLocation;
+    next.uniform1i = __glewUniform1i; __glewUniform1i = traceUniform1i;
+    next.uniform1f = __glewUniform1f; __glewUniform1f = traceUniform1f;
+    next.uniform3fv = __glewUniform3fv; __glewUniform3fv = traceUniform3fv;
+    next.uniformMatrix4fv = __glewUniformMatrix4fv; __glewUniformMatrix4fv = traceUniformMatrix4fv;
+
+    next.activeTexture = __glewActiveTexture; __glewActiveTexture = traceActiveTexture;
+    next.generateMipmap = __glewGenerateMipmap; __glewGenerateMipmap = traceGenerateMipmap;
+    next.compressedTexImage2D = __glewCompressedTexImage2D; __glewCompressedTexImage2D = traceCompressedTexImage2D;
+    next.texImage3D = __glewTexImage3D; __glewTexImage3D = traceTexImage3D;
+    next.genFramebuffers = __glewGenFramebuffers; __glewGenFramebuffers = traceGenFramebuffers;
+    next.bindFramebuffer = __glewBindFramebuffer; __glewBindFramebuffer = traceBindFramebuffer;
+    next.framebufferTexture = __glewFramebufferTexture; __glewFramebufferTexture = traceFramebufferTexture;
+    next.framebufferRenderbuffer = __glewFramebufferRenderbuffer; __glewFramebufferRenderbuffer = traceFramebufferRenderbuffer;
+    next.checkFramebufferStatus = __glewCheckFramebufferStatus; __glewCheckFramebufferStatus = traceCheckFramebufferStatus;
+    next.deleteFramebuffers = __glewDeleteFramebuffers; __glewDeleteFramebuffers = traceDeleteFramebuffers;
+    next.genRenderbuffers = __glewGenRenderbuffers; __glewGenRenderbuffers = traceGenRenderbuffers;
+    next.bindRenderbuffer = __glewBindRenderbuffer; __glewBindRenderbuffer = traceBindRenderbuffer;
+    next.renderbufferStorage = __glewRenderbufferStorage; __glewRenderbufferStorage = traceRenderbufferStorage;
+    next.deleteRenderbuffers = __glewDeleteRenderbuffers; __glewDeleteRenderbuffers = traceDeleteRenderbuffers;
+
+    next.genQueries = __glewGenQueries; __glewGenQueries = traceGenQueries;
+    next.queryCounter = __glewQueryCounter; __glewQueryCounter = traceQueryCounter;
+    next.getQueryObjectiv = __glewGetQueryObjectiv; __glewGetQueryObjectiv = traceGetQueryObjectiv;
+    next.getQueryObjectui64v = __glewGetQueryObjectui64v; __glewGetQueryObjectui64v = traceGetQueryObjectui64v;
+    next.fenceSync = __glewFenceSync; __glewFenceSync = traceFenceSync;
+    next.clientWaitSync = __glewClientWaitSync; __glewClientWaitSync = traceClientWaitSync;
+    next.deleteSync = __glewDeleteSync; __glewDeleteSync = traceDeleteSync;
+
+    next.gl11 = gl11();
+    gl11().bindTexture = traceBindTexture;
+    gl11().clear = traceClear;
+    gl11().clearColor = traceClearColor;
+    gl11().deleteTextures = traceDeleteTextures;
+    gl11().drawArrays = traceDrawArrays;
+    gl11().drawBuffer = traceDrawBuffer;
+    gl11().enable = traceEnable;
+    gl11().finish = traceFinish;
+    gl11().genTextures = traceGenTextures;
+    gl11().pixelStorei = tracePixelStorei;
+    gl11().polygonMode = tracePolygonMode;
+    gl11().readBuffer = traceReadBuffer;
+    gl11().readPixels = traceReadPixels;
+    gl11().texImage2D = traceTexImage2D;
+    gl11().texParameteri = traceTexParameteri;
+    gl11().viewport = traceViewport;
+}
+
+bool startGLTrace(std::string filePath, int frames, int width, int height) {
+    recorder.file = fopen(filePath.c_str(), "wb");
+    if (recorder.file == NULL) {
+        std::cerr << "Could not open " << filePath << " to write the GL trace" << std::endl;
+        return false;
+    }
+    recorder.filePath = filePath;
+    recorder.frames = frames;
+    memset(&recorder.header, 0, sizeof(GLTraceHeader));
+    memcpy(recorder.header.magic, "SHCGLTR", 8);
+    recorder.header.version = GL_TRACE_VERSION;
+    recorder.header.width = width;
+    recorder.header.height = height;
+    if (fwrite(&recorder.header, sizeof(GLTraceHeader), 1, recorder.file) != 1) {
+        std::cerr << "Could not write the GL trace " << filePath << std::endl;
+        fclose(recorder.file);
+        recorder.file = NULL;
+        return false;
+    }
+
+    // nothing sees what is written into a persistently mapped buffer, see GLTrace.hpp
+    __GLEW_VERSION_4_4 = GL_FALSE;
+    __GLEW_ARB_buffer_storage = GL_FALSE;
+    // a program binary only loads on the driver that made it, the trace has to link the programs from their sources
+    __GLEW_VERSION_4_1 = GL_FALSE;
+    __GLEW_ARB_get_program_binary = GL_FALSE;
+
+    install();
+    recorder.recording = true;
+    return true;
+}
+
+void glTraceBeginFrame() {
+    if (!recorder.recording)
+        return;
+    if (recorder.frames > 0 && recorder.header.frames >= recorder.frames) {
+        finishGLTrace();
+        return;
+    }
+    // written out before the frame's marker, the file always ends with whole frames
+    if (recorder.commands.size() >= FLUSH_BYTES && !flush())
+        return;
+    putCommand(TRACE_FRAME);
+    recorder.header.frames++;
+}
+
+void finishGLTrace() {
+    if (!recorder.recording)
+        return;
+    putCommand(TRACE_END);
+    if (flush()) {
+        std::cout << "GL trace: " << recorder.header.frames << " frames written to " << recorder.filePath << std::endl;
+        fclose(recorder.file);
+        recorder.file = NULL;
+    }
+    // the entry points stay with the recorder, it only passes the calls on from now on
+    recorder.recording = false;
+}
+
+bool isRecordingGLTrace() {
+    return recorder.recording;
+}
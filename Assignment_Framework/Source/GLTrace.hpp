@@ -0,0 +1,68 @@
+#ifndef GL_TRACE_HEADER
+#define GL_TRACE_HEADER
+
+#include <string>
+
+/* Records the GL command stream to a file (-gltrace), for GLTracePlayer to run again without the game: driver
+* benchmarks that do not depend on the game logic, and problems seen on a cabinet that can be reproduced anywhere.
+* startGLTrace() goes between the entry points the game uses (the GLEW pointers and GLDispatch.hpp) and whatever
+* they pointed at, the driver or the null backend: every call is written down with its arguments and the data it
+* sends (buffer contents, texture images, shader sources), then passed on. It has to be started right after
+* glewInit so the trace holds the creation of every object the frames use.
+* What the driver hands back (names, uniform locations, fences) is written too so the player can map it to its own.
+* The calls that only ask for information (glGetString, compile and link logs) are not recorded.
+* Memory written through a pointer from glMapBufferRange is saved when the buffer is unmapped, persistent mapping
+* never unmaps so buffer storage is reported as unsupported while recording (StreamBuffer falls back to uploads).
+* Only one thread may call GL at a time, like with a context.
+*
+* The file starts with a GLTraceHeader, followed by the commands: a GLTraceCommand byte then its arguments in the
+* order of the GL function, names as 32 bits, sizes, offsets and pointers as 64 bits, data as a 32 bit size and the
+* bytes, all little endian like every machine the game runs on. TRACE_FRAME starts each frame, TRACE_END ends the
+* last one.
+*/
+
+enum GLTraceCommand {
+	TRACE_FRAME, TRACE_END,
+
+	TRACE_GEN_BUFFERS, TRACE_BIND_BUFFER, TRACE_BUFFER_DATA, TRACE_BUFFER_SUB_DATA, TRACE_BUFFER_STORAGE,
+	TRACE_MAP_BUFFER_RANGE, TRACE_UNMAP_BUFFER, TRACE_DELETE_BUFFERS,
+
+	TRACE_GEN_VERTEX_ARRAYS, TRACE_BIND_VERTEX_ARRAY, TRACE_VERTEX_ATTRIB_POINTER, TRACE_ENABLE_VERTEX_ATTRIB_ARRAY,
+	TRACE_VERTEX_ATTRIB_DIVISOR, TRACE_DRAW_ARRAYS_INSTANCED,
+
+	TRACE_CREATE_SHADER, TRACE_SHADER_SOURCE, TRACE_COMPILE_SHADER, TRACE_DELETE_SHADER, TRACE_CREATE_PROGRAM,
+	TRACE_ATTACH_SHADER, TRACE_LINK_PROGRAM, TRACE_USE_PROGRAM, TRACE_GET_UNIFORM_LOCATION,
+	TRACE_UNIFORM_1I, TRACE_UNIFORM_1F, TRACE_UNIFORM_3FV, TRACE_UNIFORM_MATRIX_4FV,
+
+	TRACE_ACTIVE_TEXTURE, TRACE_GEN_FRAMEBUFFERS, TRACE_BIND_FRAMEBUFFER, TRACE_FRAMEBUFFER_TEXTURE,
+	TRACE_FRAMEBUFFER_RENDERBUFFER, TRACE_CHECK_FRAMEBUFFER_STATUS, TRACE_DELETE_FRAMEBUFFERS,
+	TRACE_GEN_RENDERBUFFERS, TRACE_BIND_RENDERBUFFER, TRACE_RENDERBUFFER_STORAGE, TRACE_DELETE_RENDERBUFFERS,
+
+	TRACE_GEN_QUERIES, TRACE_QUERY_COUNTER, TRACE_GET_QUERY_OBJECTIV, TRACE_GET_QUERY_OBJECTUI64V,
+	TRACE_FENCE_SYNC, TRACE_CLIENT_WAIT_SYNC, TRACE_DELETE_SYNC,
+
+	TRACE_BIND_TEXTURE, TRACE_CLEAR, TRACE_CLEAR_COLOR, TRACE_DRAW_ARRAYS, TRACE_DRAW_BUFFER, TRACE_ENABLE,
+	TRACE_FINISH, TRACE_GEN_TEXTURES, TRACE_PIXEL_STOREI, TRACE_POLYGON_MODE, TRACE_READ_BUFFER, TRACE_READ_PIXELS,
+	TRACE_TEX_IMAGE_2D, TRACE_TEX_PARAMETERI, TRACE_VIEWPORT,
+
+	TRACE_GENERATE_MIPMAP, TRACE_COMPRESSED_TEX_IMAGE_2D, TRACE_TEX_IMAGE_3D, TRACE_DELETE_TEXTURES,
+
+	TRACE_COMMAND_COUNT
+};
+
+struct GLTraceHeader {
+	char magic[8]; // "SHCGLTR" and a 0
+	int version;
+	int width, height; // of what the frames were drawn into, the player draws into a render target of that size
+	int frames; // TRACE_FRAME commands in the file
+};
+
+const int GL_TRACE_VERSION = 2; // goes up with every change to the commands, an older player refuses the trace instead of misreading it
+
+// records the calls made from now on, startup included, until `frames` frames are done (0 until finishGLTrace)
+bool startGLTrace(std::string filePath, int frames, int width, int height);
+void glTraceBeginFrame(); // call at the start of every frame, on the thread drawing it
+void finishGLTrace(); // ends the trace early (the game quit before all the frames), before the GL objects are destroyed
+bool isRecordingGLTrace();
+
+#endif
@@ -0,0 +1,569 @@
+#include "GLTracePlayer.hpp"
+#include "GLMetrics.hpp" // the frames played are counted like the game's
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+bool GLTracePlayer::open(std::string pFilePath) {
+    filePath = pFilePath;
+    FILE* file = fopen(filePath.c_str(), "rb");
+    if (file == NULL) {
+        std::cerr << "Could not open GL trace " << filePath << "." << std::endl;
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    trace.resize(size > 0 ? size : 0);
+    bool read = size > 0 && fread(&trace[0], 1, trace.size(), file) == trace.size();
+    fclose(file);
+
+    if (!read || trace.size() < sizeof(GLTraceHeader)) {
+        std::cerr << "Could not read GL trace " << filePath << "." << std::endl;
+        return false;
+    }
+    memcpy(&header, &trace[0], sizeof(GLTraceHeader));
+    if (memcmp(header.magic, "SHCGLTR", 8) != 0 || header.version != GL_TRACE_VERSION) {
+        std::cerr << filePath << " is not a GL trace of this version." << std::endl;
+        return false;
+    }
+    if (header.frames <= 0) {
+        std::cerr << "GL trace " << filePath << " has no frames." << std::endl;
+        return false;
+    }
+    position = sizeof(GLTraceHeader);
+    return true;
+}
+
+bool GLTracePlayer::playStartup() {
+    if (play() != TRACE_FRAME)
+        return false;
+    firstFrame = position;
+    return true;
+}
+
+bool GLTracePlayer::playFrame() {
+    int end = play();
+    if (end == TRACE_END)
+        position = firstFrame; // around again
+    return end != -1;
+}
+
+//////////////////////////////////////////////// DECODING ////////////////////////////////////////////////
+
+template <typename T>
+T GLTracePlayer::get() {
+    T value = T();
+    if (position + sizeof(T) > trace.size())
+        damaged = true;
+    else {
+        memcpy(&value, &trace[position], sizeof(T));
+        position += sizeof(T);
+    }
+    return value;
+}
+
+const void* GLTracePlayer::getData(unsigned int& size) {
+    size = get<unsigned int>();
+    if (size == 0 || position + size > trace.size()) {
+        damaged = damaged || size != 0;
+        size = 0;
+        return NULL;
+    }
+    const void* data = &trace[position];
+    position += size;
+    return data;
+}
+
+const void* GLTracePlayer::getOptionalData() {
+    unsigned int size;
+    return get<unsigned char>() != 0 ? getData(size) : NULL;
+}
+
+GLuint& GLTracePlayer::name(NameKind kind, GLuint traceName) {
+    std::vector<GLuint>& kindNames = names[kind];
+    if (traceName >= kindNames.size())
+        kindNames.resize(traceName + 1, 0);
+    return kindNames[traceName];
+}
+
+GLuint GLTracePlayer::lookUp(NameKind kind, GLuint traceName) {
+    // 0 stays 0 (unbinds), except the default framebuffer which is the render target
+    if (kind == FRAMEBUFFER_NAMES && traceName == 0)
+        return defaultFramebuffer;
+    return traceName < names[kind].size() ? names[kind][traceName] : 0;
+}
+
+GLint GLTracePlayer::location(GLint traceLocation) {
+    if (traceLocation < 0 || programLocations == NULL || traceLocation >= (GLint)programLocations->size())
+        return -1;
+    return (*programLocations)[traceLocation];
+}
+
+GLenum GLTracePlayer::colorBuffer(GLenum mode, GLuint traceFramebuffer) {
+    // the render target standing in for the window only has a color attachment where the window had its back buffer
+    bool windowBuffer = mode == GL_BACK || mode == GL_FRONT || mode == GL_BACK_LEFT || mode == GL_FRONT_LEFT;
+    return windowBuffer && traceFramebuffer == 0 && defaultFramebuffer != 0 ? GL_COLOR_ATTACHMENT0 : mode;
+}
+
+void GLTracePlayer::generate(NameKind kind, void (GLAPIENTRY *gen)(GLsizei, GLuint*)) {
+    int n = get<int>();
+    if (n <= 0 || position + n * sizeof(GLuint) > trace.size()) {
+        damaged = damaged || n < 0;
+        return;
+    }
+    generated.resize(n);
+    gen(n, &generated[0]);
+    for (int i = 0; i < n; i++)
+        name(kind, get<GLuint>()) = generated[i];
+}
+
+void GLTracePlayer::remove(NameKind kind, void (GLAPIENTRY *del)(GLsizei, const GLuint*)) {
+    int n = get<int>();
+    if (n <= 0 || position + n * sizeof(GLuint) > trace.size()) {
+        damaged = damaged || n < 0;
+        return;
+    }
+    generated.resize(n);
+    for (int i = 0; i < n; i++) {
+        GLuint& mapped = name(kind, get<GLuint>());
+        generated[i] = mapped;
+        mapped = 0;
+    }
+    del(n, &generated[0]);
+}
+
+int GLTracePlayer::play() {
+    while (!damaged) {
+        if (position == trace.size())
+            return TRACE_END; // cut short while recording, the file still ends with whole frames
+        int command = get<unsigned char>();
+        if (command == TRACE_FRAME || command == TRACE_END)
+            return command;
+        if (!execute(command))
+            damaged = true;
+    }
+    std::cerr << "GL trace " << filePath << " is damaged at byte " << position << "." << std::endl;
+    return -1;
+}
+
+//////////////////////////////////////////////// COMMANDS ////////////////////////////////////////////////
+
+bool GLTracePlayer::execute(int command) {
+    // the arguments are read in the order they were written, two of them are never read in the same call since
+    // the order the arguments of a call are evaluated in is not defined
+    switch (command) {
+    case TRACE_GEN_BUFFERS:
+        generate(BUFFER_NAMES, glGenBuffers);
+        break;
+    case TRACE_BIND_BUFFER: {
+        GLenum target = get<GLenum>();
+        GLuint buffer = get<GLuint>();
+        boundBuffers[target] = buffer;
+        glBindBuffer(target, lookUp(BUFFER_NAMES, buffer));
+        break;
+    }
+    case TRACE_BUFFER_DATA: {
+        GLenum target = get<GLenum>();
+        long long size = getSize();
+        const void* data = getOptionalData();
+        GLenum usage = get<GLenum>();
+        glBufferData(target, (GLsizeiptr)size, data, usage);
+        break;
+    }
+    case TRACE_BUFFER_SUB_DATA: {
+        GLenum target = get<GLenum>();
+        long long offset = getSize();
+        unsigned int size;
+        const void* data = getData(size);
+        if (data != NULL)
+            glBufferSubData(target, (GLintptr)offset, size, data);
+        break;
+    }
+    case TRACE_BUFFER_STORAGE: {
+        GLenum target = get<GLenum>();
+        long long size = getSize();
+        const void* data = getOptionalData();
+        GLbitfield flags = get<GLbitfield>();
+        glBufferStorage(target, (GLsizeiptr)size, data, flags);
+        break;
+    }
+    case TRACE_MAP_BUFFER_RANGE: {
+        GLenum target = get<GLenum>();
+        long long offset = getSize();
+        long long length = getSize();
+        GLbitfield access = get<GLbitfield>();
+        mappings[boundBuffers[target]] = glMapBufferRange(target, (GLintptr)offset, (GLsizeiptr)length, access);
+        break;
+    }
+    case TRACE_UNMAP_BUFFER: {
+        // what the game wrote into the mapped memory comes with the unmap
+        GLenum target = get<GLenum>();
+        unsigned int size = 0;
+        const void* data = get<unsigned char>() != 0 ? getData(size) : NULL;
+        void* mapped = mappings[boundBuffers[target]];
+        if (mapped != NULL && data != NULL)
+            memcpy(mapped, data, size);
+        mappings.erase(boundBuffers[target]);
+        glUnmapBuffer(target);
+        break;
+    }
+    case TRACE_DELETE_BUFFERS:
+        remove(BUFFER_NAMES, glDeleteBuffers);
+        break;
+
+    case TRACE_GEN_VERTEX_ARRAYS:
+        generate(VERTEX_ARRAY_NAMES, glGenVertexArrays);
+        break;
+    case TRACE_BIND_VERTEX_ARRAY:
+        glBindVertexArray(lookUp(VERTEX_ARRAY_NAMES, get<GLuint>()));
+        break;
+    case TRACE_VERTEX_ATTRIB_POINTER: {
+        GLuint index = get<GLuint>();
+        GLint size = get<GLint>();
+        GLenum type = get<GLenum>();
+        GLboolean normalized = get<GLboolean>();
+        GLsizei stride = get<GLsizei>();
+        long long offset = getSize();
+        glVertexAttribPointer(index, size, type, normalized, stride, (const void*)(uintptr_t)offset);
+        break;
+    }
+    case TRACE_ENABLE_VERTEX_ATTRIB_ARRAY:
+        glEnableVertexAttribArray(get<GLuint>());
+        break;
+    case TRACE_VERTEX_ATTRIB_DIVISOR: {
+        GLuint index = get<GLuint>();
+        GLuint divisor = get<GLuint>();
+        glVertexAttribDivisor(index, divisor);
+        break;
+    }
+    case TRACE_DRAW_ARRAYS_INSTANCED: {
+        GLenum mode = get<GLenum>();
+        GLint first = get<GLint>();
+        GLsizei count = get<GLsizei>();
+        GLsizei instanceCount = get<GLsizei>();
+        glDrawArraysInstanced(mode, first, count, instanceCount);
+        break;
+    }
+
+    case TRACE_CREATE_SHADER: {
+        GLenum type = get<GLenum>();
+        name(SHADER_NAMES, get<GLuint>()) = glCreateShader(type);
+        break;
+    }
+    case TRACE_SHADER_SOURCE: {
+        GLuint shader = lookUp(SHADER_NAMES, get<GLuint>());
+        unsigned int size;
+        const GLchar* source = (const GLchar*)getData(size);
+        GLint length = (GLint)size;
+        if (source != NULL)
+            glShaderSource(shader, 1, &source, &length);
+        break;
+    }
+    case TRACE_COMPILE_SHADER:
+        glCompileShader(lookUp(SHADER_NAMES, get<GLuint>()));
+        break;
+    case TRACE_DELETE_SHADER: {
+        GLuint& shader = name(SHADER_NAMES, get<GLuint>());
+        glDeleteShader(shader);
+        shader = 0;
+        break;
+    }
+    case TRACE_CREATE_PROGRAM: {
+        GLuint program = glCreateProgram();
+        name(SHADER_NAMES, get<GLuint>()) = program;
+        break;
+    }
+    case TRACE_ATTACH_SHADER: {
+        GLuint program = lookUp(SHADER_NAMES, get<GLuint>());
+        GLuint shader = lookUp(SHADER_NAMES, get<GLuint>());
+        glAttachShader(program, shader);
+        break;
+    }
+    case TRACE_LINK_PROGRAM:
+        glLinkProgram(lookUp(SHADER_NAMES, get<GLuint>()));
+        break;
+    case TRACE_USE_PROGRAM: {
+        GLuint program = get<GLuint>();
+        programLocations = program != 0 ? &uniformLocations[program] : NULL;
+        glUseProgram(lookUp(SHADER_NAMES, program));
+        break;
+    }
+    case TRACE_GET_UNIFORM_LOCATION: {
+        GLuint program = get<GLuint>();
+        unsigned int length;
+        const char* uniformName = (const char*)getData(length);
+        std::string uniform(uniformName != NULL ? uniformName : "", length);
+        GLint traceLocation = get<GLint>();
+        if (traceLocation >= 0) {
+            std::vector<GLint>& locations = uniformLocations[program];
+            if (traceLocation >= (GLint)locations.size())
+                locations.resize(traceLocation + 1, -1);
+            locations[traceLocation] = glGetUniformLocation(lookUp(SHADER_NAMES, program), uniform.c_str());
+        }
+        break;
+    }
+    case TRACE_UNIFORM_1I: {
+        GLint uniform = location(get<GLint>());
+        glUniform1i(uniform, get<GLint>());
+        break;
+    }
+    case TRACE_UNIFORM_1F: {
+        GLint uniform = location(get<GLint>());
+        glUniform1f(uniform, get<GLfloat>());
+        break;
+    }
+    case TRACE_UNIFORM_3FV: {
+        GLint uniform = location(get<GLint>());
+        unsigned int size;
+        const GLfloat* value = (const GLfloat*)getData(size);
+        if (value != NULL)
+            glUniform3fv(uniform, size / (3 * sizeof(GLfloat)), value);
+        break;
+    }
+    case TRACE_UNIFORM_MATRIX_4FV: {
+        GLint uniform = location(get<GLint>());
+        GLboolean transpose = get<GLboolean>();
+        unsigned int size;
+        const GLfloat* value = (const GLfloat*)getData(size);
+        if (value != NULL)
+            glUniformMatrix4fv(uniform, size / (16 * sizeof(GLfloat)), transpose, value);
+        break;
+    }
+
+    case TRACE_ACTIVE_TEXTURE:
+        glActiveTexture(get<GLenum>());
+        break;
+    case TRACE_GENERATE_MIPMAP:
+        glGenerateMipmap(get<GLenum>());
+        break;
+    case TRACE_COMPRESSED_TEX_IMAGE_2D: {
+        GLenum target = get<GLenum>();
+        GLint level = get<GLint>();
+        GLenum internalFormat = get<GLenum>();
+        GLsizei width = get<GLsizei>();
+        GLsizei height = get<GLsizei>();
+        GLint border = get<GLint>();
+        GLsizei imageSize = get<GLsizei>();
+        bool unpackBuffer = get<unsigned char>() != 0;
+        const void* data = unpackBuffer ? (const void*)(uintptr_t)getSize() : getOptionalData();
+        glCompressedTexImage2D(target, level, internalFormat, width, height, border, imageSize, data);
+        break;
+    }
+    case TRACE_TEX_IMAGE_3D: {
+        GLenum target = get<GLenum>();
+        GLint level = get<GLint>();
+        GLint internalFormat = get<GLint>();
+        GLsizei width = get<GLsizei>();
+        GLsizei height = get<GLsizei>();
+        GLsizei depth = get<GLsizei>();
+        GLint border = get<GLint>();
+        GLenum format = get<GLenum>();
+        GLenum type = get<GLenum>();
+        bool unpackBuffer = get<unsigned char>() != 0;
+        const void* data = unpackBuffer ? (const void*)(uintptr_t)getSize() : getOptionalData();
+        glTexImage3D(target, level, internalFormat, width, height, depth, border, format, type, data);
+        break;
+    }
+    case TRACE_GEN_FRAMEBUFFERS:
+        generate(FRAMEBUFFER_NAMES, glGenFramebuffers);
+        break;
+    case TRACE_BIND_FRAMEBUFFER: {
+        GLenum target = get<GLenum>();
+        GLuint framebuffer = get<GLuint>();
+        if (target != GL_READ_FRAMEBUFFER)
+            drawFramebuffer = framebuffer;
+        if (target != GL_DRAW_FRAMEBUFFER)
+            readFramebuffer = framebuffer;
+        glBindFramebuffer(target, lookUp(FRAMEBUFFER_NAMES, framebuffer));
+        break;
+    }
+    case TRACE_FRAMEBUFFER_TEXTURE: {
+        GLenum target = get<GLenum>();
+        GLenum attachment = get<GLenum>();
+        GLuint texture = lookUp(TEXTURE_NAMES, get<GLuint>());
+        GLint level = get<GLint>();
+        glFramebufferTexture(target, attachment, texture, level);
+        break;
+    }
+    case TRACE_FRAMEBUFFER_RENDERBUFFER: {
+        GLenum target = get<GLenum>();
+        GLenum attachment = get<GLenum>();
+        GLenum renderbufferTarget = get<GLenum>();
+        GLuint renderbuffer = lookUp(RENDERBUFFER_NAMES, get<GLuint>());
+        glFramebufferRenderbuffer(target, attachment, renderbufferTarget, renderbuffer);
+        break;
+    }
+    case TRACE_CHECK_FRAMEBUFFER_STATUS:
+        glCheckFramebufferStatus(get<GLenum>());
+        break;
+    case TRACE_DELETE_FRAMEBUFFERS:
+        remove(FRAMEBUFFER_NAMES, glDeleteFramebuffers);
+        break;
+    case TRACE_GEN_RENDERBUFFERS:
+        generate(RENDERBUFFER_NAMES, glGenRenderbuffers);
+        break;
+    case TRACE_BIND_RENDERBUFFER: {
+        GLenum target = get<GLenum>();
+        glBindRenderbuffer(target, lookUp(RENDERBUFFER_NAMES, get<GLuint>()));
+        break;
+    }
+    case TRACE_RENDERBUFFER_STORAGE: {
+        GLenum target = get<GLenum>();
+        GLenum internalFormat = get<GLenum>();
+        GLsizei width = get<GLsizei>();
+        GLsizei height = get<GLsizei>();
+        glRenderbufferStorage(target, internalFormat, width, height);
+        break;
+    }
+    case TRACE_DELETE_RENDERBUFFERS:
+        remove(RENDERBUFFER_NAMES, glDeleteRenderbuffers);
+        break;
+
+    case TRACE_GEN_QUERIES:
+        generate(QUERY_NAMES, glGenQueries);
+        break;
+    case TRACE_QUERY_COUNTER: {
+        GLuint query = lookUp(QUERY_NAMES, get<GLuint>());
+        glQueryCounter(query, get<GLenum>());
+        break;
+    }
+    case TRACE_GET_QUERY_OBJECTIV: {
+        GLuint query = lookUp(QUERY_NAMES, get<GLuint>());
+        GLint result;
+        glGetQueryObjectiv(query, get<GLenum>(), &result);
+        break;
+    }
+    case TRACE_GET_QUERY_OBJECTUI64V: {
+        GLuint query = lookUp(QUERY_NAMES, get<GLuint>());
+        GLuint64 result;
+        glGetQueryObjectui64v(query, get<GLenum>(), &result);
+        break;
+    }
+    case TRACE_FENCE_SYNC: {
+        GLenum condition = get<GLenum>();
+        GLbitfield flags = get<GLbitfield>();
+        syncs[get<unsigned long long>()] = glFenceSync(condition, flags);
+        break;
+    }
+    case TRACE_CLIENT_WAIT_SYNC: {
+        unsigned long long sync = get<unsigned long long>();
+        GLbitfield flags = get<GLbitfield>();
+        GLuint64 timeout = get<GLuint64>();
+        std::unordered_map<unsigned long long, GLsync>::iterator found = syncs.find(sync);
+        if (found != syncs.end())
+            glClientWaitSync(found->second, flags, timeout);
+        break;
+    }
+    case TRACE_DELETE_SYNC: {
+        std::unordered_map<unsigned long long, GLsync>::iterator found = syncs.find(get<unsigned long long>());
+        if (found != syncs.end()) {
+            glDeleteSync(found->second);
+            syncs.erase(found);
+        }
+        break;
+    }
+
+    case TRACE_BIND_TEXTURE: {
+        GLenum target = get<GLenum>();
+        glBindTexture(target, lookUp(TEXTURE_NAMES, get<GLuint>()));
+        break;
+    }
+    case TRACE_CLEAR:
+        glClear(get<GLbitfield>());
+        break;
+    case TRACE_CLEAR_COLOR: {
+        GLclampf red = get<GLclampf>();
+        GLclampf green = get<GLclampf>();
+        GLclampf blue = get<GLclampf>();
+        GLclampf alpha = get<GLclampf>();
+        glClearColor(red, green, blue, alpha);
+        break;
+    }
+    case TRACE_DRAW_ARRAYS: {
+        GLenum mode = get<GLenum>();
+        GLint first = get<GLint>();
+        GLsizei count = get<GLsizei>();
+        glDrawArrays(mode, first, count);
+        break;
+    }
+    case TRACE_DRAW_BUFFER:
+        glDrawBuffer(colorBuffer(get<GLenum>(), drawFramebuffer));
+        break;
+    case TRACE_ENABLE:
+        glEnable(get<GLenum>());
+        break;
+    case TRACE_FINISH:
+        glFinish();
+        break;
+    case TRACE_GEN_TEXTURES:
+        generate(TEXTURE_NAMES, glGenTextures);
+        break;
+    case TRACE_DELETE_TEXTURES:
+        remove(TEXTURE_NAMES, glDeleteTextures);
+        break;
+    case TRACE_PIXEL_STOREI: {
+        GLenum pname = get<GLenum>();
+        glPixelStorei(pname, get<GLint>());
+        break;
+    }
+    case TRACE_POLYGON_MODE: {
+        GLenum face = get<GLenum>();
+        glPolygonMode(face, get<GLenum>());
+        break;
+    }
+    case TRACE_READ_BUFFER:
+        glReadBuffer(colorBuffer(get<GLenum>(), readFramebuffer));
+        break;
+    case TRACE_READ_PIXELS: {
+        GLint x = get<GLint>();
+        GLint y = get<GLint>();
+        GLsizei width = get<GLsizei>();
+        GLsizei height = get<GLsizei>();
+        GLenum format = get<GLenum>();
+        GLenum type = get<GLenum>();
+        bool packBuffer = get<unsigned char>() != 0;
+        long long offset = getSize();
+        if (packBuffer)
+            glReadPixels(x, y, width, height, format, type, (void*)(uintptr_t)offset);
+        else if (width > 0 && height > 0) {
+            pixels.resize(((size_t)width * glTexelBytes(format, type) + 8) * height); // room for any pack alignment
+            glReadPixels(x, y, width, height, format, type, &pixels[0]);
+        }
+        break;
+    }
+    case TRACE_TEX_IMAGE_2D: {
+        GLenum target = get<GLenum>();
+        GLint level = get<GLint>();
+        GLint internalFormat = get<GLint>();
+        GLsizei width = get<GLsizei>();
+        GLsizei height = get<GLsizei>();
+        GLint border = get<GLint>();
+        GLenum format = get<GLenum>();
+        GLenum type = get<GLenum>();
+        bool unpackBuffer = get<unsigned char>() != 0;
+        const void* data = unpackBuffer ? (const void*)(uintptr_t)getSize() : getOptionalData();
+        glTexImage2D(target, level, internalFormat, width, height, border, format, type, data);
+        break;
+    }
+    case TRACE_TEX_PARAMETERI: {
+        GLenum target = get<GLenum>();
+        GLenum pname = get<GLenum>();
+        glTexParameteri(target, pname, get<GLint>());
+        break;
+    }
+    case TRACE_VIEWPORT: {
+        GLint x = get<GLint>();
+        GLint y = get<GLint>();
+        GLsizei width = get<GLsizei>();
+        GLsizei height = get<GLsizei>();
+        glViewport(x, y, width, height);
+        break;
+    }
+
+    default:
+        return false;
+    }
+    return !damaged;
+}
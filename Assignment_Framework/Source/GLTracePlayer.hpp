@@ -0,0 +1,72 @@
+#ifndef GL_TRACE_PLAYER_CLASS_H
+#define GL_TRACE_PLAYER_CLASS_H
+
+#include <GL/glew.h>
+#include "GLTrace.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class GLTracePlayer {
+	/* plays a GL trace (GLTrace.hpp) in the current context as fast as it can, -playgl. The whole file is read into
+	* memory first so playing a frame only decodes the commands and calls GL.
+	* The names, uniform locations and fences in the trace are the ones the recording got, they are mapped to the ones
+	* this context hands out. Framebuffer 0 is mapped to the one given to setDefaultFramebuffer, a render target of
+	* the trace's size since the player has no window.
+	* After the last frame playFrame() goes back to the first one. The objects made during the startup are used by
+	* every frame, the ones made during the frames are made again each time around.
+	*/
+public:
+	bool open(std::string filePath); // false if it cannot be read or is not a trace
+	void setDefaultFramebuffer(GLuint framebuffer) { defaultFramebuffer = framebuffer; }
+
+	bool playStartup(); // the calls before the first frame, false if the trace is damaged
+	bool playFrame(); // the next frame
+
+	int getWidth() const { return header.width; }
+	int getHeight() const { return header.height; }
+	int getFrameCount() const { return header.frames; }
+
+private:
+	enum NameKind { BUFFER_NAMES, VERTEX_ARRAY_NAMES, SHADER_NAMES, TEXTURE_NAMES, FRAMEBUFFER_NAMES, RENDERBUFFER_NAMES,
+		QUERY_NAMES, NAME_KIND_COUNT }; // shaders and programs share their names
+
+	std::string filePath;
+	std::vector<unsigned char> trace;
+	size_t position = 0;
+	size_t firstFrame = 0; // where the first frame's commands start
+	bool damaged = false;
+
+	GLTraceHeader header = GLTraceHeader();
+
+	GLuint defaultFramebuffer = 0;
+	GLuint drawFramebuffer = 0, readFramebuffer = 0; // the trace's names
+
+	std::vector<GLuint> names[NAME_KIND_COUNT]; // this context's name of each name in the trace
+	std::unordered_map<GLuint, std::vector<GLint> > uniformLocations; // by the trace's program, then its location
+	std::vector<GLint>* programLocations = NULL; // of the program in use
+	std::unordered_map<unsigned long long, GLsync> syncs;
+	std::unordered_map<GLenum, GLuint> boundBuffers; // the trace's names, by target
+	std::unordered_map<GLuint, void*> mappings; // by the trace's buffer name
+
+	std::vector<GLuint> generated;
+	std::vector<unsigned char> pixels; // where glReadPixels reads to when the trace read into memory
+
+	template <typename T> T get();
+	long long getSize() { return get<long long>(); }
+	const void* getData(unsigned int& size); // points into the trace, NULL for none
+	const void* getOptionalData();
+
+	GLuint& name(NameKind kind, GLuint traceName);
+	GLuint lookUp(NameKind kind, GLuint traceName);
+	GLint location(GLint traceLocation);
+	GLenum colorBuffer(GLenum mode, GLuint traceFramebuffer);
+
+	void generate(NameKind kind, void (GLAPIENTRY *gen)(GLsizei, GLuint*));
+	void remove(NameKind kind, void (GLAPIENTRY *del)(GLsizei, const GLuint*));
+
+	int play(); // runs commands up to the next TRACE_FRAME or TRACE_END and returns it, -1 once damaged
+	bool execute(int command);
+};
+
+#endif
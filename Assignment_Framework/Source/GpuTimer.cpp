@@ -0,0 +1,103 @@
+#include "GpuTimer.hpp"
+
+GpuTimer::GpuTimer(int pLatency) {
+    latency = pLatency;
+    supported = false;
+}
+
+void GpuTimer::release() {
+    if (initialized && !queries.empty())
+        glDeleteQueries((GLsizei)queries.size(), &queries[0]);
+    queries.clear();
+    ready.clear();
+    initialized = supported = false; // made again if it is begun in another context
+    spanCount = collectedCount = 0;
+}
+
+void GpuTimer::initialize() {
+    // the queries are made the first time they are needed since timers can be declared before the context exists
+    initialized = true;
+    supported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    if (!supported)
+        return;
+
+    queries.resize(2 * latency);
+    glGenQueries(2 * latency, &queries[0]);
+}
+
+void GpuTimer::begin() {
+    if (!initialized)
+        initialize();
+    if (!supported)
+        return;
+
+    // the ring is full, the oldest span has to be read before its query can be reused (the GPU is far behind),
+    // not one of ready: those already gave back their queries
+    if (spanCount - collectedCount >= latency) {
+        bool available;
+        int span = collectedCount;
+        double milliseconds = readOldest(true, available);
+        ready.push_back(std::make_pair(span, milliseconds));
+    }
+
+    glQueryCounter(queries[2 * (spanCount % latency)], GL_TIMESTAMP);
+}
+
+void GpuTimer::end() {
+    if (!supported)
+        return;
+
+    glQueryCounter(queries[2 * (spanCount % latency) + 1], GL_TIMESTAMP);
+    spanCount++;
+}
+
+bool GpuTimer::collect(int& span, double& milliseconds) {
+    return supported && read(false, span, milliseconds);
+}
+
+bool GpuTimer::collectBlocking(int& span, double& milliseconds) {
+    return supported && read(true, span, milliseconds);
+}
+
+bool GpuTimer::read(bool wait, int& span, double& milliseconds) {
+    if (!ready.empty()) {
+        span = ready.front().first;
+        milliseconds = ready.front().second;
+        ready.pop_front();
+        return true;
+    }
+
+    if (collectedCount == spanCount)
+        return false;
+
+    bool available;
+    int oldest = collectedCount;
+    double oldestMilliseconds = readOldest(wait, available);
+    if (!available)
+        return false;
+    span = oldest;
+    milliseconds = oldestMilliseconds;
+    return true;
+}
+
+double GpuTimer::readOldest(bool wait, bool& available) {
+    /* reads the span at collectedCount and frees its queries, available is false (and nothing changes) when it is not
+    * done yet and wait is false
+    */
+    GLuint beginQuery = queries[2 * (collectedCount % latency)];
+    GLuint endQuery = queries[2 * (collectedCount % latency) + 1];
+    available = true;
+    if (!wait) {
+        GLint done = 0;
+        glGetQueryObjectiv(endQuery, GL_QUERY_RESULT_AVAILABLE, &done); // commands finish in order, the begin is done too
+        available = done != 0;
+        if (!available)
+            return 0.0;
+    }
+
+    GLuint64 beginTime = 0, endTime = 0;
+    glGetQueryObjectui64v(beginQuery, GL_QUERY_RESULT, &beginTime);
+    glGetQueryObjectui64v(endQuery, GL_QUERY_RESULT, &endTime);
+    collectedCount++;
+    return (endTime - beginTime) / 1000000.0;
+}
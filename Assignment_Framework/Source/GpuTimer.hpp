@@ -0,0 +1,48 @@
+#ifndef GPU_TIMER_CLASS_H
+#define GPU_TIMER_CLASS_H
+
+#include <GL/glew.h>
+#include <vector>
+#include <deque>
+#include <utility>
+
+class GpuTimer {
+	/* GPU time of a span of GL calls measured with a pair of GL_TIMESTAMP queries.
+	* Timestamps (unlike GL_TIME_ELAPSED) can overlap, so a timer around the whole frame and timers around each pass
+	* can all run at once.
+	* Results come back a few frames late: every begin() takes the next pair of a small ring and collect() only reads
+	* pairs the GPU is done with, so measuring never waits on the GPU.
+	* Needs ARB_timer_query (GL 3.3), on older contexts isSupported() is false and nothing is measured.
+	*/
+public:
+	GpuTimer(int pLatency = 3);
+	GpuTimer(const GpuTimer&) = delete; // owns GL queries
+	GpuTimer& operator=(const GpuTimer&) = delete;
+
+	void release(); // deletes the queries while the context is still current, the destructor runs too late for a global
+
+	bool isSupported() const { return supported; }
+
+	void begin(); // starts the span numbered getSpanCount()
+	void end();
+
+	bool collect(int& span, double& milliseconds); // oldest finished span, false when none is ready yet
+	bool collectBlocking(int& span, double& milliseconds); // same but waits for the GPU, for the end of a run
+
+	int getSpanCount() const { return spanCount; }
+
+private:
+	bool supported;
+	bool initialized = false;
+	int latency;
+	std::vector<GLuint> queries; // begin and end timestamp of each span of the ring
+	int spanCount = 0; // spans begun
+	int collectedCount = 0; // spans read back
+	std::deque<std::pair<int, double> > ready; // spans read back early to free their query, not collected yet
+
+	void initialize();
+	bool read(bool wait, int& span, double& milliseconds);
+	double readOldest(bool wait, bool& available); // the span at collectedCount, straight from its queries
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include "ImageWriter.hpp"
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+static std::vector<uint32_t> makeCRCTable() {
+    std::vector<uint32_t> table(256);
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t value = i;
+        for (int bit = 0; bit < 8; bit++)
+            value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+        table[i] = value;
+    }
+    return table;
+}
+
+static uint32_t crc32(const unsigned char* data, size_t size) {
+    // the CRC PNG chunks end with (ISO 3309)
+    static const std::vector<uint32_t> table = makeCRCTable();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void appendBigEndian(std::vector<unsigned char>& bytes, uint32_t value) {
+    bytes.push_back((unsigned char)(value >> 24));
+    bytes.push_back((unsigned char)(value >> 16));
+    bytes.push_back((unsigned char)(value >> 8));
+    bytes.push_back((unsigned char)value);
+}
+
+static void writeChunk(std::ofstream& file, const char* type, const std::vector<unsigned char>& data) {
+    // length, type, data, CRC of type and data
+    std::vector<unsigned char> chunk;
+    appendBigEndian(chunk, (uint32_t)data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    appendBigEndian(chunk, crc32(&chunk[4], chunk.size() - 4));
+    file.write((const char*)&chunk[0], chunk.size());
+}
+
+bool writePNG(std::string filePath, int width, int height, const unsigned char* rgba, bool bottomUp) {
+    std::ofstream file(filePath, std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Could not create file " << filePath << "." << std::endl;
+        return false;
+    }
+
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    file.write((const char*)signature, sizeof(signature));
+
+    std::vector<unsigned char> header;
+    appendBigEndian(header, width);
+    appendBigEndian(header, height);
+    header.push_back(8); // bits per channel
+    header.push_back(6); // RGBA
+    header.push_back(0); // deflate
+    header.push_back(0); // adaptive filtering
+    header.push_back(0); // not interlaced
+    writeChunk(file, "IHDR", header);
+
+    // every row starts with its filter type, 0 leaves the pixels as they are
+    size_t rowSize = (size_t)width * 4;
+    std::vector<unsigned char> raw;
+    raw.reserve((rowSize + 1) * height);
+    for (int y = 0; y < height; y++) {
+        const unsigned char* row = rgba + rowSize * (bottomUp ? height - 1 - y : y);
+        raw.push_back(0);
+        raw.insert(raw.end(), row, row + rowSize);
+    }
+
+    // zlib stream made of stored deflate blocks of at most 65535 bytes, then the Adler-32 of the raw data
+    std::vector<unsigned char> compressed;
+    compressed.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    compressed.push_back(0x78); // deflate with a 32K window
+    compressed.push_back(0x01); // no preset dictionary, check bits
+    size_t offset = 0;
+    do {
+        size_t blockSize = raw.size() - offset < 65535 ? raw.size() - offset : 65535;
+        bool last = offset + blockSize == raw.size();
+        compressed.push_back(last ? 1 : 0);
+        compressed.push_back((unsigned char)blockSize);
+        compressed.push_back((unsigned char)(blockSize >> 8));
+        compressed.push_back((unsigned char)~blockSize);
+        compressed.push_back((unsigned char)(~blockSize >> 8));
+        compressed.insert(compressed.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+        offset += blockSize;
+    } while (offset < raw.size());
+
+    uint32_t a = 1, b = 0;
+    for (unsigned char byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    appendBigEndian(compressed, (b << 16) | a);
+    writeChunk(file, "IDAT", compressed);
+
+    writeChunk(file, "IEND", std::vector<unsigned char>());
+    return file.good();
+}
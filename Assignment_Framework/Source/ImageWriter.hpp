@@ -0,0 +1,14 @@
+#ifndef IMAGE_WRITER_HEADER
+#define IMAGE_WRITER_HEADER
+
+#include <string>
+
+/* PNG files of RGBA frames, for saving what the offscreen renderer draws.
+* The image data is stored without compression (a PNG can hold uncompressed deflate blocks) which keeps writing
+* cheap and needs no zlib, at the cost of files as big as the raw pixels.
+*/
+
+// rgba is width * height pixels, bottomUp for rows in GL order (glReadPixels) since PNG starts from the top
+bool writePNG(std::string filePath, int width, int height, const unsigned char* rgba, bool bottomUp);
+
+#endif
@@ -0,0 +1,125 @@
+#include "InputRecording.hpp"
+#include <cstring>
+#include <iostream>
+
+const char RECORDING_MAGIC[4] = { 'S', 'H', 'C', 'I' };
+const uint32_t RECORDING_VERSION = 1;
+
+static void writeBytes(FILE* file, uint64_t value, int byteCount) {
+    // little endian whatever the machine is
+    unsigned char bytes[8];
+    for (int i = 0; i < byteCount; i++)
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    fwrite(bytes, 1, byteCount, file);
+}
+
+static bool readBytes(FILE* file, uint64_t& value, int byteCount) {
+    unsigned char bytes[8];
+    if (fread(bytes, 1, byteCount, file) != (size_t)byteCount)
+        return false;
+
+    value = 0;
+    for (int i = 0; i < byteCount; i++)
+        value |= (uint64_t)bytes[i] << (8 * i);
+    return true;
+}
+
+uint16_t packInput(const SimulationInput& input) {
+    // one bit per key: the six moves in RotationMove order, then space, the arrows and Y
+    uint16_t keys = 0;
+    for (int m = 0; m < MOVE_COUNT; m++)
+        keys |= (uint16_t)input.rotate[m] << m;
+    keys |= (uint16_t)input.speedUp << 6;
+    keys |= (uint16_t)input.cameraLeft << 7;
+    keys |= (uint16_t)input.cameraRight << 8;
+    keys |= (uint16_t)input.cameraUp << 9;
+    keys |= (uint16_t)input.cameraDown << 10;
+    keys |= (uint16_t)input.restart << 11;
+    return keys;
+}
+
+SimulationInput unpackInput(uint16_t keys) {
+    SimulationInput input;
+    for (int m = 0; m < MOVE_COUNT; m++)
+        input.rotate[m] = (keys >> m) & 1;
+    input.speedUp = (keys >> 6) & 1;
+    input.cameraLeft = (keys >> 7) & 1;
+    input.cameraRight = (keys >> 8) & 1;
+    input.cameraUp = (keys >> 9) & 1;
+    input.cameraDown = (keys >> 10) & 1;
+    input.restart = (keys >> 11) & 1;
+    return input;
+}
+
+bool InputRecorder::open(std::string filePath, uint64_t seed) {
+    close();
+
+    file = fopen(filePath.c_str(), "wb");
+    if (file == NULL) {
+        std::cerr << "Could not create recording " << filePath << "." << std::endl;
+        return false;
+    }
+
+    fwrite(RECORDING_MAGIC, 1, sizeof(RECORDING_MAGIC), file);
+    writeBytes(file, RECORDING_VERSION, 4);
+    writeBytes(file, seed, 8);
+    return true;
+}
+
+void InputRecorder::record(const SimulationInput& input, float dt) {
+    if (file == NULL)
+        return;
+
+    uint32_t dtBits;
+    memcpy(&dtBits, &dt, sizeof(dtBits)); // the exact float so the replay integrates the same values
+    writeBytes(file, dtBits, 4);
+    writeBytes(file, packInput(input), 2);
+}
+
+void InputRecorder::close() {
+    if (file != NULL) {
+        fclose(file);
+        file = NULL;
+    }
+}
+
+bool InputPlayer::open(std::string filePath) {
+    close();
+
+    file = fopen(filePath.c_str(), "rb");
+    if (file == NULL) {
+        std::cerr << "Could not read recording " << filePath << ". File does not exist." << std::endl;
+        return false;
+    }
+
+    char magic[4];
+    uint64_t version;
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, RECORDING_MAGIC, sizeof(magic)) != 0
+        || !readBytes(file, version, 4) || version != RECORDING_VERSION || !readBytes(file, seed, 8)) {
+        std::cerr << filePath << " is not a version " << RECORDING_VERSION << " input recording." << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool InputPlayer::next(SimulationInput& input, float& dt) {
+    if (file == NULL)
+        return false;
+
+    uint64_t dtBits, keys;
+    if (!readBytes(file, dtBits, 4) || !readBytes(file, keys, 2))
+        return false;
+
+    uint32_t bits = (uint32_t)dtBits;
+    memcpy(&dt, &bits, sizeof(dt));
+    input = unpackInput((uint16_t)keys);
+    return true;
+}
+
+void InputPlayer::close() {
+    if (file != NULL) {
+        fclose(file);
+        file = NULL;
+    }
+}
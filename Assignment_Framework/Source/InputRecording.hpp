@@ -0,0 +1,53 @@
+#ifndef INPUT_RECORDING_CLASS_H
+#define INPUT_RECORDING_CLASS_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "Simulation.hpp"
+
+/* Binary log of everything the simulation was fed, enough to play a session again tick for tick.
+* File layout (little endian):
+*	header - "SHCI", uint32 version, uint64 seed of the simulation
+*	frames - float dt, uint16 key bits (see packInput), 6 bytes per frame
+*/
+
+uint16_t packInput(const SimulationInput& input);
+
+SimulationInput unpackInput(uint16_t keys);
+
+class InputRecorder {
+public:
+	~InputRecorder() { close(); }
+
+	bool open(std::string filePath, uint64_t seed);
+
+	void record(const SimulationInput& input, float dt);
+
+	void close();
+
+	bool isOpen() const { return file != NULL; }
+
+private:
+	FILE* file = NULL;
+};
+
+class InputPlayer {
+public:
+	~InputPlayer() { close(); }
+
+	bool open(std::string filePath);
+
+	bool next(SimulationInput& input, float& dt); // false once every frame was read
+
+	void close();
+
+	bool isOpen() const { return file != NULL; }
+	uint64_t getSeed() const { return seed; }
+
+private:
+	FILE* file = NULL;
+	uint64_t seed = 0;
+};
+
+#endif
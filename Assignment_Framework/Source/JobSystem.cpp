@@ -0,0 +1,159 @@
+#include "JobSystem.hpp"
+#include "Trace.hpp"
+#include <string>
+
+// index of the calling thread in the system whose jobs it runs, the thread that made a system is 0
+static thread_local int currentWorker = 0;
+
+JobSystem::JobSystem(int pWorkerThreads) {
+    if (pWorkerThreads < 0)
+        pWorkerThreads = std::max((int)std::thread::hardware_concurrency() - 1, 0);
+
+    queuedJobs = 0;
+    for (int i = 0; i <= pWorkerThreads; i++) {
+        workers.push_back(std::unique_ptr<Worker>(new Worker()));
+        workers.back()->pool.reset(new Job[JOB_POOL_SIZE]);
+    }
+    for (int i = 1; i <= pWorkerThreads; i++)
+        threads.push_back(std::thread(&JobSystem::workerLoop, this, i));
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+Job* JobSystem::allocate() {
+    // only the owner allocates from its ring, no lock needed
+    Worker& worker = *workers[currentWorker];
+    return &worker.pool[worker.allocated++ % JOB_POOL_SIZE];
+}
+
+Job* JobSystem::create(std::function<void()> function) {
+    Job* job = allocate();
+    job->function = std::move(function);
+    job->parent = NULL;
+    job->unfinished.store(1, std::memory_order_relaxed);
+    return job;
+}
+
+Job* JobSystem::createChild(Job* parent, std::function<void()> function) {
+    parent->unfinished.fetch_add(1, std::memory_order_relaxed);
+    Job* job = create(std::move(function));
+    job->parent = parent;
+    return job;
+}
+
+void JobSystem::run(Job* job) {
+    Worker& worker = *workers[currentWorker];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.jobs.push_back(job);
+    }
+    wakeWorker();
+}
+
+void JobSystem::runBackground(Job* job) {
+    if (threads.empty()) {
+        run(job); // nobody else would ever run it
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        backgroundJobs.push_back(job);
+    }
+    wakeWorker();
+}
+
+void JobSystem::wakeWorker() {
+    // the lock makes sure a worker about to sleep either sees the job or gets the notification
+    queuedJobs.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeUp.notify_one();
+}
+
+void JobSystem::wait(const Job* job) {
+    while (!isDone(job)) {
+        Job* next = getJob(currentWorker);
+        if (next != NULL)
+            execute(next);
+        else
+            std::this_thread::yield(); // what is left is running on other workers
+    }
+}
+
+Job* JobSystem::getJob(int workerIndex) {
+    Job* job = NULL;
+    {
+        Worker& worker = *workers[workerIndex];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.jobs.empty()) {
+            job = worker.jobs.back();
+            worker.jobs.pop_back();
+        }
+    }
+
+    // steal, starting from the next worker so the thieves spread out
+    for (size_t i = 1; job == NULL && i < workers.size(); i++) {
+        Worker& victim = *workers[(workerIndex + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+        }
+    }
+
+    if (job != NULL)
+        queuedJobs.fetch_sub(1);
+    return job;
+}
+
+Job* JobSystem::getBackgroundJob() {
+    std::lock_guard<std::mutex> lock(backgroundMutex);
+    if (backgroundJobs.empty())
+        return NULL;
+    Job* job = backgroundJobs.front();
+    backgroundJobs.pop_front();
+    queuedJobs.fetch_sub(1);
+    return job;
+}
+
+void JobSystem::execute(Job* job) {
+    job->function();
+    job->function = nullptr; // lets go of what it captured now rather than when the slot comes around again
+    finish(job);
+}
+
+void JobSystem::finish(Job* job) {
+    // the job can be reused as soon as it is done, the parent has to be read before
+    Job* parent = job->parent;
+    if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1 && parent != NULL)
+        finish(parent);
+}
+
+void JobSystem::workerLoop(int workerIndex) {
+    currentWorker = workerIndex;
+    traceSetThreadName("jobs " + std::to_string(workerIndex));
+
+    while (true) {
+        Job* job = getJob(workerIndex);
+        if (job == NULL)
+            job = getBackgroundJob(); // only once there is nothing else
+        if (job != NULL) {
+            execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this] { return queuedJobs.load() > 0 || stopping; });
+        if (stopping)
+            return;
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef JOB_SYSTEM_CLASS_H
+#define JOB_SYSTEM_CLASS_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Job {
+	std::function<void()> function;
+	Job* parent; // told when this job and all its children are done, NULL for none
+	std::atomic<int> unfinished; // the job itself plus its children that are not done yet
+};
+
+class JobSystem {
+	/* Runs small CPU jobs (culling, transforms, text layout, decoding assets) on every core. GL calls stay on the
+	* thread that made the system, jobs only prepare data for it.
+	* Each worker has its own deque: it pushes and pops its jobs at the back, newest first while they are still in
+	* its cache, and a worker that runs out steals the oldest job at the front of another one's.
+	* A job created with createChild() keeps its parent unfinished until the child is done too, so waiting on one root
+	* job waits on a whole tree of them. wait() runs other jobs instead of blocking, the calling thread is a worker too.
+	* Long jobs that nothing waits on (decoding assets) go to runBackground() instead: one shared queue the worker
+	* threads only take from when their deques and the others' are empty, and wait() never takes from, so a frame
+	* waiting on its own batches does not end up running a decode. Without worker threads they are run like any job.
+	* Jobs come from a ring of JOB_POOL_SIZE per thread that is never freed: a thread can have at most that many of
+	* the jobs it created in flight at once.
+	* run(), wait() and parallelFor() can only be called from inside its jobs and from one other thread: the one that
+	* made the system, or a thread it handed the work over to (the render thread, once the main thread only simulates).
+	*/
+public:
+	JobSystem(int pWorkerThreads = -1); // -1 for one per core besides the calling thread
+	~JobSystem();
+
+	Job* create(std::function<void()> function);
+	Job* createChild(Job* parent, std::function<void()> function); // before the parent is run, or from inside it
+	void run(Job* job);
+	void runBackground(Job* job); // low priority, see above
+	void wait(const Job* job);
+	bool isDone(const Job* job) const { return job->unfinished.load(std::memory_order_acquire) == 0; }
+
+	// calls function(begin, end) on batches covering [0, count) on all the workers, returns when every batch is done
+	template <typename Function>
+	void parallelFor(int count, int batchSize, const Function& function);
+
+	int getWorkerCount() const { return (int)workers.size(); } // the calling thread included
+
+	static const int JOB_POOL_SIZE = 4096;
+
+private:
+	struct Worker {
+		std::unique_ptr<Job[]> pool;
+		unsigned int allocated = 0;
+
+		std::mutex mutex;
+		std::deque<Job*> jobs;
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers; // workers[0] is the thread that made the system
+	std::vector<std::thread> threads;
+
+	std::mutex backgroundMutex;
+	std::deque<Job*> backgroundJobs; // oldest first
+
+	// workers with nothing to do sleep until a job is queued
+	std::atomic<int> queuedJobs;
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+	bool stopping = false;
+
+	Job* allocate();
+	Job* getJob(int workerIndex);
+	Job* getBackgroundJob();
+	void wakeWorker();
+	void execute(Job* job);
+	void finish(Job* job);
+	void workerLoop(int workerIndex);
+};
+
+template <typename Function>
+void JobSystem::parallelFor(int count, int batchSize, const Function& function) {
+	/* batchSize - items per job, 0 to split the work in a few jobs per worker
+	* keep batches big enough that a job does at least a few microseconds of work
+	*/
+	if (count <= 0)
+		return;
+	if (batchSize <= 0)
+		batchSize = (count + getWorkerCount() * 4 - 1) / (getWorkerCount() * 4);
+	batchSize = std::max(batchSize, (count + JOB_POOL_SIZE / 2 - 1) / (JOB_POOL_SIZE / 2)); // leaves room in the pool
+
+	Job* root = create([] {});
+	for (int begin = 0; begin < count; begin += batchSize) {
+		int end = std::min(begin + batchSize, count);
+		run(createChild(root, [&function, begin, end] { function(begin, end); }));
+	}
+	run(root);
+	wait(root);
+}
+
+inline JobSystem& jobSystem() {
+	static JobSystem jobs; // shared by the whole game, its workers start the first time it is used
+	return jobs;
+}
+
+#endif
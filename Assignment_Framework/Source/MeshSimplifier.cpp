@@ -0,0 +1,469 @@
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+using namespace glm;
+
+namespace {
+
+struct Quadric { // symmetric 4x4 error quadric (Garland & Heckbert), stored as the upper triangle
+	double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+	void addPlane(dvec3 n, double d, double weight) {
+		a2 += weight * n.x * n.x; ab += weight * n.x * n.y; ac += weight * n.x * n.z; ad += weight * n.x * d;
+		b2 += weight * n.y * n.y; bc += weight * n.y * n.z; bd += weight * n.y * d;
+		c2 += weight * n.z * n.z; cd += weight * n.z * d;
+		d2 += weight * d * d;
+	}
+
+	void add(const Quadric& q) {
+		a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+		b2 += q.b2; bc += q.bc; bd += q.bd;
+		c2 += q.c2; cd += q.cd;
+		d2 += q.d2;
+	}
+
+	double error(dvec3 p) const { // sum of squared distances from p to every plane accumulated in the quadric
+		return a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x
+			+ b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y
+			+ c2 * p.z * p.z + 2 * cd * p.z
+			+ d2;
+	}
+};
+
+struct Collapse {
+	double cost;
+	int a, b; // b gets merged into a
+	int versionA, versionB;
+	vec3 target;
+
+	bool operator>(const Collapse& other) const { return cost > other.cost; }
+};
+
+struct WeldedMesh {
+	vector<vec3> positions;
+	vector<vec3> normals;
+	vector<vec2> UVs;
+	vector<int> triangles; // 3 indices per triangle
+};
+
+WeldedMesh weldVertices(const vector<vec3>& vertices, const vector<vec3>& normals, const vector<vec2>& UVs) {
+	/* OBJ meshes come in as triangle soup, so corners that share a position and a UV are merged to recover the
+	* connectivity the simplifier needs. Normals are averaged over the merged corners, except across a crease: a corner
+	* whose normal is more than creaseAngle away from the vertex's first one starts a vertex of its own.
+	* A UV seam or a hard edge is then an open edge of the welded mesh, so it gets the same boundary planes as the
+	* silhouette and the coarser levels keep their texture and their facets.
+	*/
+	const float creaseCosine = 0.5f; // 60 degrees
+	WeldedMesh mesh;
+	vector<vec3> firstNormals; // the normal each welded vertex was created with, to test the crease against
+	unordered_map<string, vector<int>> lookup; // the welded vertices at a position and UV, one per side of a crease
+	lookup.reserve(vertices.size());
+
+	for (size_t i = 0; i < vertices.size(); i++) {
+		vec2 UV = i < UVs.size() ? UVs[i] : vec2(0.0f);
+		vec3 normal = i < normals.size() ? normals[i] : vec3(0.0f);
+
+		// exact bit match is enough, OBJ corners reference the same "v" and "vt" lines
+		string key = string((const char*)&vertices[i], sizeof(vec3)) + string((const char*)&UV, sizeof(vec2));
+		vector<int>& candidates = lookup[key];
+		int index = -1;
+		for (int candidate : candidates) {
+			vec3 first = firstNormals[candidate];
+			if (length(first) <= 0.0f || length(normal) <= 0.0f || dot(normalize(first), normalize(normal)) >= creaseCosine) {
+				index = candidate;
+				break;
+			}
+		}
+
+		if (index < 0) {
+			index = (int)mesh.positions.size();
+			candidates.push_back(index);
+			mesh.positions.push_back(vertices[i]);
+			mesh.normals.push_back(vec3(0.0f));
+			mesh.UVs.push_back(UV);
+			firstNormals.push_back(normal);
+		}
+
+		mesh.normals[index] += normal;
+		mesh.triangles.push_back(index);
+	}
+
+	mesh.triangles.resize(mesh.triangles.size() - mesh.triangles.size() % 3);
+	return mesh;
+}
+
+dvec3 triangleNormal(vec3 p0, vec3 p1, vec3 p2) {
+	return cross(dvec3(p1) - dvec3(p0), dvec3(p2) - dvec3(p0));
+}
+
+class Simplifier {
+public:
+	Simplifier(const WeldedMesh& pMesh) : mesh(pMesh) {
+		int vertexCount = (int)mesh.positions.size();
+		int triangleCount = (int)mesh.triangles.size() / 3;
+
+		quadrics.resize(vertexCount);
+		vertexPlanes.resize(vertexCount);
+		vertexTriangles.resize(vertexCount);
+		vertexVersion.assign(vertexCount, 0);
+		vertexRemoved.assign(vertexCount, false);
+		triangleRemoved.assign(triangleCount, false);
+		liveTriangles = 0;
+
+		// the vertices on a UV seam or a hard edge have a twin at the same position on the other side, moving one
+		// without the other would open a crack, so they stay where they are
+		vertexLocked.assign(vertexCount, false);
+		unordered_map<string, int> firstAtPosition;
+		for (int v = 0; v < vertexCount; v++) {
+			string key((const char*)&mesh.positions[v], sizeof(vec3));
+			auto found = firstAtPosition.find(key);
+			if (found == firstAtPosition.end())
+				firstAtPosition[key] = v;
+			else
+				vertexLocked[v] = vertexLocked[found->second] = true;
+		}
+
+		for (int t = 0; t < triangleCount; t++) {
+			int* tri = &mesh.triangles[3 * t];
+			if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2]) { // degenerate after welding
+				triangleRemoved[t] = true;
+				continue;
+			}
+			liveTriangles++;
+
+			dvec3 n = triangleNormal(mesh.positions[tri[0]], mesh.positions[tri[1]], mesh.positions[tri[2]]);
+			double area = length(n);
+			if (area <= 0.0)
+				continue;
+			n /= area;
+			double d = -dot(n, dvec3(mesh.positions[tri[0]]));
+
+			int plane = addPlane(n, d);
+			for (int k = 0; k < 3; k++) {
+				quadrics[tri[k]].addPlane(n, d, 1.0);
+				vertexPlanes[tri[k]].push_back(plane);
+				vertexTriangles[tri[k]].push_back(t);
+			}
+		}
+
+		addBoundaryConstraints();
+		for (vector<int>& vertexPlaneList : vertexPlanes)
+			sort(vertexPlaneList.begin(), vertexPlaneList.end());
+
+		for (int t = 0; t < triangleCount; t++) {
+			if (triangleRemoved[t])
+				continue;
+			int* tri = &mesh.triangles[3 * t];
+			for (int k = 0; k < 3; k++) {
+				int a = tri[k], b = tri[(k + 1) % 3];
+				if (a < b) // every interior edge is seen twice, only queue it once
+					pushCollapse(a, b);
+				else if (isBoundaryEdge(a, b))
+					pushCollapse(b, a);
+			}
+		}
+	}
+
+	int triangleCount() const { return liveTriangles; }
+
+	float getError() const { return (float)maxDeviation; }
+
+	void simplifyTo(int targetTriangles) {
+		while (liveTriangles > targetTriangles && !queue.empty()) {
+			Collapse collapse = queue.top();
+			queue.pop();
+
+			if (vertexRemoved[collapse.a] || vertexRemoved[collapse.b])
+				continue;
+			if (vertexVersion[collapse.a] != collapse.versionA || vertexVersion[collapse.b] != collapse.versionB)
+				continue; // stale entry, a newer one was queued when a neighbour collapsed
+
+			if (flipsTriangles(collapse.a, collapse.b, collapse.target) || flipsTriangles(collapse.b, collapse.a, collapse.target))
+				continue;
+
+			applyCollapse(collapse);
+		}
+	}
+
+	SimplifiedMesh extract() const {
+		SimplifiedMesh out;
+		out.geometricError = getError();
+
+		for (size_t t = 0; t < triangleRemoved.size(); t++) {
+			if (triangleRemoved[t])
+				continue;
+			for (int k = 0; k < 3; k++) {
+				int v = mesh.triangles[3 * t + k];
+				out.vertices.push_back(mesh.positions[v]);
+				out.normals.push_back(length(mesh.normals[v]) > 0.0f ? normalize(mesh.normals[v]) : vec3(0.0f, 1.0f, 0.0f));
+				out.UVs.push_back(mesh.UVs[v]);
+			}
+		}
+		return out;
+	}
+
+private:
+	WeldedMesh mesh;
+	vector<Quadric> quadrics;
+	vector<vector<int>> vertexTriangles;
+	vector<int> vertexVersion;
+	vector<bool> vertexRemoved;
+	vector<bool> vertexLocked;
+	vector<bool> triangleRemoved;
+	priority_queue<Collapse, vector<Collapse>, greater<Collapse>> queue;
+	int liveTriangles;
+
+	/* the quadrics are weighted and sum squared distances, fine to order the collapses but not a distance.
+	* Each vertex also keeps the original planes it stands for, unweighted, and the error of a level is the farthest
+	* any vertex ended up from one of its planes, in object space units.
+	*/
+	vector<dvec4> planes; // normal and d
+	vector<vector<int>> vertexPlanes; // sorted indices in planes
+	double maxDeviation = 0.0;
+
+	int addPlane(dvec3 n, double d) {
+		planes.push_back(dvec4(n, d));
+		return (int)planes.size() - 1;
+	}
+
+	double planeDeviation(int v, vec3 position) const {
+		double deviation = 0.0;
+		for (int plane : vertexPlanes[v])
+			deviation = std::max(deviation, fabs(dot(dvec3(planes[plane]), dvec3(position)) + planes[plane].w));
+		return deviation;
+	}
+
+	int edgeTriangleCount(int a, int b) const {
+		int count = 0;
+		for (int t : vertexTriangles[a]) {
+			if (triangleRemoved[t])
+				continue;
+			const int* tri = &mesh.triangles[3 * t];
+			if (tri[0] == b || tri[1] == b || tri[2] == b)
+				count++;
+		}
+		return count;
+	}
+
+	bool isBoundaryEdge(int a, int b) const { return edgeTriangleCount(a, b) == 1; }
+
+	void addBoundaryConstraints() {
+		/* open edges only have one plane constraining them, so without help the simplifier happily eats away at the
+		* silhouette of the mesh. A heavily weighted plane perpendicular to the face along each open edge keeps it in place.
+		* The UV seams and hard edges split by weldVertices are open edges too, so they are held the same way.
+		*/
+		const double boundaryWeight = 100.0;
+
+		for (size_t t = 0; t < triangleRemoved.size(); t++) {
+			if (triangleRemoved[t])
+				continue;
+			const int* tri = &mesh.triangles[3 * t];
+			dvec3 faceNormal = triangleNormal(mesh.positions[tri[0]], mesh.positions[tri[1]], mesh.positions[tri[2]]);
+			if (length(faceNormal) <= 0.0)
+				continue;
+
+			for (int k = 0; k < 3; k++) {
+				int a = tri[k], b = tri[(k + 1) % 3];
+				if (!isBoundaryEdge(a, b))
+					continue;
+
+				dvec3 edge = dvec3(mesh.positions[b]) - dvec3(mesh.positions[a]);
+				dvec3 n = cross(edge, faceNormal);
+				if (length(n) <= 0.0)
+					continue;
+				n = normalize(n);
+				double d = -dot(n, dvec3(mesh.positions[a]));
+				quadrics[a].addPlane(n, d, boundaryWeight);
+				quadrics[b].addPlane(n, d, boundaryWeight);
+				int plane = addPlane(n, d);
+				vertexPlanes[a].push_back(plane);
+				vertexPlanes[b].push_back(plane);
+			}
+		}
+	}
+
+	void pushCollapse(int a, int b) {
+		/* candidate positions are both endpoints and the midpoint. Staying on an existing vertex keeps its normal and
+		* UV valid, which matters more for our textured OBJs than the last bit of accuracy from the optimal position.
+		* A locked vertex is only ever collapsed into, on its own position.
+		*/
+		if (vertexLocked[b])
+			std::swap(a, b);
+		if (vertexLocked[b])
+			return; // both locked
+
+		Quadric q = quadrics[a];
+		q.add(quadrics[b]);
+
+		vec3 candidates[3] = { mesh.positions[a], mesh.positions[b], 0.5f * (mesh.positions[a] + mesh.positions[b]) };
+		int candidateCount = vertexLocked[a] ? 1 : 3;
+		Collapse best;
+		best.cost = -1.0;
+
+		for (int i = 0; i < candidateCount; i++) {
+			double cost = q.error(dvec3(candidates[i]));
+			if (best.cost < 0.0 || cost < best.cost) {
+				best.cost = cost;
+				best.target = candidates[i];
+			}
+		}
+
+		best.a = a;
+		best.b = b;
+		best.versionA = vertexVersion[a];
+		best.versionB = vertexVersion[b];
+		queue.push(best);
+	}
+
+	bool flipsTriangles(int moving, int other, vec3 target) const {
+		// reject collapses that would turn a surrounding triangle inside out or squash it into a sliver
+		for (int t : vertexTriangles[moving]) {
+			if (triangleRemoved[t])
+				continue;
+			const int* tri = &mesh.triangles[3 * t];
+			if (tri[0] == other || tri[1] == other || tri[2] == other)
+				continue; // this one disappears with the edge
+
+			vec3 before[3], after[3];
+			for (int k = 0; k < 3; k++) {
+				before[k] = mesh.positions[tri[k]];
+				after[k] = tri[k] == moving ? target : before[k];
+			}
+
+			dvec3 n0 = triangleNormal(before[0], before[1], before[2]);
+			dvec3 n1 = triangleNormal(after[0], after[1], after[2]);
+			double l0 = length(n0), l1 = length(n1);
+			if (l1 <= 0.0)
+				return true;
+			if (l0 > 0.0 && dot(n0 / l0, n1 / l1) < 0.2)
+				return true;
+		}
+		return false;
+	}
+
+	void applyCollapse(const Collapse& collapse) {
+		int a = collapse.a, b = collapse.b;
+
+		if (collapse.target != mesh.positions[a]) {
+			if (collapse.target == mesh.positions[b]) {
+				mesh.normals[a] = mesh.normals[b];
+				mesh.UVs[a] = mesh.UVs[b];
+			}
+			else {
+				mesh.normals[a] += mesh.normals[b];
+				mesh.UVs[a] = 0.5f * (mesh.UVs[a] + mesh.UVs[b]);
+			}
+		}
+		mesh.positions[a] = collapse.target;
+		quadrics[a].add(quadrics[b]);
+
+		vector<int> merged;
+		set_union(vertexPlanes[a].begin(), vertexPlanes[a].end(), vertexPlanes[b].begin(), vertexPlanes[b].end(), back_inserter(merged));
+		vertexPlanes[a].swap(merged);
+		vertexPlanes[b].clear();
+		maxDeviation = std::max(maxDeviation, planeDeviation(a, collapse.target));
+
+		for (int t : vertexTriangles[b]) {
+			if (triangleRemoved[t])
+				continue;
+			int* tri = &mesh.triangles[3 * t];
+			if (tri[0] == a || tri[1] == a || tri[2] == a) { // triangle shared by the edge collapses to nothing
+				triangleRemoved[t] = true;
+				liveTriangles--;
+				continue;
+			}
+			for (int k = 0; k < 3; k++) {
+				if (tri[k] == b)
+					tri[k] = a;
+			}
+			vertexTriangles[a].push_back(t);
+		}
+
+		vertexRemoved[b] = true;
+		vertexTriangles[b].clear();
+		vertexVersion[a]++;
+
+		// drop dead triangles from a's list and requeue every edge touching a with the new quadric
+		vector<int>& around = vertexTriangles[a];
+		around.erase(remove_if(around.begin(), around.end(), [this](int t) { return (bool)triangleRemoved[t]; }), around.end());
+
+		vector<int> neighbours;
+		for (int t : around) {
+			const int* tri = &mesh.triangles[3 * t];
+			for (int k = 0; k < 3; k++) {
+				if (tri[k] != a && find(neighbours.begin(), neighbours.end(), tri[k]) == neighbours.end())
+					neighbours.push_back(tri[k]);
+			}
+		}
+		for (int n : neighbours)
+			pushCollapse(a, n);
+	}
+};
+
+}
+
+float getBoundingRadius(const vector<vec3>& vertices) {
+	// measured from the center of the bounds, an OBJ is not always modelled around its origin
+	if (vertices.empty())
+		return 0.0f;
+	vec3 low = vertices[0], high = vertices[0];
+	for (const vec3& vertex : vertices) {
+		low = glm::min(low, vertex);
+		high = glm::max(high, vertex);
+	}
+	vec3 center = 0.5f * (low + high);
+
+	float radius = 0.0f;
+	for (const vec3& vertex : vertices)
+		radius = std::max(radius, length(vertex - center));
+	return radius;
+}
+
+vector<SimplifiedMesh> buildLODChain(const vector<vec3>& vertices, const vector<vec3>& normals, const vector<vec2>& UVs,
+	int levelCount, float reductionPerLevel, int minTriangles) {
+	/* builds a chain of progressively coarser meshes with quadric error edge collapses
+	*
+	*	vertices, normals, UVs - triangle soup as returned by loadOBJ, used unchanged as LOD 0
+	*	levelCount - maximum number of levels including LOD 0
+	*	reductionPerLevel - fraction of the triangles kept from one level to the next
+	*	minTriangles - stop generating levels once a mesh gets this small
+	*
+	* all levels come from a single simplification run, so each level's error is measured against the original mesh
+	*/
+	vector<SimplifiedMesh> chain;
+
+	SimplifiedMesh original;
+	original.vertices = vertices;
+	original.normals = normals;
+	original.UVs = UVs;
+	original.geometricError = 0.0f;
+	chain.push_back(original);
+
+	if (vertices.size() < 3)
+		return chain;
+
+	Simplifier simplifier(weldVertices(vertices, normals, UVs));
+	int target = simplifier.triangleCount();
+
+	for (int level = 1; level < levelCount; level++) {
+		target = (int)(target * reductionPerLevel);
+		if (target < minTriangles)
+			break;
+
+		int before = simplifier.triangleCount();
+		simplifier.simplifyTo(target);
+		if (simplifier.triangleCount() >= before)
+			break; // nothing left that can be collapsed safely
+
+		chain.push_back(simplifier.extract());
+	}
+
+	return chain;
+}
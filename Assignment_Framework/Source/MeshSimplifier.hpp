@@ -0,0 +1,27 @@
+#ifndef MESH_SIMPLIFIER_HEADER
+#define MESH_SIMPLIFIER_HEADER
+
+#include <glm/glm.hpp>
+#include <vector>
+
+struct SimplifiedMesh {
+	// non-indexed triangle list in the same layout loadOBJ produces so it can go straight into setupModelVBO's buffers
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> UVs;
+
+	// farthest a vertex moved off the original surface around it to reach this level (object space units), 0 for the source mesh
+	float geometricError = 0.0f;
+};
+
+std::vector<SimplifiedMesh> buildLODChain(
+	const std::vector<glm::vec3>& vertices,
+	const std::vector<glm::vec3>& normals,
+	const std::vector<glm::vec2>& UVs,
+	int levelCount,
+	float reductionPerLevel,
+	int minTriangles);
+
+float getBoundingRadius(const std::vector<glm::vec3>& vertices);
+
+#endif
@@ -1,4 +1,6 @@
 #include "Model.hpp"
+#include "AssetPack.hpp"
+
 
 Model::Model(std::string pFilePath, glm::vec3 pPOS, GLfloat pScale, GLenum pDrawMode) {
     filePath = pFilePath;
@@ -42,6 +44,10 @@ Model::Model(std::string pFilePath, glm::vec3 pPOS, GLuint pTexture) {
     initializeModel();
 }
 
+Model::Model(std::vector<cubeInfo> pInformation, glm::vec3 pPOS, GLfloat pScale, GLenum pDrawMode) : Model("", pPOS, pScale, pDrawMode) {
+    information = pInformation;
+}
+
 void Model::resetModel() {
     POS = initialPOS;
     rotationQuat = initialQuat;
@@ -54,63 +60,102 @@ void Model::linkVAO(GLuint pVAO, int pActiveVertices) {
     activeVertices = pActiveVertices;
 }
 
+void Model::linkLODs(LODChain pLODChain) {
+    lodChain = pLODChain;
+    if (!lodChain.levels.empty())
+        linkVAO(lodChain.levels[0].VAO, lodChain.levels[0].vertexCount);
+}
+
+int Model::selectLOD(float objectScale, const LODSettings& lodSettings) {
+    /* picks the coarsest level whose error stays under the screen space threshold of the pass
+    *
+    *   objectScale - scale applied to the mesh when it is drawn
+    *   lodSettings - view of the pass being rendered
+    *
+    * returns the index in the LOD chain, -1 if the model has no chain
+    */
+    if (lodChain.levels.empty())
+        return -1;
+
+    float distance = glm::length(POS - lodSettings.viewPosition);
+    float worldRadius = lodChain.boundingRadius * objectScale;
+    if (lodSettings.pixelsPerUnit <= 0.0f || worldRadius <= 0.0f || distance <= worldRadius)
+        return 0; // no projection info or the viewer is inside the model
+
+    // projected radius of the bounding sphere in pixels, errors are scaled relative to it
+    float projectedRadius = worldRadius * lodSettings.pixelsPerUnit / distance;
+    float maxError = lodSettings.errorThreshold * lodSettings.errorScale;
+
+    for (int i = (int)lodChain.levels.size() - 1; i > 0; i--) {
+        float screenError = lodChain.levels[i].geometricError / lodChain.boundingRadius * projectedRadius;
+        if (screenError <= maxError)
+            return i;
+    }
+    return 0;
+}
+
 void Model::render(GLuint shaderProgram, bool enableTextures) { render(shaderProgram, enableTextures, glm::mat4(1.0f)); }
 
 void Model::render(GLuint shaderProgram, bool enableTextures, glm::mat4 baseMatrix) {
-    //initializeModel(); // will make the model reread the csv file every draw - Uncomment if you want to make the objects in real time
-    glUniform3fv(glGetUniformLocation(shaderProgram, "material.color"), 1, &material.color[0]);
-    glUniform1f(glGetUniformLocation(shaderProgram, "material.shininess"), material.shininess);
-
-    glUniform1i(glGetUniformLocation(shaderProgram, "enableTextures"), enableTextures);
-    
+    CommandList commands;
+    record(commands, enableTextures, LODSettings(), baseMatrix); // no view given, full detail
+    commands.execute(shaderProgram);
+}
 
+void Model::record(CommandList& list, bool enableTextures, const LODSettings& lodSettings, glm::mat4 baseMatrix) {
+    //initializeModel(); // will make the model reread the csv file every draw - Uncomment if you want to make the objects in real time
+    DrawUniforms uniforms;
+    uniforms.materialColor = material.color;
+    uniforms.materialShininess = material.shininess;
+    uniforms.enableTextures = enableTextures;
 
-    glBindVertexArray(VAO);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    // allow for texture wrapping
+    uniforms.texWrapX = texWrapX;
+    uniforms.texWrapY = texWrapY;
+    uniforms.textureLayer = (float)textureLayer;
 
     baseMatrix = glm::translate(baseMatrix, POS); 
     baseMatrix = baseMatrix * toMat4(rotationQuat);
 
-    // allow for texture wrapping
-    glUniform1f(glGetUniformLocation(shaderProgram, "texWrapX"), texWrapX);
-    glUniform1f(glGetUniformLocation(shaderProgram, "texWrapY"), texWrapY);
-
-    GLuint worldMatrixLocation = glGetUniformLocation(shaderProgram, "worldMatrix");
-
     for (cubeInfo info : information) {
         glm::vec3 localCoord = scale * glm::vec3(info.posX, info.posY, info.posZ);
         glm::vec3 scalingVector = scale * glm::vec3(info.scaleX, info.scaleY, info.scaleZ);
 
         // transformation of the base matrix
-        glm::mat4 cubeWorldMatrix = glm::translate(baseMatrix, localCoord);
-        cubeWorldMatrix = glm::scale(cubeWorldMatrix, scalingVector);
+        uniforms.worldMatrix = glm::translate(baseMatrix, localCoord);
+        uniforms.worldMatrix = glm::scale(uniforms.worldMatrix, scalingVector);
+
+        // swap in a coarser mesh when the model is small on screen
+        GLuint cubeVAO = VAO;
+        int vertexCount = activeVertices;
+        int lod = selectLOD(glm::max(scalingVector.x, glm::max(scalingVector.y, scalingVector.z)), lodSettings);
+        if (lod >= 0) {
+            cubeVAO = lodChain.levels[lod].VAO;
+            vertexCount = lodChain.levels[lod].vertexCount;
+        }
 
-        // draw the cube
-        glUniformMatrix4fv(worldMatrixLocation, 1, GL_FALSE, &cubeWorldMatrix[0][0]);
+        // draws of the same mesh and texture (or texture array) end up together once the list is sorted
+        uint64_t sortKey = CommandList::makeSortKey(cubeVAO, texture);
+        list.bind(sortKey, cubeVAO, texture, textureLayer >= 0 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D);
+        list.setUniformBlock(sortKey, uniforms);
 
         // change the draw mode of the model being rendered
         if (drawMode == GL_TRIANGLES)
-            glDrawArrays(GL_TRIANGLES, 0, activeVertices);
-        else if (drawMode == GL_LINES) {
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); // turn on wireframe
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL); // turn off wireframe
-        }
+            list.draw(sortKey, GL_TRIANGLES, 0, vertexCount);
+        else if (drawMode == GL_LINES)
+            list.draw(sortKey, GL_TRIANGLES, 0, 36, GL_LINE); // wireframe
         else if (drawMode == GL_POINTS)
-            glDrawArrays(GL_POINTS, 0, 36);
+            list.draw(sortKey, GL_POINTS, 0, 36);
         else
             std::cerr << "Invalid draw type. Renderer supports: GL_TRIANGLES, GL_LINES, GL_POINTS" << std::endl;
     }
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glBindVertexArray(0);
 }
 
 void Model::render(GLuint shaderProgram) { render(shaderProgram, true); }
 
-void Model::linkTexture(GLuint pTexture) {
+void Model::linkTexture(GLuint pTexture, int pTextureLayer) {
     texture = pTexture;
+    textureLayer = pTextureLayer;
 }
 
 void Model::setMaterial(Material pMaterial) {
@@ -122,22 +167,31 @@ void Model::updateFilePath(std::string pFilePath) {
     initializeModel(); // have to reread the file
 }
 
+void Model::updateCubes(std::vector<cubeInfo> pInformation) {
+    filePath.clear(); // there is no file to reread
+    information = pInformation;
+}
+
 std::string Model::getFilePath() {
     return filePath;
 }
 
 void Model::initializeModel() {
-    information.clear();
     if (filePath.empty()) { // add support for simple shapes
+        information.clear();
         information.push_back(cubeInfo(0, 0, 0, 1, 1, 1));
         return;
     }
+    information = readCubes(filePath);
+}
 
-    std::ifstream fileStream(filePath, std::ios::in);
+std::vector<cubeInfo> Model::readCubes(std::string pFilePath) {
+    std::vector<cubeInfo> cubes;
+    AssetStream fileStream(assets().open(pFilePath));
 
-    if (!fileStream.is_open()) {
-        std::cerr << "Could not read file " << filePath << ". File does not exist." << std::endl;
-        return;
+    if (!fileStream.isOpen()) {
+        std::cerr << "Could not read file " << pFilePath << ". File does not exist." << std::endl;
+        return cubes;
     }
 
     std::string value, line = "";
@@ -171,6 +225,7 @@ void Model::initializeModel() {
         }
 
         if (!(j < 6))
-            information.push_back(cubeInfo(cubeInformation[0], cubeInformation[1], cubeInformation[2], cubeInformation[3], cubeInformation[4], cubeInformation[5]));
+            cubes.push_back(cubeInfo(cubeInformation[0], cubeInformation[1], cubeInformation[2], cubeInformation[3], cubeInformation[4], cubeInformation[5]));
     }
+    return cubes;
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define MODEL_CLASS_H
 
 #include <GL/glew.h>
+#include "GLMetrics.hpp"
+#include "CommandList.hpp"
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -51,12 +53,32 @@ struct cubeInfo {
     }
 };
 
+struct LODLevel {
+    GLuint VAO;
+    int vertexCount;
+    float geometricError; // object space error of this level compared to the full detail mesh
+};
+
+struct LODChain {
+    vector<LODLevel> levels; // levels[0] is the full detail mesh
+    float boundingRadius = 0.0f;
+};
+
+struct LODSettings { // describes the view of the pass being rendered so models can pick a level of detail
+    vec3 viewPosition = vec3(0.0f);
+    float pixelsPerUnit = 0.0f; // viewport height / (2 * tan(FOV / 2)), 0 always renders full detail
+    float errorThreshold = 1.0f; // largest tolerated screen space error in pixels
+    float errorScale = 1.0f; // multiplier on the threshold so a pass can ask for coarser levels (shadows)
+};
+
 class Model {
 public:
     Model(string pFilePath, vec3 pPOS, GLfloat pScale, GLenum pDrawMode);
 
     Model(string pFilePath, vec3 pPOS, GLuint pTexture);
 
+    Model(vector<cubeInfo> pInformation, vec3 pPOS, GLfloat pScale, GLenum pDrawMode); // cubes made in memory instead of read from a file
+
     void resetModel();
 
     void render(GLuint shaderProgram);
@@ -65,14 +87,25 @@ public:
 
     void render(GLuint shaderProgram, bool enableTextures, mat4 baseMatrix);
 
+    // adds the draws of the model to list without any GL call, so it can run on any thread
+    void record(CommandList& list, bool enableTextures, const LODSettings& lodSettings, mat4 baseMatrix = mat4(1.0f));
+
     void linkVAO(GLuint pVAO, int pActiveVertices);
 
-    void linkTexture(GLuint pTexture);
+    void linkLODs(LODChain pLODChain);
+
+    int selectLOD(float objectScale, const LODSettings& lodSettings);
+
+    void linkTexture(GLuint pTexture, int pTextureLayer = -1); // pTextureLayer - layer of the texture array pTexture, -1 for a 2D texture
 
     void setMaterial(Material pMaterial);
 
     void updateFilePath(std::string pFilePath);
 
+    void updateCubes(vector<cubeInfo> pInformation);
+
+    static vector<cubeInfo> readCubes(string pFilePath); // parses a shape CSV, touches no GL so it can run on any thread
+
     string getFilePath();
 
     vec3 POS;
@@ -85,7 +118,6 @@ public:
     float texWrapY = 1.0f;
 
 
-
 private:
     vec3 initialPOS;
     quat initialQuat;
@@ -98,7 +130,10 @@ private:
     GLuint VAO;
     int activeVertices;
 
+    LODChain lodChain;
+
     GLuint texture;
+    int textureLayer = -1;
 
     Material material;
 
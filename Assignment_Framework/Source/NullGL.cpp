@@ -0,0 +1,722 @@
+#include "NullGL.hpp"
+#include "GLMetrics.hpp"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct NullBuffer {
+    std::vector<unsigned char> memory; // what was uploaded, so mapping hands out real memory
+    bool mapped = false;
+};
+
+struct NullProgram {
+    std::vector<GLuint> shaders;
+    bool linked = false;
+    std::unordered_map<std::string, GLint> uniforms; // the uniforms the shaders declare, by the names GL would take
+};
+
+struct NullGLState {
+    GLuint nextName = 1; // every kind of object shares the numbering, a name of the wrong kind is caught too
+    std::unordered_set<GLuint> textures, vertexArrays, framebuffers, renderbuffers, queries;
+    std::unordered_map<GLuint, NullBuffer> buffers;
+    std::unordered_map<GLuint, std::string> shaders; // their source
+    std::unordered_map<GLuint, NullProgram> programs;
+
+    GLuint program = 0;
+    GLuint vertexArray = 0;
+    GLuint framebuffer = 0;
+    GLuint renderbuffer = 0;
+    GLenum activeTexture = GL_TEXTURE0;
+    std::unordered_map<GLenum, GLuint> boundBuffers; // by target
+    std::unordered_map<GLuint, GLuint> boundTextures; // by (unit << 16) | target
+    GLint packAlignment = 4;
+
+    int errors = 0;
+};
+
+static NullGLState state;
+
+static void invalid(const char* function, const char* problem) {
+    // GL would set an error and ignore the call, here it is also reported since nothing reads glGetError
+    if (state.errors++ < 10)
+        std::cerr << "Null GL: " << function << " - " << problem << std::endl;
+}
+
+static void generate(GLsizei n, GLuint* names, std::unordered_set<GLuint>& kind) {
+    for (GLsizei i = 0; i < n; i++) {
+        names[i] = state.nextName++;
+        kind.insert(names[i]);
+    }
+}
+
+static GLuint& boundTexture(GLenum target) {
+    return state.boundTextures[((state.activeTexture - GL_TEXTURE0) << 16) | (target & 0xFFFF)];
+}
+
+static NullBuffer* boundBuffer(const char* function, GLenum target) {
+    std::unordered_map<GLenum, GLuint>::iterator bound = state.boundBuffers.find(target);
+    if (bound == state.boundBuffers.end() || bound->second == 0) {
+        invalid(function, "no buffer bound to the target");
+        return NULL;
+    }
+    return &state.buffers[bound->second];
+}
+
+static bool checkRange(const char* function, const NullBuffer* buffer, GLintptr offset, GLsizeiptr size) {
+    if (buffer == NULL)
+        return false;
+    if (offset < 0 || size < 0 || (size_t)(offset + size) > buffer->memory.size()) {
+        invalid(function, "range outside of the buffer");
+        return false;
+    }
+    return true;
+}
+
+static bool checkDraw(const char* function, GLint first, GLsizei count) {
+    if (state.program == 0)
+        invalid(function, "no program in use");
+    else if (state.vertexArray == 0)
+        invalid(function, "no vertex array bound");
+    else if (first < 0 || count < 0)
+        invalid(function, "negative first or count");
+    else
+        return true;
+    return false;
+}
+
+static bool checkUniform(const char* function, GLint location) {
+    // -1 is what glGetUniformLocation returns for a name the program does not have, GL silently ignores it
+    if (state.program == 0) {
+        invalid(function, "no program in use");
+        return false;
+    }
+    if (location < -1 || location >= (GLint)state.programs[state.program].uniforms.size()) {
+        invalid(function, "location not in the program");
+        return false;
+    }
+    return true;
+}
+
+static std::vector<std::string> tokenizeGLSL(const std::string& source) {
+    // identifiers and numbers as words, every other character on its own, comments and preprocessor lines dropped
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < source.size()) {
+        char c = source[i];
+        if (source.compare(i, 2, "//") == 0 || c == '#')
+            i = source.find('\n', i);
+        else if (source.compare(i, 2, "/*") == 0)
+            i = source.find("*/", i) + (source.find("*/", i) == std::string::npos ? 0 : 2);
+        else if (isalnum((unsigned char)c) || c == '_') {
+            size_t start = i;
+            while (i < source.size() && (isalnum((unsigned char)source[i]) || source[i] == '_' || source[i] == '.'))
+                i++;
+            tokens.push_back(source.substr(start, i - start));
+        }
+        else {
+            if (!isspace((unsigned char)c))
+                tokens.push_back(std::string(1, c));
+            i++;
+        }
+    }
+    return tokens;
+}
+
+static void addUniform(NullProgram& program, const std::string& name, int arraySize) {
+    // GL takes an array by its name, the name of its first element and the name of every element
+    GLint location = (GLint)program.uniforms.size();
+    program.uniforms.insert(std::make_pair(name, location));
+    for (int i = 0; i < arraySize; i++)
+        program.uniforms.insert(std::make_pair(name + "[" + std::to_string(i) + "]", (GLint)program.uniforms.size()));
+}
+
+static void findUniforms(NullProgram& program, const std::string& source) {
+    /* the uniforms declared in a shader, with the members of struct uniforms expanded the way GL names them
+    * (material.color), unlike a driver nothing is optimized away
+    */
+    std::vector<std::string> tokens = tokenizeGLSL(source);
+    std::unordered_map<std::string, std::vector<std::string> > structs;
+
+    for (size_t i = 0; i + 2 < tokens.size(); i++) {
+        if (tokens[i] == "struct" && tokens[i + 2] == "{") {
+            std::vector<std::string>& members = structs[tokens[i + 1]];
+            size_t j = i + 3;
+            while (j + 1 < tokens.size() && tokens[j] != "}") {
+                members.push_back(tokens[j + 1]); // type name;
+                while (j < tokens.size() && tokens[j] != ";")
+                    j++;
+                j++;
+            }
+            i = j;
+        }
+        else if (tokens[i] == "uniform") {
+            size_t j = i + 1;
+            while (j + 1 < tokens.size() && (tokens[j] == "highp" || tokens[j] == "mediump" || tokens[j] == "lowp"))
+                j++;
+            const std::string& type = tokens[j];
+            const std::string& name = tokens[j + 1];
+            int arraySize = 0;
+            if (j + 3 < tokens.size() && tokens[j + 2] == "[")
+                arraySize = atoi(tokens[j + 3].c_str());
+
+            if (structs.count(type) != 0) {
+                for (const std::string& member : structs[type])
+                    addUniform(program, name + "." + member, 0);
+            }
+            else
+                addUniform(program, name, arraySize);
+        }
+    }
+}
+
+//////////////////////////////////////////////// BUFFERS ////////////////////////////////////////////////
+
+static void GLAPIENTRY nullGenBuffers(GLsizei n, GLuint* buffers) {
+    for (GLsizei i = 0; i < n; i++) {
+        buffers[i] = state.nextName++;
+        state.buffers[buffers[i]];
+    }
+}
+
+static void GLAPIENTRY nullBindBuffer(GLenum target, GLuint buffer) {
+    if (buffer != 0 && state.buffers.count(buffer) == 0) {
+        invalid("glBindBuffer", "not a buffer name");
+        return;
+    }
+    state.boundBuffers[target] = buffer;
+}
+
+static void GLAPIENTRY nullBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum /*usage*/) {
+    NullBuffer* buffer = boundBuffer("glBufferData", target);
+    if (buffer == NULL)
+        return;
+    if (size < 0) {
+        invalid("glBufferData", "negative size");
+        return;
+    }
+    buffer->memory.resize(size);
+    if (data != NULL && size > 0)
+        memcpy(&buffer->memory[0], data, size);
+}
+
+static void GLAPIENTRY nullBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    NullBuffer* buffer = boundBuffer("glBufferSubData", target);
+    if (checkRange("glBufferSubData", buffer, offset, size) && size > 0)
+        memcpy(&buffer->memory[offset], data, size);
+}
+
+static void GLAPIENTRY nullBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield /*flags*/) {
+    nullBufferData(target, size, data, GL_STATIC_DRAW);
+}
+
+static void* GLAPIENTRY nullMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield /*access*/) {
+    NullBuffer* buffer = boundBuffer("glMapBufferRange", target);
+    if (!checkRange("glMapBufferRange", buffer, offset, length) || length == 0)
+        return NULL;
+    if (buffer->mapped) {
+        invalid("glMapBufferRange", "already mapped");
+        return NULL;
+    }
+    buffer->mapped = true;
+    return &buffer->memory[offset];
+}
+
+static GLboolean GLAPIENTRY nullUnmapBuffer(GLenum target) {
+    NullBuffer* buffer = boundBuffer("glUnmapBuffer", target);
+    if (buffer == NULL || !buffer->mapped) {
+        invalid("glUnmapBuffer", "not mapped");
+        return GL_FALSE;
+    }
+    buffer->mapped = false;
+    return GL_TRUE;
+}
+
+static void GLAPIENTRY nullDeleteBuffers(GLsizei n, const GLuint* buffers) {
+    for (GLsizei i = 0; i < n; i++)
+        state.buffers.erase(buffers[i]);
+}
+
+//////////////////////////////////////////////// VERTEX ARRAYS ////////////////////////////////////////////////
+
+static void GLAPIENTRY nullGenVertexArrays(GLsizei n, GLuint* arrays) {
+    generate(n, arrays, state.vertexArrays);
+}
+
+static void GLAPIENTRY nullBindVertexArray(GLuint array) {
+    if (array != 0 && state.vertexArrays.count(array) == 0) {
+        invalid("glBindVertexArray", "not a vertex array name");
+        return;
+    }
+    state.vertexArray = array;
+}
+
+static void GLAPIENTRY nullVertexAttribPointer(GLuint /*index*/, GLint size, GLenum /*type*/, GLboolean /*normalized*/, GLsizei stride, const void* /*pointer*/) {
+    if (state.vertexArray == 0)
+        invalid("glVertexAttribPointer", "no vertex array bound");
+    else if (state.boundBuffers[GL_ARRAY_BUFFER] == 0)
+        invalid("glVertexAttribPointer", "no array buffer bound");
+    else if (size < 1 || size > 4 || stride < 0)
+        invalid("glVertexAttribPointer", "bad size or stride");
+}
+
+static void GLAPIENTRY nullEnableVertexAttribArray(GLuint /*index*/) {
+    if (state.vertexArray == 0)
+        invalid("glEnableVertexAttribArray", "no vertex array bound");
+}
+
+static void GLAPIENTRY nullVertexAttribDivisor(GLuint /*index*/, GLuint /*divisor*/) {
+    if (state.vertexArray == 0)
+        invalid("glVertexAttribDivisor", "no vertex array bound");
+}
+
+static void GLAPIENTRY nullDrawArraysInstanced(GLenum /*mode*/, GLint first, GLsizei count, GLsizei instanceCount) {
+    if (checkDraw("glDrawArraysInstanced", first, count) && instanceCount < 0)
+        invalid("glDrawArraysInstanced", "negative instance count");
+}
+
+//////////////////////////////////////////////// SHADERS AND PROGRAMS ////////////////////////////////////////////////
+
+static GLuint GLAPIENTRY nullCreateShader(GLenum /*type*/) {
+    GLuint shader = state.nextName++;
+    state.shaders[shader];
+    return shader;
+}
+
+static void GLAPIENTRY nullShaderSource(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths) {
+    if (state.shaders.count(shader) == 0) {
+        invalid("glShaderSource", "not a shader name");
+        return;
+    }
+    std::string& source = state.shaders[shader];
+    source.clear();
+    for (GLsizei i = 0; i < count; i++)
+        source.append(strings[i], lengths != NULL && lengths[i] >= 0 ? lengths[i] : strlen(strings[i]));
+}
+
+static void GLAPIENTRY nullCompileShader(GLuint shader) {
+    if (state.shaders.count(shader) == 0)
+        invalid("glCompileShader", "not a shader name");
+}
+
+static void GLAPIENTRY nullGetShaderiv(GLuint /*shader*/, GLenum pname, GLint* param) {
+    // every shader compiles, without a log
+    *param = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+static void GLAPIENTRY nullGetShaderInfoLog(GLuint /*shader*/, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+    if (length != NULL)
+        *length = 0;
+    if (bufSize > 0)
+        infoLog[0] = '\0';
+}
+
+static void GLAPIENTRY nullDeleteShader(GLuint shader) {
+    state.shaders.erase(shader);
+}
+
+static GLuint GLAPIENTRY nullCreateProgram() {
+    GLuint program = state.nextName++;
+    state.programs[program];
+    return program;
+}
+
+static void GLAPIENTRY nullAttachShader(GLuint program, GLuint shader) {
+    if (state.programs.count(program) == 0 || state.shaders.count(shader) == 0) {
+        invalid("glAttachShader", "not a program or a shader name");
+        return;
+    }
+    state.programs[program].shaders.push_back(shader);
+}
+
+static void GLAPIENTRY nullLinkProgram(GLuint program) {
+    if (state.programs.count(program) == 0) {
+        invalid("glLinkProgram", "not a program name");
+        return;
+    }
+    NullProgram& linked = state.programs[program];
+    linked.uniforms.clear();
+    for (GLuint shader : linked.shaders) {
+        if (state.shaders.count(shader) == 0)
+            invalid("glLinkProgram", "attached shader was deleted");
+        else
+            findUniforms(linked, state.shaders[shader]);
+    }
+    linked.linked = true;
+}
+
+static void GLAPIENTRY nullGetProgramiv(GLuint /*program*/, GLenum pname, GLint* param) {
+    *param = pname == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+
+static void GLAPIENTRY nullGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+    nullGetShaderInfoLog(program, bufSize, length, infoLog);
+}
+
+static void GLAPIENTRY nullUseProgram(GLuint program) {
+    if (program != 0 && (state.programs.count(program) == 0 || !state.programs[program].linked)) {
+        invalid("glUseProgram", "not a linked program");
+        return;
+    }
+    state.program = program;
+}
+
+static GLint GLAPIENTRY nullGetUniformLocation(GLuint program, const GLchar* name) {
+    std::unordered_map<GLuint, NullProgram>::iterator found = state.programs.find(program);
+    if (found == state.programs.end() || !found->second.linked) {
+        invalid("glGetUniformLocation", "not a linked program");
+        return -1;
+    }
+    std::unordered_map<std::string, GLint>::iterator uniform = found->second.uniforms.find(name);
+    return uniform == found->second.uniforms.end() ? -1 : uniform->second;
+}
+
+static void GLAPIENTRY nullUniform1i(GLint location, GLint /*v0*/) {
+    checkUniform("glUniform1i", location);
+}
+
+static void GLAPIENTRY nullUniform1f(GLint location, GLfloat /*v0*/) {
+    checkUniform("glUniform1f", location);
+}
+
+static void GLAPIENTRY nullUniform3fv(GLint location, GLsizei /*count*/, const GLfloat* /*value*/) {
+    checkUniform("glUniform3fv", location);
+}
+
+static void GLAPIENTRY nullUniformMatrix4fv(GLint location, GLsizei /*count*/, GLboolean /*transpose*/, const GLfloat* /*value*/) {
+    checkUniform("glUniformMatrix4fv", location);
+}
+
+//////////////////////////////////////////////// TEXTURES AND FRAMEBUFFERS ////////////////////////////////////////////////
+
+static void GLAPIENTRY nullActiveTexture(GLenum texture) {
+    if (texture < GL_TEXTURE0 || texture >= GL_TEXTURE0 + 32) {
+        invalid("glActiveTexture", "not a texture unit");
+        return;
+    }
+    state.activeTexture = texture;
+}
+
+static void GLAPIENTRY nullGenerateMipmap(GLenum target) {
+    if (boundTexture(target) == 0)
+        invalid("glGenerateMipmap", "no texture bound to the target");
+}
+
+static void GLAPIENTRY nullCompressedTexImage2D(GLenum target, GLint level, GLenum /*internalFormat*/, GLsizei width, GLsizei height,
+    GLint border, GLsizei imageSize, const void* data) {
+    GLuint unpackBuffer = state.boundBuffers[GL_PIXEL_UNPACK_BUFFER];
+    if (boundTexture(target) == 0)
+        invalid("glCompressedTexImage2D", "no texture bound to the target");
+    else if (width < 0 || height < 0 || level < 0 || border != 0 || imageSize < 0)
+        invalid("glCompressedTexImage2D", "bad size, level or border");
+    else if (unpackBuffer != 0)
+        checkRange("glCompressedTexImage2D", &state.buffers[unpackBuffer], (GLintptr)data, imageSize);
+}
+
+static void GLAPIENTRY nullTexImage3D(GLenum target, GLint level, GLint /*internalFormat*/, GLsizei width, GLsizei height, GLsizei depth,
+    GLint border, GLenum format, GLenum type, const void* pixels) {
+    GLuint unpackBuffer = state.boundBuffers[GL_PIXEL_UNPACK_BUFFER];
+    if (boundTexture(target) == 0)
+        invalid("glTexImage3D", "no texture bound to the target");
+    else if (width < 0 || height < 0 || depth < 0 || level < 0 || border != 0)
+        invalid("glTexImage3D", "bad size, level or border");
+    else if (unpackBuffer != 0)
+        checkRange("glTexImage3D", &state.buffers[unpackBuffer], (GLintptr)pixels, (GLsizeiptr)width * height * depth * glTexelBytes(format, type));
+}
+
+static void GLAPIENTRY nullGenFramebuffers(GLsizei n, GLuint* framebuffers) {
+    generate(n, framebuffers, state.framebuffers);
+}
+
+static void GLAPIENTRY nullBindFramebuffer(GLenum target, GLuint framebuffer) {
+    if (framebuffer != 0 && state.framebuffers.count(framebuffer) == 0) {
+        invalid("glBindFramebuffer", "not a framebuffer name");
+        return;
+    }
+    if (target != GL_READ_FRAMEBUFFER)
+        state.framebuffer = framebuffer;
+}
+
+static void GLAPIENTRY nullFramebufferTexture(GLenum /*target*/, GLenum /*attachment*/, GLuint texture, GLint /*level*/) {
+    if (state.framebuffer == 0)
+        invalid("glFramebufferTexture", "no framebuffer bound");
+    else if (texture != 0 && state.textures.count(texture) == 0)
+        invalid("glFramebufferTexture", "not a texture name");
+}
+
+static void GLAPIENTRY nullFramebufferRenderbuffer(GLenum /*target*/, GLenum /*attachment*/, GLenum /*renderbufferTarget*/, GLuint renderbuffer) {
+    if (state.framebuffer == 0)
+        invalid("glFramebufferRenderbuffer", "no framebuffer bound");
+    else if (renderbuffer != 0 && state.renderbuffers.count(renderbuffer) == 0)
+        invalid("glFramebufferRenderbuffer", "not a renderbuffer name");
+}
+
+static GLenum GLAPIENTRY nullCheckFramebufferStatus(GLenum /*target*/) {
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void GLAPIENTRY nullDeleteFramebuffers(GLsizei n, const GLuint* framebuffers) {
+    for (GLsizei i = 0; i < n; i++)
+        state.framebuffers.erase(framebuffers[i]);
+}
+
+static void GLAPIENTRY nullGenRenderbuffers(GLsizei n, GLuint* renderbuffers) {
+    generate(n, renderbuffers, state.renderbuffers);
+}
+
+static void GLAPIENTRY nullBindRenderbuffer(GLenum /*target*/, GLuint renderbuffer) {
+    if (renderbuffer != 0 && state.renderbuffers.count(renderbuffer) == 0) {
+        invalid("glBindRenderbuffer", "not a renderbuffer name");
+        return;
+    }
+    state.renderbuffer = renderbuffer;
+}
+
+static void GLAPIENTRY nullRenderbufferStorage(GLenum /*target*/, GLenum /*internalFormat*/, GLsizei width, GLsizei height) {
+    if (state.renderbuffer == 0)
+        invalid("glRenderbufferStorage", "no renderbuffer bound");
+    else if (width < 0 || height < 0)
+        invalid("glRenderbufferStorage", "negative size");
+}
+
+static void GLAPIENTRY nullDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers) {
+    for (GLsizei i = 0; i < n; i++)
+        state.renderbuffers.erase(renderbuffers[i]);
+}
+
+//////////////////////////////////////////////// QUERIES AND FENCES ////////////////////////////////////////////////
+
+static void GLAPIENTRY nullGenQueries(GLsizei n, GLuint* ids) {
+    generate(n, ids, state.queries);
+}
+
+static void GLAPIENTRY nullDeleteQueries(GLsizei n, const GLuint* ids) {
+    for (GLsizei i = 0; i < n; i++)
+        state.queries.erase(ids[i]);
+}
+
+static void GLAPIENTRY nullQueryCounter(GLuint id, GLenum /*target*/) {
+    if (state.queries.count(id) == 0)
+        invalid("glQueryCounter", "not a query name");
+}
+
+static void GLAPIENTRY nullGetQueryObjectiv(GLuint /*id*/, GLenum pname, GLint* params) {
+    *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+}
+
+static void GLAPIENTRY nullGetQueryObjectui64v(GLuint /*id*/, GLenum /*pname*/, GLuint64* params) {
+    *params = 0;
+}
+
+static GLsync GLAPIENTRY nullFenceSync(GLenum /*condition*/, GLbitfield /*flags*/) {
+    static int fence; // nothing to wait for, every fence is the same signaled one
+    return (GLsync)&fence;
+}
+
+static GLenum GLAPIENTRY nullClientWaitSync(GLsync /*sync*/, GLbitfield /*flags*/, GLuint64 /*timeout*/) {
+    return GL_ALREADY_SIGNALED;
+}
+
+static void GLAPIENTRY nullDeleteSync(GLsync /*sync*/) {
+}
+
+//////////////////////////////////////////////// GL 1.1, see GLDispatch.hpp ////////////////////////////////////////////////
+
+static void GLAPIENTRY nullBindTexture(GLenum target, GLuint texture) {
+    if (texture != 0 && state.textures.count(texture) == 0) {
+        invalid("glBindTexture", "not a texture name");
+        return;
+    }
+    boundTexture(target) = texture;
+}
+
+static void GLAPIENTRY nullClear(GLbitfield /*mask*/) {
+}
+
+static void GLAPIENTRY nullClearColor(GLclampf /*red*/, GLclampf /*green*/, GLclampf /*blue*/, GLclampf /*alpha*/) {
+}
+
+static void GLAPIENTRY nullDrawArrays(GLenum /*mode*/, GLint first, GLsizei count) {
+    checkDraw("glDrawArrays", first, count);
+}
+
+static void GLAPIENTRY nullDrawBuffer(GLenum /*mode*/) {
+}
+
+static void GLAPIENTRY nullEnable(GLenum /*cap*/) {
+}
+
+static void GLAPIENTRY nullFinish() {
+}
+
+static void GLAPIENTRY nullGenTextures(GLsizei n, GLuint* textures) {
+    generate(n, textures, state.textures);
+}
+
+static void GLAPIENTRY nullDeleteTextures(GLsizei n, const GLuint* textures) {
+    // a deleted texture is unbound from every unit
+    for (GLsizei i = 0; i < n; i++) {
+        state.textures.erase(textures[i]);
+        for (std::unordered_map<GLuint, GLuint>::iterator bound = state.boundTextures.begin(); bound != state.boundTextures.end(); ++bound) {
+            if (bound->second == textures[i])
+                bound->second = 0;
+        }
+    }
+}
+
+static const GLubyte* GLAPIENTRY nullGetString(GLenum name) {
+    switch (name) {
+    case GL_VENDOR: return (const GLubyte*)"none";
+    case GL_RENDERER: return (const GLubyte*)"null backend";
+    case GL_VERSION: return (const GLubyte*)"3.2 null";
+    case GL_SHADING_LANGUAGE_VERSION: return (const GLubyte*)"1.50";
+    default: return (const GLubyte*)"";
+    }
+}
+
+static void GLAPIENTRY nullPixelStorei(GLenum pname, GLint param) {
+    if (param != 1 && param != 2 && param != 4 && param != 8)
+        invalid("glPixelStorei", "alignment must be 1, 2, 4 or 8");
+    else if (pname == GL_PACK_ALIGNMENT)
+        state.packAlignment = param;
+}
+
+static void GLAPIENTRY nullPolygonMode(GLenum face, GLenum /*mode*/) {
+    if (face != GL_FRONT_AND_BACK)
+        invalid("glPolygonMode", "the core profile only takes GL_FRONT_AND_BACK");
+}
+
+static void GLAPIENTRY nullReadBuffer(GLenum /*mode*/) {
+}
+
+static void GLAPIENTRY nullReadPixels(GLint /*x*/, GLint /*y*/, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels) {
+    // black, into the pixel pack buffer when one is bound (pixels is then an offset in it)
+    if (width < 0 || height < 0) {
+        invalid("glReadPixels", "negative size");
+        return;
+    }
+    GLsizeiptr rowBytes = ((GLsizeiptr)width * glTexelBytes(format, type) + state.packAlignment - 1) / state.packAlignment * state.packAlignment;
+    GLsizeiptr size = rowBytes * height;
+
+    GLuint packBuffer = state.boundBuffers[GL_PIXEL_PACK_BUFFER];
+    if (packBuffer != 0) {
+        NullBuffer& buffer = state.buffers[packBuffer];
+        if (checkRange("glReadPixels", &buffer, (GLintptr)pixels, size))
+            memset(&buffer.memory[(GLintptr)pixels], 0, size);
+    }
+    else if (pixels != NULL)
+        memset(pixels, 0, size);
+}
+
+static void GLAPIENTRY nullTexImage2D(GLenum target, GLint level, GLint /*internalFormat*/, GLsizei width, GLsizei height, GLint border,
+    GLenum /*format*/, GLenum /*type*/, const void* /*pixels*/) {
+    GLenum bindingTarget = target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z ? GL_TEXTURE_CUBE_MAP : target;
+    if (boundTexture(bindingTarget) == 0)
+        invalid("glTexImage2D", "no texture bound to the target");
+    else if (width < 0 || height < 0 || level < 0 || border != 0)
+        invalid("glTexImage2D", "bad size, level or border");
+}
+
+static void GLAPIENTRY nullTexParameteri(GLenum target, GLenum /*pname*/, GLint /*param*/) {
+    if (boundTexture(target) == 0)
+        invalid("glTexParameteri", "no texture bound to the target");
+}
+
+static void GLAPIENTRY nullViewport(GLint /*x*/, GLint /*y*/, GLsizei width, GLsizei height) {
+    if (width < 0 || height < 0)
+        invalid("glViewport", "negative size");
+}
+
+void installNullGL() {
+    // what the null backend pretends to be: GL 3.2 with the buffer storage and sync extensions, without timer queries
+    __GLEW_VERSION_1_1 = __GLEW_VERSION_1_2 = __GLEW_VERSION_1_3 = __GLEW_VERSION_1_4 = __GLEW_VERSION_1_5 = GL_TRUE;
+    __GLEW_VERSION_2_0 = __GLEW_VERSION_2_1 = __GLEW_VERSION_3_0 = __GLEW_VERSION_3_1 = __GLEW_VERSION_3_2 = GL_TRUE;
+    __GLEW_ARB_buffer_storage = GL_TRUE;
+    __GLEW_ARB_sync = GL_TRUE;
+    __GLEW_EXT_texture_compression_s3tc = GL_TRUE;
+    __GLEW_VERSION_4_1 = __GLEW_ARB_get_program_binary = GL_FALSE; // the uniforms are read from the sources it links
+
+    __glewGenBuffers = nullGenBuffers;
+    __glewBindBuffer = nullBindBuffer;
+    __glewBufferData = nullBufferData;
+    __glewBufferSubData = nullBufferSubData;
+    __glewBufferStorage = nullBufferStorage;
+    __glewMapBufferRange = nullMapBufferRange;
+    __glewUnmapBuffer = nullUnmapBuffer;
+    __glewDeleteBuffers = nullDeleteBuffers;
+
+    __glewGenVertexArrays = nullGenVertexArrays;
+    __glewBindVertexArray = nullBindVertexArray;
+    __glewVertexAttribPointer = nullVertexAttribPointer;
+    __glewEnableVertexAttribArray = nullEnableVertexAttribArray;
+    __glewVertexAttribDivisor = nullVertexAttribDivisor;
+    __glewDrawArraysInstanced = nullDrawArraysInstanced;
+
+    __glewCreateShader = nullCreateShader;
+    __glewShaderSource = nullShaderSource;
+    __glewCompileShader = nullCompileShader;
+    __glewGetShaderiv = nullGetShaderiv;
+    __glewGetShaderInfoLog = nullGetShaderInfoLog;
+    __glewDeleteShader = nullDeleteShader;
+    __glewCreateProgram = nullCreateProgram;
+    __glewAttachShader = nullAttachShader;
+    __glewLinkProgram = nullLinkProgram;
+    __glewGetProgramiv = nullGetProgramiv;
+    __glewGetProgramInfoLog = nullGetProgramInfoLog;
+    __glewUseProgram = nullUseProgram;
+    __glewGetUniformLocation = nullGetUniformLocation;
+    __glewUniform1i = nullUniform1i;
+    __glewUniform1f = nullUniform1f;
+    __glewUniform3fv = nullUniform3fv;
+    __glewUniformMatrix4fv = nullUniformMatrix4fv;
+
+    __glewActiveTexture = nullActiveTexture;
+    __glewGenerateMipmap = nullGenerateMipmap;
+    __glewCompressedTexImage2D = nullCompressedTexImage2D;
+    __glewTexImage3D = nullTexImage3D;
+    __glewGenFramebuffers = nullGenFramebuffers;
+    __glewBindFramebuffer = nullBindFramebuffer;
+    __glewFramebufferTexture = nullFramebufferTexture;
+    __glewFramebufferRenderbuffer = nullFramebufferRenderbuffer;
+    __glewCheckFramebufferStatus = nullCheckFramebufferStatus;
+    __glewDeleteFramebuffers = nullDeleteFramebuffers;
+    __glewGenRenderbuffers = nullGenRenderbuffers;
+    __glewBindRenderbuffer = nullBindRenderbuffer;
+    __glewRenderbufferStorage = nullRenderbufferStorage;
+    __glewDeleteRenderbuffers = nullDeleteRenderbuffers;
+
+    __glewGenQueries = nullGenQueries;
+    __glewDeleteQueries = nullDeleteQueries;
+    __glewQueryCounter = nullQueryCounter;
+    __glewGetQueryObjectiv = nullGetQueryObjectiv;
+    __glewGetQueryObjectui64v = nullGetQueryObjectui64v;
+    __glewFenceSync = nullFenceSync;
+    __glewClientWaitSync = nullClientWaitSync;
+    __glewDeleteSync = nullDeleteSync;
+
+    gl11().bindTexture = nullBindTexture;
+    gl11().clear = nullClear;
+    gl11().clearColor = nullClearColor;
+    gl11().deleteTextures = nullDeleteTextures;
+    gl11().drawArrays = nullDrawArrays;
+    gl11().drawBuffer = nullDrawBuffer;
+    gl11().enable = nullEnable;
+    gl11().finish = nullFinish;
+    gl11().genTextures = nullGenTextures;
+    gl11().getString = nullGetString;
+    gl11().pixelStorei = nullPixelStorei;
+    gl11().polygonMode = nullPolygonMode;
+    gl11().readBuffer = nullReadBuffer;
+    gl11().readPixels = nullReadPixels;
+    gl11().texImage2D = nullTexImage2D;
+    gl11().texParameteri = nullTexParameteri;
+    gl11().viewport = nullViewport;
+}
+
+int getNullGLErrorCount() {
+    return state.errors;
+}
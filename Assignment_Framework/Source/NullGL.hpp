@@ -0,0 +1,16 @@
+#ifndef NULL_GL_HEADER
+#define NULL_GL_HEADER
+
+/* GL backend that executes nothing, to measure what a frame costs on the CPU without the driver (-nullgl).
+* installNullGL() is used instead of a context and glewInit: it points the GLEW entry points the game uses, and the
+* GL 1.1 ones in GLDispatch.hpp, at functions that check their arguments against the little state they keep (the
+* names handed out, what is bound, the buffers' memory so mapping still works) and return. GLMetrics.hpp still
+* counts every call.
+* Nothing is drawn: read backs are black, there are no GPU timers and fences are signaled right away.
+* Like a real context it must only be used by one thread at a time.
+*/
+
+void installNullGL();
+int getNullGLErrorCount(); // invalid calls so far, the first few are also written to cerr
+
+#endif
@@ -2,6 +2,7 @@
 #define OBJ_LOADER_HEADER
 
 #include <glm/glm.hpp>
+#include "AssetPack.hpp"
 #include <cstring>
 #include <vector>
 #include <string>
@@ -19,46 +20,46 @@ bool loadOBJ(
 	std::vector<glm::vec2> temp_uvs;
 	std::vector<glm::vec3> temp_normals;
 
-	FILE* file;
-	file = fopen(path, "r");
-	if (!file) {
+	AssetStream file(assets().open(path));
+	if (!file.isOpen()) {
 		printf("Impossible to open the file ! Are you in the right path ?\n");
 		printf(path);
 		return false;
 	}
 
-	while (1) {
+	std::string fileLine;
+	while (getline(file, fileLine)) {
 
 		char lineHeader[128];
+		int headerLength = 0;
 		// read the first word of the line
-		int res = fscanf(file, "%s", lineHeader);
-		if (res == EOF)
-			break; // EOF = End Of File. Quit the loop.
+		if (sscanf(fileLine.c_str(), "%127s%n", lineHeader, &headerLength) != 1)
+			continue; // empty line
+		const char* rest = fileLine.c_str() + headerLength;
 
 		// else : parse lineHeader
 
 		if (strcmp(lineHeader, "v") == 0) {
 			glm::vec3 vertex;
-			fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
+			sscanf(rest, "%f %f %f", &vertex.x, &vertex.y, &vertex.z);
 			temp_vertices.push_back(vertex);
 		}
 		else if (strcmp(lineHeader, "vt") == 0) {
 			glm::vec2 uv;
-			fscanf(file, "%f %f\n", &uv.x, &uv.y);
+			sscanf(rest, "%f %f", &uv.x, &uv.y);
 			uv.y = -uv.y; // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
 			temp_uvs.push_back(uv);
 		}
 		else if (strcmp(lineHeader, "vn") == 0) {
 			glm::vec3 normal;
-			fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
+			sscanf(rest, "%f %f %f", &normal.x, &normal.y, &normal.z);
 			temp_normals.push_back(normal);
 		}
 		else if (strcmp(lineHeader, "f") == 0) {
 			int vertexIndex[3], uvIndex[3], normalIndex[3];
 			bool uv = true;
 			bool norm = true;
-			char line[128];
-			fgets(line, 128, file);
+			const char* line = rest;
 			//vertex, uv, norm
 			int matches = sscanf(line, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
 			if (matches != 9) {
@@ -72,7 +73,7 @@ bool loadOBJ(
 						matches = sscanf(line, "%d %d %d\n", &vertexIndex[0], &vertexIndex[1], &vertexIndex[2]);
 						if (matches != 6) {
 							printf("File can't be read by our simple parser. 'f' format expected: d/d/d d/d/d d/d/d || d/d d/d d/d || d//d d//d d//d\n");
-							printf("Character at %ld", ftell(file));
+							printf("Line: %s\n", fileLine.c_str());
 							return false;
 						}
 						uv, norm = false;
@@ -99,11 +100,6 @@ bool loadOBJ(
 				uvIndices.push_back(uvIndex[2]);
 			}
 		}
-		else {
-			char clear[1000];
-			fgets(clear, 1000, file);
-		}
-
 	}
 	//std::cout << "Vertex indices: " << vertexIndices.size() << std::endl;
 	//std::cout << "UV indices: " << uvIndices.size() << std::endl;
@@ -144,33 +140,35 @@ bool loadOBJ2(
 	std::vector<glm::vec2> temp_uvs;
 	std::vector<glm::vec3> temp_normals;
 
-	FILE* file;
-	file = fopen(path, "r");
-	if (!file) {
+	AssetStream file(assets().open(path));
+	if (!file.isOpen()) {
 		printf("Impossible to open the file ! Are you in the right path ?\n");
 		getchar();
 		return false;
 	}
 
-	while (1) {
+	std::string fileLine;
+	while (getline(file, fileLine)) {
 
 		char lineHeader[128];
+		int headerLength = 0;
 		// read the first word of the line
-		int res = fscanf(file, "%s", lineHeader);
-		if (res == EOF)
-			break; // EOF = End Of File. Quit the loop.
+		if (sscanf(fileLine.c_str(), "%127s%n", lineHeader, &headerLength) != 1)
+			continue; // empty line
+		const char* rest = fileLine.c_str() + headerLength;
+		int res;
 
 		// else : parse lineHeader
 
 		if (strcmp(lineHeader, "v") == 0) {
 			glm::vec3 vertex;
-			res = fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
+			res = sscanf(rest, "%f %f %f", &vertex.x, &vertex.y, &vertex.z);
 
 			temp_vertices.push_back(vertex);
 		}
 		else if (strcmp(lineHeader, "vt") == 0) {
 			glm::vec2 uv;
-			res = fscanf(file, "%f %f\n", &uv.x, &uv.y);
+			res = sscanf(rest, "%f %f", &uv.x, &uv.y);
 			if (res != 2) {
 				printf("Missing uv information!\n");
 			}
@@ -179,22 +177,17 @@ bool loadOBJ2(
 		}
 		else if (strcmp(lineHeader, "vn") == 0) {
 			glm::vec3 normal;
-			res = fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
+			res = sscanf(rest, "%f %f %f", &normal.x, &normal.y, &normal.z);
 			if (res != 3) {
 				printf("Missing normal information!\n");
 			}
 			temp_normals.push_back(normal);
 		}
 		else if (strcmp(lineHeader, "f") == 0) {
-			char* getRes;
 			int vertexIndex[3], uvIndex[3], normalIndex[3];
 			bool uv = true;
 			bool norm = true;
-			char line[128];
-			getRes = fgets(line, 128, file);
-			if (getRes == 0) {
-				printf("incomplete face\n");
-			}
+			const char* line = rest;
 
 			//vertex, uv, norm
 			int matches = sscanf(line, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
@@ -209,7 +202,7 @@ bool loadOBJ2(
 						matches = sscanf(line, "%d %d %d\n", &vertexIndex[0], &vertexIndex[1], &vertexIndex[2]);
 						if (matches != 3) {
 							printf("File can't be read by our simple parser. 'f' format expected: d/d/d d/d/d d/d/d || d/d d/d d/d || d//d d//d d//d\n");
-							printf("Character at %ld", ftell(file));
+							printf("Line: %s\n", fileLine.c_str());
 							return false;
 						}
 						uv, norm = false;
@@ -236,10 +229,6 @@ bool loadOBJ2(
 				uvIndices.push_back(abs(uvIndex[2]) - 1);
 			}
 		}
-		else {
-			char clear[1000];
-			char* getsRes = fgets(clear, 1000, file);
-		}
 	}
 	if (normalIndices.size() != 0)
 		out_normals.resize(temp_normals.size());
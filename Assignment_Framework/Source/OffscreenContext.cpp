@@ -0,0 +1,127 @@
+#include "OffscreenContext.hpp"
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__)
+#define EGL_NO_X11 // the surfaceless platform does not need Xlib
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+static bool hasExtension(const char* extensions, const char* name) {
+    // extension strings are names separated by spaces, a name can be the start of a longer one
+    if (extensions == NULL)
+        return false;
+
+    size_t length = strlen(name);
+    for (const char* found = strstr(extensions, name); found != NULL; found = strstr(found + length, name)) {
+        if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+            return true;
+    }
+    return false;
+}
+
+bool OffscreenContext::create(int majorVersion, int minorVersion) {
+    // the surfaceless platform needs neither X nor a GPU, the default display is tried when it is missing
+    EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+    if (hasExtension(eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS), "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay != NULL)
+            eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if (eglDisplay == EGL_NO_DISPLAY)
+        eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint eglMajor, eglMinor;
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &eglMajor, &eglMinor)) {
+        std::cerr << "Failed to initialize EGL" << std::endl;
+        return false;
+    }
+    display = eglDisplay;
+
+    bool surfaceless = hasExtension(eglQueryString(eglDisplay, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) || configCount == 0 || !eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL display does not support desktop OpenGL" << std::endl;
+        destroy();
+        return false;
+    }
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, majorVersion,
+        EGL_CONTEXT_MINOR_VERSION, minorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create an OpenGL " << majorVersion << "." << minorVersion << " EGL context" << std::endl;
+        destroy();
+        return false;
+    }
+
+    if (!surfaceless) {
+        const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        surface = eglCreatePbufferSurface(eglDisplay, config, pbufferAttributes);
+    }
+    if (!eglMakeCurrent(eglDisplay, surface, surface, context)) {
+        std::cerr << "Failed to make the EGL context current" << std::endl;
+        destroy();
+        return false;
+    }
+    return true;
+}
+
+bool OffscreenContext::makeCurrent() {
+    eglBindAPI(EGL_OPENGL_API); // the bound API is per thread
+    EGLSurface drawSurface = surface != NULL ? (EGLSurface)surface : EGL_NO_SURFACE;
+    if (!eglMakeCurrent((EGLDisplay)display, drawSurface, drawSurface, (EGLContext)context)) {
+        std::cerr << "Failed to make the EGL context current" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void OffscreenContext::release() {
+    eglMakeCurrent((EGLDisplay)display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+void OffscreenContext::destroy() {
+    if (display == NULL)
+        return;
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != NULL)
+        eglDestroySurface(display, surface);
+    if (context != NULL)
+        eglDestroyContext(display, context);
+    eglTerminate(display);
+
+    display = NULL;
+    context = NULL;
+    surface = NULL;
+}
+
+#else
+
+bool OffscreenContext::create(int majorVersion, int minorVersion) {
+    std::cerr << "Offscreen contexts need EGL, which is only used on Linux" << std::endl;
+    return false;
+}
+
+bool OffscreenContext::makeCurrent() {
+    return false;
+}
+
+void OffscreenContext::release() {
+}
+
+void OffscreenContext::destroy() {
+}
+
+#endif
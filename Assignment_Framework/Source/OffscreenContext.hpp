@@ -0,0 +1,29 @@
+#ifndef OFFSCREEN_CONTEXT_CLASS_H
+#define OFFSCREEN_CONTEXT_CLASS_H
+
+#include <cstddef>
+
+class OffscreenContext {
+	/* OpenGL context without a window or a display server, for machines that have neither (CI, render farm).
+	* Made with EGL on Mesa's surfaceless platform, which runs on llvmpipe when there is no GPU. The context has no
+	* default framebuffer so everything has to be drawn into a RenderTarget.
+	* Only available on Linux, create() fails on the other platforms and the caller falls back to a hidden window.
+	*/
+public:
+	bool create(int majorVersion, int minorVersion); // core profile, made current on the calling thread
+	void destroy();
+
+	// a context is current on one thread at a time, release it before making it current on another
+	bool makeCurrent();
+	void release();
+
+	bool isCreated() const { return context != NULL; }
+
+private:
+	// EGLDisplay, EGLContext and EGLSurface are all pointers, kept as void* so this header does not need EGL
+	void* display = NULL;
+	void* context = NULL;
+	void* surface = NULL; // 1x1 pbuffer, only when the driver cannot make a context current without a surface
+};
+
+#endif
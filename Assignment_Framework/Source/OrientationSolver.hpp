@@ -0,0 +1,76 @@
+#ifndef ORIENTATION_SOLVER_HEADER
+#define ORIENTATION_SOLVER_HEADER
+
+#include <cstdint>
+#include "CubeRotation.hpp"
+
+/* Shortest W/S/A/D/Q/E sequence from any orientation of a shape to one that fits through its wall.
+* There are only 24 orientations so the whole answer is solved once per shape with a breadth first search started
+* from every passing orientation at once, after that a query is two array reads and can be made every frame.
+*/
+
+const int MAX_SOLUTION_LENGTH = CUBE_ROTATION_COUNT; // bound on any path in the group, the real diameter is much smaller
+
+struct OrientationSolution {
+	int8_t distance[CUBE_ROTATION_COUNT]; // moves left to reach a passing orientation, -1 when the wall has no passing orientation
+	int8_t nextMove[CUBE_ROTATION_COUNT]; // first move of a shortest path, -1 when the orientation already passes or cannot
+};
+
+inline OrientationSolution solveOrientations(uint32_t passingOrientations) {
+	/* multi-source breadth first search over the rotation group
+	*	passingOrientations - bit i is set when orientation i fits through the wall, see ShapeOccupancy
+	*/
+	OrientationSolution solution;
+	int queue[CUBE_ROTATION_COUNT];
+	int head = 0, tail = 0;
+
+	for (int i = 0; i < CUBE_ROTATION_COUNT; i++) {
+		solution.distance[i] = -1;
+		solution.nextMove[i] = -1;
+		if ((passingOrientations >> i) & 1) {
+			solution.distance[i] = 0;
+			queue[tail++] = i;
+		}
+	}
+
+	// walk the moves backwards: if move m takes p to o then p is one step further from the wall than o
+	while (head < tail) {
+		int orientation = queue[head++];
+		for (int m = 0; m < MOVE_COUNT; m++) {
+			int previous = cubeRotations.multiply[inverseRotation(cubeRotations.moves[m])][orientation];
+			if (solution.distance[previous] != -1)
+				continue;
+			solution.distance[previous] = solution.distance[orientation] + 1;
+			solution.nextMove[previous] = m;
+			queue[tail++] = previous;
+		}
+	}
+	return solution;
+}
+
+inline int getMovesToPass(const OrientationSolution& solution, int orientation) { return solution.distance[orientation]; }
+
+inline int getNextMove(const OrientationSolution& solution, int orientation) {
+	/* move a player or a bot should make next, -1 when there is nothing to do */
+	return solution.nextMove[orientation];
+}
+
+inline int getSolutionPath(const OrientationSolution& solution, int orientation, RotationMove path[MAX_SOLUTION_LENGTH]) {
+	/* fills path with the full sequence of moves and returns its length, -1 when the wall cannot be passed */
+	if (solution.distance[orientation] < 0)
+		return -1;
+
+	int length = 0;
+	while (solution.nextMove[orientation] != -1) {
+		path[length] = (RotationMove)solution.nextMove[orientation];
+		orientation = applyMove(path[length++], orientation);
+	}
+	return length;
+}
+
+inline char getMoveKey(RotationMove move) {
+	static const char keys[MOVE_COUNT] = { 'W', 'S', 'A', 'D', 'E', 'Q' };
+	return keys[move];
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define LIGHT_CLASS_H
 
 #include <GL/glew.h>
+#include "GLMetrics.hpp"
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
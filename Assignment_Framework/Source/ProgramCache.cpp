@@ -0,0 +1,194 @@
+#include "ProgramCache.hpp"
+#include "AssetPack.hpp"
+#include "GLMetrics.hpp"
+#include "Trace.hpp"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+static const char PROGRAM_CACHE_MAGIC[8] = "SHCPRG";
+
+void ProgramCache::open(std::string pFilePath) {
+    filePath = pFilePath;
+    binaries.clear();
+    changed = false;
+
+    // a binary only loads on the driver that made it, the strings tell the drivers apart
+    supported = GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary;
+    const GLubyte* strings[3] = { glGetString(GL_VENDOR), glGetString(GL_RENDERER), glGetString(GL_VERSION) };
+    driver.clear();
+    for (const GLubyte* string : strings) {
+        driver += string == NULL ? "" : (const char*)string;
+        driver += '\n';
+    }
+    if (!supported)
+        return;
+
+    FILE* file = fopen(filePath.c_str(), "rb");
+    if (file == NULL)
+        return; // first start
+
+    ProgramCacheHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, PROGRAM_CACHE_MAGIC, 8) != 0 || header.version != PROGRAM_CACHE_VERSION) {
+        std::cerr << filePath << " is not a program cache of this version, the shaders are compiled again." << std::endl;
+        fclose(file);
+        return;
+    }
+
+    for (int i = 0; i < header.entryCount; i++) {
+        ProgramCacheEntry entry;
+        Binary binary;
+        if (fread(&entry, sizeof(entry), 1, file) != 1)
+            break;
+        binary.format = entry.format;
+        binary.data.resize(entry.size);
+        if (entry.size == 0 || fread(&binary.data[0], 1, entry.size, file) != entry.size)
+            break;
+        if (hashBytes(&binary.data[0], entry.size) != entry.hash) {
+            std::cerr << filePath << " has a damaged program, it is compiled again." << std::endl;
+            changed = true; // written again without it
+            continue;
+        }
+        binaries[entry.key] = std::move(binary);
+    }
+    fclose(file);
+}
+
+bool ProgramCache::save() {
+    if (!changed)
+        return true;
+
+    FILE* file = fopen(filePath.c_str(), "wb");
+    if (file == NULL) {
+        std::cerr << "Could not create file " << filePath << "." << std::endl;
+        return false;
+    }
+
+    ProgramCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PROGRAM_CACHE_MAGIC, 8);
+    header.version = PROGRAM_CACHE_VERSION;
+    header.entryCount = (int)binaries.size();
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    for (std::unordered_map<unsigned long long, Binary>::const_iterator binary = binaries.begin(); written && binary != binaries.end(); ++binary) {
+        ProgramCacheEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.key = binary->first;
+        entry.format = binary->second.format;
+        entry.size = (unsigned int)binary->second.data.size();
+        entry.hash = hashBytes(&binary->second.data[0], entry.size);
+        written = fwrite(&entry, sizeof(entry), 1, file) == 1 && fwrite(&binary->second.data[0], 1, entry.size, file) == entry.size;
+    }
+    written = fclose(file) == 0 && written;
+
+    if (!written) {
+        std::cerr << "Could not write file " << filePath << "." << std::endl;
+        remove(filePath.c_str()); // half a cache would only be refused next time
+        return false;
+    }
+    changed = false;
+    return true;
+}
+
+GLuint ProgramCache::getProgram(const std::vector<ShaderStage>& stages) {
+    std::vector<std::string> sources;
+    std::string keyed = driver;
+    for (const ShaderStage& stage : stages) {
+        AssetView file = assets().open(stage.filePath);
+        if (!file.isOpen()) {
+            std::cerr << "Could not read file " << stage.filePath << ". File does not exist." << std::endl;
+            sources.push_back(std::string());
+        }
+        else
+            sources.push_back(std::string((const char*)file.getData(), file.getSize()));
+
+        // the stage type goes in too, the same file could be another stage of another program
+        keyed += std::to_string(stage.type) + '\n' + sources.back() + '\n';
+    }
+    unsigned long long key = hashBytes(keyed.data(), keyed.size());
+
+    GLuint program = glCreateProgram();
+    if (supported) {
+        std::unordered_map<unsigned long long, Binary>::iterator binary = binaries.find(key);
+        if (binary != binaries.end()) {
+            TRACE_SCOPE("load program binary");
+            glProgramBinary(program, binary->second.format, &binary->second.data[0], (GLsizei)binary->second.data.size());
+            GLint linked = GL_FALSE;
+            glGetProgramiv(program, GL_LINK_STATUS, &linked);
+            if (linked) {
+                hits++;
+                return program;
+            }
+
+            // refused, the program starts over from the sources and replaces it
+            binaries.erase(binary);
+            changed = true;
+            glDeleteProgram(program);
+            program = glCreateProgram();
+        }
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    misses++;
+    if (!compile(program, stages, sources) || !supported)
+        return program;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length > 0) { // 0 when the driver has no binary format at all
+        Binary binary;
+        binary.data.resize(length);
+        GLsizei written = 0;
+        glGetProgramBinary(program, length, &written, &binary.format, &binary.data[0]);
+        if (written > 0) {
+            binary.data.resize(written);
+            binaries[key] = std::move(binary);
+            changed = true;
+        }
+    }
+    return program;
+}
+
+bool ProgramCache::compile(GLuint program, const std::vector<ShaderStage>& stages, const std::vector<std::string>& sources) {
+    /* compiles the stages and links them into program
+    * returns whether it linked, the errors are written to cerr
+    */
+    TRACE_SCOPE("compile shaders");
+    int success;
+    char infoLog[512];
+    std::vector<GLuint> shaders;
+
+    for (size_t i = 0; i < stages.size(); i++) {
+        const char* source = sources[i].c_str();
+        GLuint shader = glCreateShader(stages[i].type);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+
+        // check for shader compile errors
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            const char* stageName = stages[i].type == GL_VERTEX_SHADER ? "VERTEX" : (stages[i].type == GL_GEOMETRY_SHADER ? "GEOMETRY" : "FRAGMENT");
+            glGetShaderInfoLog(shader, 512, NULL, infoLog);
+            std::cerr << "ERROR::SHADER::" << stageName << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+        }
+        glAttachShader(program, shader);
+        shaders.push_back(shader);
+    }
+
+    //link the shader program
+    glLinkProgram(program);
+
+    // check for linking errors
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+
+    //delete shaders since they are already in the program
+    for (GLuint shader : shaders)
+        glDeleteShader(shader);
+    return success != 0;
+}
@@ -0,0 +1,71 @@
+#ifndef PROGRAM_CACHE_CLASS_H
+#define PROGRAM_CACHE_CLASS_H
+
+#include <GL/glew.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Keeps the linked shader programs the driver hands back with glGetProgramBinary, so from the second start on the
+* programs are loaded with glProgramBinary instead of compiling and linking the GLSL again (the longest part of the
+* startup on the cabinets).
+* A program is found by the hash of its stages' sources and of the driver's vendor, renderer and version strings:
+* editing a shader or updating the driver misses the cache and the program is compiled as before, then cached again.
+* The driver can still refuse a binary (a change its strings do not show), the program is then compiled from the
+* sources too.
+*
+* Every program is in one file: a ProgramCacheHeader, then a ProgramCacheEntry followed by its binary for each one.
+* It is only written when a program was compiled, delete it to start over.
+*/
+
+struct ProgramCacheHeader {
+	char magic[8]; // "SHCPRG" and two 0
+	int version;
+	int entryCount;
+};
+
+struct ProgramCacheEntry {
+	unsigned long long key; // of the sources and the driver
+	unsigned int format; // the driver's binary format
+	unsigned int size;
+	unsigned long long hash; // of the binary, a damaged one is dropped when the file is read
+};
+
+const int PROGRAM_CACHE_VERSION = 1;
+
+struct ShaderStage {
+	GLenum type; // GL_VERTEX_SHADER, GL_GEOMETRY_SHADER or GL_FRAGMENT_SHADER
+	std::string filePath;
+};
+
+class ProgramCache {
+public:
+	// on the GL thread with the context current, reads filePath if there is one (the cache is empty otherwise)
+	void open(std::string pFilePath);
+	bool save(); // writes the file when a program was added, false if it cannot be written
+
+	GLuint getProgram(const std::vector<ShaderStage>& stages); // loaded from the cache or compiled and linked
+
+	bool isSupported() const { return supported; } // whether this GL gives program binaries
+	int getHitCount() const { return hits; }
+	int getMissCount() const { return misses; }
+
+private:
+	struct Binary {
+		GLenum format;
+		std::vector<unsigned char> data;
+	};
+
+	std::string filePath;
+	std::string driver; // vendor, renderer and version
+	bool supported = false;
+	bool changed = false;
+	int hits = 0, misses = 0;
+	std::unordered_map<unsigned long long, Binary> binaries; // by key
+
+	bool compile(GLuint program, const std::vector<ShaderStage>& stages, const std::vector<std::string>& sources);
+};
+
+const char* const PROGRAM_CACHE_PATH = "../ProgramCache.shcprg";
+
+#endif
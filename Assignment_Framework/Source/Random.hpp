@@ -0,0 +1,47 @@
+#ifndef RANDOM_CLASS_H
+#define RANDOM_CLASS_H
+
+#include <cstdint>
+
+class Random {
+	/* small PCG32 generator, every owner keeps its own so a session can be replayed from its seed
+	* (rand() is shared by the whole program and its sequence differs between the standard libraries)
+	*/
+public:
+	Random(uint64_t pSeed = 1) { setSeed(pSeed); }
+
+	void setSeed(uint64_t pSeed) {
+		seed = pSeed;
+		state = 0;
+		nextUInt();
+		state += seed;
+		nextUInt();
+	}
+
+	uint64_t getSeed() const { return seed; }
+
+	uint32_t nextUInt() {
+		uint64_t old = state;
+		state = old * 6364136223846793005ULL + increment;
+		uint32_t xorShifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+		uint32_t rotation = (uint32_t)(old >> 59);
+		return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+	}
+
+	int nextInt(int bound) {
+		/* uniform integer in [0, bound), rejects the few values that would make the low numbers more likely than % does */
+		uint32_t threshold = (uint32_t)(0x100000000ULL % (uint32_t)bound);
+		for (;;) {
+			uint32_t value = nextUInt();
+			if (value >= threshold)
+				return (int)(value % (uint32_t)bound);
+		}
+	}
+
+private:
+	uint64_t seed;
+	uint64_t state;
+	static const uint64_t increment = 1442695040888963407ULL; // any odd constant, picks the stream
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef RENDER_TARGET_CLASS_H
+#define RENDER_TARGET_CLASS_H
+
+#include <GL/glew.h>
+
+class RenderTarget {
+	/* framebuffer with a color and a depth buffer to draw the scene into instead of the window,
+	* for offscreen contexts that have no window to draw into
+	*/
+public:
+	bool create(int pWidth, int pHeight);
+	void destroy();
+
+	GLuint getFramebuffer() const { return framebuffer; }
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+
+private:
+	GLuint framebuffer = 0;
+	GLuint colorBuffer = 0;
+	GLuint depthBuffer = 0;
+	int width = 0;
+	int height = 0;
+};
+
+#endif
@@ -0,0 +1,258 @@
+#include "Simulation.hpp"
+#include "WallBuilder.hpp"
+#include "Trace.hpp"
+#include "JobSystem.hpp"
+#include <cmath>
+
+using namespace glm;
+
+GameSimulation::GameSimulation(std::vector<std::string> pShapePaths, vec3 pStartingPoint) {
+    shapePaths = pShapePaths;
+    startingPoint = pStartingPoint;
+    shapePosition = startingPoint;
+    shapeRotation = getRotationQuat(shapeOrientation);
+}
+
+void GameSimulation::loadShapes() {
+    // voxelizes every shape in all of its orientations and the wall made for it, then solves each wall
+    TRACE_SCOPE("load shapes");
+    shapeOccupancies.assign(shapePaths.size(), ShapeOccupancy());
+    orientationSolutions.assign(shapePaths.size(), OrientationSolution());
+
+    // the shapes do not depend on each other, one job per shape
+    jobSystem().parallelFor((int)shapePaths.size(), 1, [this](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            TRACE_SCOPE("load shape");
+            Bitmask2D wallMask = buildWallMask(shapePaths[i]);
+            shapeOccupancies[i] = buildShapeOccupancy(VoxelSet::fromCSV(shapePaths[i], wallMask.getWidth()), wallMask);
+            orientationSolutions[i] = solveOrientations(shapeOccupancies[i].passingOrientations);
+        }
+    });
+}
+
+void GameSimulation::startGame() {
+    /* first shape of a session, keeps currentShape so the models that were built for it stay valid */
+    gameStartTime = time;
+    timeSinceLastPassed = time;
+
+    shapePosition = startingPoint;
+    shapeOrientation = random.nextInt(CUBE_ROTATION_COUNT); // any of the 24 ways a cube can sit, each equally likely
+    targetOrientation = shapeOrientation;
+    shapeRotation = getRotationQuat(shapeOrientation);
+}
+
+float GameSimulation::getTimeLeft() const {
+    return totalTime - (time - gameStartTime);
+}
+
+SimulationSnapshot GameSimulation::getSnapshot() const {
+    SimulationSnapshot snapshot;
+    snapshot.shapePosition = shapePosition;
+    snapshot.shapeRotation = shapeRotation;
+    snapshot.cameraPositionBias = cameraPositionBias;
+    return snapshot;
+}
+
+unsigned int GameSimulation::tick(const SimulationInput& input, float dt) {
+    /* advances the game by dt seconds and returns the SimulationEvent flags raised along the way
+    *   input - state of the game keys for this tick
+    *   dt - seconds since the last tick
+    */
+    unsigned int events = 0;
+    time += dt;
+
+    if (gameRunning) {
+        // make shape go towards wall
+        shapePosition += vec3(0.0f, 0.0f, movementSpeed * dt);
+
+        if (shapePosition.z > 0.0f) {
+            movementSpeed = slowMovementSpeed;
+            events |= nextShape(); // called when we need a reset and a new model
+        }
+
+        updateRotation(input, dt);
+
+        // speed up model
+        if (!input.speedUp)
+            speedUpLastReleased = true;
+        else if (speedUpLastReleased) {
+            movementSpeed = fastMovementSpeed;
+            speedUpLastReleased = false;
+        }
+
+        updateCamera(input, dt);
+    }
+    else if (input.restart) {
+        score = 0;
+        totalTime = 60.0f;
+        gameStartTime = time;
+        timeWarningGiven = false;
+        events |= nextShape();
+        gameRunning = true;
+        events |= EVENT_GAME_RESTARTED;
+    }
+
+    if (getTimeLeft() < timeWarning && !timeWarningGiven) {
+        timeWarningGiven = true;
+        events |= EVENT_TIME_WARNING;
+    }
+
+    if (gameRunning && getTimeLeft() < 0) {
+        endGame();
+        events |= EVENT_GAME_OVER;
+    }
+
+    return events;
+}
+
+unsigned int GameSimulation::nextShape() {
+    /* scores the shape that reached the wall and brings in a new one */
+    TRACE_SCOPE("next shape");
+    unsigned int events = EVENT_NEW_SHAPE;
+
+    // scoring factors
+    int scoreForPassingWall = 100;
+    int timeScoreBonus = 300;
+    float timeBonusFactor = 0.9f;
+
+    if (gameRunning) {
+        // check if the silhouette of the shape in its current orientation fits in the hole of the wall,
+        // a shape still in the middle of a turn fits in none
+        if (!shapeRotating && orientationPasses(shapeOccupancies[currentShape], shapeOrientation)) {
+            int scoreToAdd = scoreForPassingWall + (int)(timeScoreBonus * pow(timeBonusFactor, time - timeSinceLastPassed));
+            score += scoreToAdd;
+            highScore = score > highScore ? score : highScore;
+            totalTime += (score <= 1000 ? 5.0f : (5000.0f / (float)score));
+            events |= EVENT_WALL_PASSED;
+            traceInstant("wall passed");
+            traceCounter("score", score);
+        }
+        else {
+            events |= EVENT_WALL_HIT;
+            traceInstant("wall hit");
+        }
+    }
+
+    timeSinceLastPassed = time; // used for scoring the time component
+
+    shapeRotating = false; // stops errors that occur from the shape being in mid rotation when it passes the wall
+    currentDeg = 0.0f;
+
+    shapePosition = startingPoint; // brings shape to intial position
+    shapeOrientation = random.nextInt(CUBE_ROTATION_COUNT); // creates a random orientation for the new shape
+    targetOrientation = shapeOrientation;
+    shapeRotation = getRotationQuat(shapeOrientation);
+
+    int shapeIndex = random.nextInt((int)shapePaths.size());
+    while (shapePaths.size() > 1 && shapeIndex == currentShape) // ensure past shape is not the same as the new one
+        shapeIndex = random.nextInt((int)shapePaths.size());
+    currentShape = shapeIndex;
+
+    return events;
+}
+
+void GameSimulation::updateRotation(const SimulationInput& input, float dt) {
+    /* animates the quarter turn in progress, or starts a new one from the rotation keys */
+    float goalDeg = 90.0f; // how big a rotation will be
+
+    if (shapeRotating) {
+        if (currentDeg < goalDeg) { // continue rotation loop
+            // if else checks if we are allowed to increase the rotation by the full allowed amount or not
+            if (currentDeg + rateOfRotation * dt > goalDeg)
+                shapeRotation = angleAxis(radians(goalDeg - currentDeg), rotationAxis) * shapeRotation;
+            else
+                shapeRotation = angleAxis(radians(rateOfRotation * dt), rotationAxis) * shapeRotation;
+
+            currentDeg += rateOfRotation * dt;
+        }
+        else { // end rotation loop
+            currentDeg = 0.0f;
+            shapeRotating = false;
+            shapeOrientation = targetOrientation; // the turn only counts once it is done
+            shapeRotation = getRotationQuat(shapeOrientation); // snap to the exact orientation so float error never builds up
+        }
+        return;
+    }
+
+    // axis each move turns about, in the order of RotationMove
+    static const vec3 moveAxes[MOVE_COUNT] = {
+        vec3(1.0f, 0.0f, 0.0f), -vec3(1.0f, 0.0f, 0.0f),
+        vec3(0.0f, 1.0f, 0.0f), -vec3(0.0f, 1.0f, 0.0f),
+        vec3(0.0f, 0.0f, 1.0f), -vec3(0.0f, 0.0f, 1.0f)
+    };
+    // same priority the keys always had when several are held
+    static const RotationMove keyOrder[MOVE_COUNT] = { MOVE_W, MOVE_S, MOVE_A, MOVE_D, MOVE_Q, MOVE_E };
+
+    currentDeg = 0.0f;
+    for (RotationMove move : keyOrder) {
+        if (input.rotate[move]) {
+            shapeRotating = true;
+            rotationAxis = moveAxes[move];
+            targetOrientation = applyMove(move, shapeOrientation);
+            break;
+        }
+    }
+}
+
+void GameSimulation::updateCamera(const SimulationInput& input, float dt) {
+    /* eases the follow camera between the 3x3 positions picked with the arrow keys */
+    if (cameraMoving) {
+        if (cameraMovement >= cameraMoveDistance) { // we finish moving
+            cameraPositionBias = cameraInitialBias + (cameraMoveDistance * cameraMovementDirection); // snap into the proper position
+            cameraMovement = 0.0f;
+            cameraMoving = false;
+        }
+        else { // we continue to move
+            cameraPositionBias += cameraMoveSpeed * dt * cameraMovementDirection;
+            cameraMovement += cameraMoveSpeed * dt;
+        }
+        return;
+    }
+
+    cameraInitialBias = cameraPositionBias;
+
+    if (input.cameraLeft) {
+        if (cameraPositionX != 1) { // make sure the camera is not all the way to the left
+            cameraMoving = true;
+            cameraMovementDirection = vec3(1.0f, 0.0f, 0.0f);
+            cameraPositionX++;
+        }
+    }
+    else if (input.cameraRight) {
+        if (cameraPositionX != -1) { // make sure the camera is not all the way to the right
+            cameraMoving = true;
+            cameraMovementDirection = vec3(-1.0f, 0.0f, 0.0f);
+            cameraPositionX--;
+        }
+    }
+    else if (input.cameraUp) {
+        if (cameraPositionY != 1) { // make sure the camera is not all the way to the top
+            cameraMoving = true;
+            cameraMovementDirection = vec3(0.0f, 1.0f, 0.0f);
+            cameraPositionY++;
+        }
+    }
+    else if (input.cameraDown) {
+        if (cameraPositionY != -1) { // make sure the camera is not all the way to the bottom
+            cameraMoving = true;
+            cameraMovementDirection = vec3(0.0f, -1.0f, 0.0f);
+            cameraPositionY--;
+        }
+    }
+}
+
+void GameSimulation::endGame() {
+    // stops the game, the end screen itself is up to the renderer
+    gameRunning = false;
+    shapeRotating = false;
+    currentDeg = 0.0f;
+    targetOrientation = shapeOrientation; // a turn cut short does not happen
+    shapePosition = startingPoint;
+    shapeRotation = quat(vec3(0.0f));
+
+    cameraPositionBias = vec3(0.0f);
+    cameraMoving = false;
+    cameraMovement = 0.0f;
+    cameraPositionX = 0;
+    cameraPositionY = 0;
+}
@@ -0,0 +1,127 @@
+#ifndef SIMULATION_CLASS_H
+#define SIMULATION_CLASS_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <string>
+#include <vector>
+#include "CubeRotation.hpp"
+#include "OrientationSolver.hpp"
+#include "Random.hpp"
+
+/* Game logic of the shape and wall game with no window, OpenGL or sound behind it.
+* Everything is advanced by tick() from an input snapshot and an explicit dt, the renderer copies the state it needs
+* out of the public members and reacts to the events a tick returns (sounds, explosion, score flicker, new wall).
+* All of its randomness comes from its own seeded generator, so the same seed and inputs always play the same game.
+*/
+
+struct SimulationInput {
+	bool rotate[MOVE_COUNT] = {}; // W, S, A, D, E, Q
+	bool speedUp = false; // space
+	bool cameraLeft = false, cameraRight = false, cameraUp = false, cameraDown = false; // arrow keys
+	bool restart = false; // Y on the end screen
+};
+
+enum SimulationEvent { // bit flags returned by tick()
+	EVENT_WALL_PASSED = 1 << 0, // shape fit through the wall and scored
+	EVENT_WALL_HIT = 1 << 1, // shape crashed into the wall
+	EVENT_NEW_SHAPE = 1 << 2, // currentShape changed, the shape and wall models have to be swapped
+	EVENT_TIME_WARNING = 1 << 3, // less than timeWarning seconds left
+	EVENT_GAME_OVER = 1 << 4,
+	EVENT_GAME_RESTARTED = 1 << 5
+};
+
+struct SimulationSnapshot {
+	// what the renderer needs to place the moving things, so it can draw in between two ticks
+	glm::vec3 shapePosition;
+	glm::quat shapeRotation;
+	glm::vec3 cameraPositionBias;
+};
+
+inline SimulationSnapshot interpolateSnapshots(const SimulationSnapshot& previous, const SimulationSnapshot& current, float alpha) {
+	/* blends the state of two consecutive ticks
+	*	alpha - 0 gives previous, 1 gives current
+	*/
+	SimulationSnapshot result;
+	result.shapePosition = glm::mix(previous.shapePosition, current.shapePosition, alpha);
+	result.shapeRotation = glm::slerp(previous.shapeRotation, current.shapeRotation, alpha);
+	result.cameraPositionBias = glm::mix(previous.cameraPositionBias, current.cameraPositionBias, alpha);
+	return result;
+}
+
+class GameSimulation {
+public:
+	GameSimulation(std::vector<std::string> pShapePaths, glm::vec3 pStartingPoint);
+
+	void loadShapes();
+
+	void setSeed(uint64_t seed) { random.setSeed(seed); }
+	uint64_t getSeed() const { return random.getSeed(); }
+
+	unsigned int tick(const SimulationInput& input, float dt);
+
+	void startGame();
+
+	float getTimeLeft() const;
+
+	SimulationSnapshot getSnapshot() const;
+
+	const ShapeOccupancy& getCurrentOccupancy() const { return shapeOccupancies[currentShape]; }
+	const OrientationSolution& getCurrentSolution() const { return orientationSolutions[currentShape]; }
+
+	// shape state
+	glm::vec3 shapePosition;
+	glm::quat shapeRotation; // animated, only equal to getRotationQuat(shapeOrientation) between turns
+	int shapeOrientation = IDENTITY_ROTATION; // index in the cube rotation group, what the wall checks, set when a turn ends
+	int targetOrientation = IDENTITY_ROTATION; // where the turn in progress ends, shapeOrientation between turns
+	int currentShape = 0;
+	bool shapeRotating = false;
+
+	// game state
+	int score = 0;
+	int highScore = 0;
+	float totalTime = 60.0f; // seconds to play, grows every time a wall is passed
+	float time = 0.0f; // seconds simulated since the simulation was made
+	float gameStartTime = 0.0f;
+	float timeSinceLastPassed = 0.0f; // time the last wall was reached, for the time bonus of the score
+	bool timeWarningGiven = false;
+	bool gameRunning = true;
+
+	glm::vec3 cameraPositionBias = glm::vec3(0.0f); // offset of the follow camera picked with the arrow keys
+
+	std::vector<std::string> shapePaths;
+	std::vector<ShapeOccupancy> shapeOccupancies;
+	std::vector<OrientationSolution> orientationSolutions; // shortest way from each orientation to one that passes
+
+	// tuning
+	float slowMovementSpeed = 2.0f;
+	float fastMovementSpeed = 10.0f;
+	float rateOfRotation = 270.0f; // degrees per second of a turn
+	float cameraMoveSpeed = 6.0f;
+	float cameraMoveDistance = 2.0f;
+	float timeWarning = 10.0f;
+
+private:
+	glm::vec3 startingPoint;
+	Random random;
+	float movementSpeed = 1.0f;
+
+	float currentDeg = 0.0f; // how much of the current turn has been done
+	glm::vec3 rotationAxis = glm::vec3(1.0f, 0.0f, 0.0f);
+
+	bool cameraMoving = false;
+	glm::vec3 cameraInitialBias;
+	glm::vec3 cameraMovementDirection;
+	float cameraMovement = 0.0f;
+	int cameraPositionX = 0; // -1 right, 0 center, 1 left
+	int cameraPositionY = 0; // -1 down, 0 center, 1 up
+
+	bool speedUpLastReleased = true;
+
+	unsigned int nextShape();
+	void updateRotation(const SimulationInput& input, float dt);
+	void updateCamera(const SimulationInput& input, float dt);
+	void endGame();
+};
+
+#endif
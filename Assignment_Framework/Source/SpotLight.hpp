@@ -3,6 +3,7 @@
 
 #include <glm/glm.hpp>
 #include <GL/glew.h>
+#include "GLMetrics.hpp"
 #include <string>
 
 using namespace std;
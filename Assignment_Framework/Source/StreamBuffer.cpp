@@ -0,0 +1,110 @@
+#include "StreamBuffer.hpp"
+#include "GLMetrics.hpp"
+#include <iostream>
+
+// GL_COPY_WRITE_BUFFER is bound for the buffer's own calls so no binding the draws rely on is disturbed
+
+void StreamBuffer::create(GLsizeiptr pRegionSize, int pRegionCount) {
+    regionSize = pRegionSize;
+    regionCount = pRegionCount;
+    region = 0;
+    used = 0;
+    fences.assign(regionCount, (GLsync)0);
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+
+    persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+    if (persistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, regionSize * regionCount, NULL, flags);
+        mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, regionSize * regionCount, flags);
+        if (mapped == NULL) {
+            // buffer storage is immutable, the fallback needs a new buffer
+            std::cerr << "Could not map the stream buffer persistently, falling back to orphaning" << std::endl;
+            persistent = false;
+            glDeleteBuffers(1, &buffer);
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        }
+    }
+    if (!persistent) {
+        glBufferData(GL_COPY_WRITE_BUFFER, regionSize, NULL, GL_STREAM_DRAW);
+        staging.resize(regionSize);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void StreamBuffer::destroy() {
+    for (GLsync& fence : fences) {
+        if (fence != 0)
+            glDeleteSync(fence);
+        fence = 0;
+    }
+    if (mapped != NULL) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        mapped = NULL;
+    }
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+}
+
+void StreamBuffer::beginFrame() {
+    used = 0;
+    if (buffer == 0)
+        return;
+
+    if (persistent) {
+        region = (region + 1) % regionCount;
+        GLsync& fence = fences[region];
+        if (fence != 0) {
+            // only blocks when the CPU is regionCount frames ahead of the GPU
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+                ;
+            glDeleteSync(fence);
+            fence = 0;
+        }
+    }
+    else {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, regionSize, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+void* StreamBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment, GLintptr& offset) {
+    GLsizeiptr start = (used + alignment - 1) / alignment * alignment;
+    if (buffer == 0 || start + size > regionSize) {
+        if (buffer != 0 && !overflowReported) {
+            std::cerr << "Stream buffer region of " << regionSize << " bytes is full, some per frame data was not drawn" << std::endl;
+            overflowReported = true;
+        }
+        return NULL;
+    }
+    used = start + size;
+
+    if (persistent) {
+        offset = region * regionSize + start;
+        return mapped + offset;
+    }
+    offset = start;
+    return &staging[start];
+}
+
+void StreamBuffer::commit(GLintptr offset, GLsizeiptr size) {
+    // the persistent mapping is coherent, what was written is already visible
+    if (persistent)
+        return;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, &staging[offset]);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void StreamBuffer::endFrame() {
+    if (persistent)
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,48 @@
+#ifndef STREAM_BUFFER_CLASS_H
+#define STREAM_BUFFER_CLASS_H
+
+#include <GL/glew.h>
+#include <vector>
+
+class StreamBuffer {
+	/* Buffer for data that is rewritten every frame (instances, uniform blocks, text...). Users allocate() a range of
+	* the current frame's region, write into the pointer they get back, commit() it, then draw or bind from the offset.
+	* With buffer storage (GL 4.4) the buffer is mapped once, persistent and coherent, and split into regionCount
+	* regions used in turn: a fence after each frame tells when the GPU is done reading a region, and beginFrame() only
+	* waits when it has to reuse a region the GPU is still on, so writing never goes through the driver.
+	* Without it, beginFrame() orphans the buffer with glBufferData (the driver gives it new storage and keeps the old
+	* one alive for the draws still using it) and commit() uploads the range with glBufferSubData.
+	*/
+public:
+	void create(GLsizeiptr pRegionSize, int pRegionCount = 3);
+	void destroy();
+
+	void beginFrame();
+	void* allocate(GLsizeiptr size, GLsizeiptr alignment, GLintptr& offset); // NULL when this frame's region is full
+	void commit(GLintptr offset, GLsizeiptr size); // the range written through allocate() becomes visible to the GPU
+	void endFrame(); // after the last draw that reads this frame's data
+
+	GLuint getBuffer() const { return buffer; }
+	bool isPersistent() const { return persistent; }
+	GLsizeiptr getUsed() const { return used; } // bytes allocated this frame
+
+private:
+	GLuint buffer = 0;
+	GLsizeiptr regionSize = 0;
+	int regionCount = 0;
+	int region = 0; // region of the current frame
+	GLsizeiptr used = 0;
+	bool persistent = false;
+	bool overflowReported = false;
+
+	unsigned char* mapped = NULL; // persistent mapping of all the regions
+	std::vector<GLsync> fences; // one per region, 0 when the GPU is not reading it
+	std::vector<unsigned char> staging; // written by the users when there is no persistent mapping
+};
+
+inline StreamBuffer& frameStreamBuffer() {
+	static StreamBuffer stream; // shared by everything that streams per frame data, created by the main program
+	return stream;
+}
+
+#endif
@@ -4,12 +4,25 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glew-2.1.0/include/GL/glew.h>
+#include "GLMetrics.hpp"
+#include "StreamBuffer.hpp"
+#include <cstddef>
+#include <cstring>
+#include <vector>
 
 using namespace std;
 using namespace glm;
 
+// one lit pixel of a string, drawn as an instance of the pixel quad
+struct TextPixel {
+	vec3 position; // center
+	float size;
+	vec3 color;
+};
+
 GLuint pixelVAO;
 bool initialized = false;
+vector<TextPixel> textPixels; // pixels of the string being drawn, reused between strings
 using namespace std;
 using namespace glm;
 
@@ -425,6 +438,12 @@ void init() {
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*)0);
 	glEnableVertexAttribArray(0);
 
+	// per pixel position and size, then color, read from the stream buffer by drawString
+	glEnableVertexAttribArray(1);
+	glVertexAttribDivisor(1, 1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribDivisor(2, 1);
+
 	// cleanup
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
@@ -433,10 +452,8 @@ void init() {
 	initialized = true; // flag the renderer
 }
 
-int drawLetter(char letter, vec3 pos, vec3 color, GLfloat pScale, GLuint shaderProgram) {
-	if (!initialized)
-		::init();
-
+int drawLetter(char letter, vec3 pos, vec3 color, GLfloat pScale) {
+	// adds the lit pixels of the letter to textPixels, returns its width in pixels
 	bool* charInfo;
 	int width = 3;
 	int height = 5;
@@ -596,33 +613,15 @@ int drawLetter(char letter, vec3 pos, vec3 color, GLfloat pScale, GLuint shaderP
 		break;
 	}
 
-	glUseProgram(shaderProgram);
-	glBindVertexArray(pixelVAO);
-
-	GLuint worldMatrixLocation = glGetUniformLocation(shaderProgram, "worldMatrix");
-
-	mat4 worldMatrix(1.0);
-	worldMatrix = translate(worldMatrix, pos);
-	worldMatrix = scale(worldMatrix, vec3(pScale));
-
-	//set color of the letter
-	glUniform3fv(glGetUniformLocation(shaderProgram, "aColor"), 1, &color[0]);
-
 	for (int i = 0; i < height; i++) {
 		for (int j = 0; j < width; j++) {
-			glUniformMatrix4fv(worldMatrixLocation, 1, GL_FALSE, &worldMatrix[0][0]);
-
-			if(charInfo[width*i + j])
-				glDrawArrays(GL_TRIANGLES, 0, 6);
-
-			worldMatrix = translate(worldMatrix, vec3(1.0f, 0.0f, 0.0f));
+			if (charInfo[width*i + j]) {
+				TextPixel pixel = { pos + vec3(j, -i, 0.0f) * pScale, pScale, color };
+				textPixels.push_back(pixel);
+			}
 		}
-		worldMatrix = translate(worldMatrix, vec3(-width, 0.0f, 0.0f)); // reset back to left of
-		worldMatrix = translate(worldMatrix, vec3(0.0f, -1.0f, 0.0f)); // move one row down
 	}
 
-	glBindVertexArray(0);
-
 	return width;
 }
 
@@ -632,6 +631,10 @@ void drawString(string stringToDraw, vec3 pos, vec3 color, GLfloat pScale, GLuin
 	vec3 drawPOS = pos;
 	vec3 startOfLine = drawPOS;
 
+	if (!initialized)
+		::init();
+
+	textPixels.clear();
 	for (int i = 0; i < stringToDraw.size(); i++) {
 		charToDraw = toupper(stringToDraw[i]);
 		if (charToDraw == '\n') { // create a new line
@@ -639,10 +642,32 @@ void drawString(string stringToDraw, vec3 pos, vec3 color, GLfloat pScale, GLuin
 			drawPOS = startOfLine;
 		}
 		else { // draw a letter
-			drawnWidth = drawLetter(charToDraw, drawPOS, color, pScale, shaderProgram);
+			drawnWidth = drawLetter(charToDraw, drawPOS, color, pScale);
 			drawPOS += vec3((drawnWidth + 1) * pScale, 0, 0);
 		}
 	}
+	if (textPixels.empty())
+		return;
+
+	// the whole string is one instanced draw, its pixels streamed with the frame's other dynamic data
+	GLsizeiptr size = textPixels.size() * sizeof(TextPixel);
+	GLintptr offset;
+	void* data = frameStreamBuffer().allocate(size, 16, offset);
+	if (data == NULL)
+		return;
+	memcpy(data, &textPixels[0], size);
+	frameStreamBuffer().commit(offset, size);
+
+	glUseProgram(shaderProgram);
+	glBindVertexArray(pixelVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, frameStreamBuffer().getBuffer());
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(TextPixel), (void*)offset);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(TextPixel), (void*)(offset + offsetof(TextPixel, color)));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)textPixels.size());
+
+	glBindVertexArray(0);
 }
 
 class stringFlickeringEngine {
@@ -0,0 +1,331 @@
+#include "TextureCooker.hpp"
+#include "AssetPack.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stb_image.h>
+
+static const char COOKED_TEXTURE_MAGIC[8] = "SHCTEX";
+
+//////////////////////////////////////////////// MIP CHAIN ////////////////////////////////////////////////
+
+struct Image {
+    int width, height;
+    std::vector<unsigned char> pixels; // RGBA
+};
+
+static Image halve(const Image& image) {
+    // 2x2 box filter, an odd row or column is averaged with the one before it
+    Image half;
+    half.width = std::max(image.width / 2, 1);
+    half.height = std::max(image.height / 2, 1);
+    half.pixels.resize((size_t)half.width * half.height * 4);
+
+    for (int y = 0; y < half.height; y++) {
+        int y0 = std::min(y * 2, image.height - 1), y1 = std::min(y * 2 + 1, image.height - 1);
+        for (int x = 0; x < half.width; x++) {
+            int x0 = std::min(x * 2, image.width - 1), x1 = std::min(x * 2 + 1, image.width - 1);
+            const unsigned char* a = &image.pixels[((size_t)y0 * image.width + x0) * 4];
+            const unsigned char* b = &image.pixels[((size_t)y0 * image.width + x1) * 4];
+            const unsigned char* c = &image.pixels[((size_t)y1 * image.width + x0) * 4];
+            const unsigned char* d = &image.pixels[((size_t)y1 * image.width + x1) * 4];
+            unsigned char* out = &half.pixels[((size_t)y * half.width + x) * 4];
+            for (int i = 0; i < 4; i++)
+                out[i] = (unsigned char)((a[i] + b[i] + c[i] + d[i] + 2) / 4);
+        }
+    }
+    return half;
+}
+
+//////////////////////////////////////////////// BC ENCODING ////////////////////////////////////////////////
+
+static void putBytes(std::vector<unsigned char>& out, unsigned long long value, int count) {
+    for (int i = 0; i < count; i++)
+        out.push_back((unsigned char)(value >> (i * 8)));
+}
+
+static unsigned short packRGB565(const float* color) {
+    int r = std::min(std::max((int)(color[0] * 31.0f / 255.0f + 0.5f), 0), 31);
+    int g = std::min(std::max((int)(color[1] * 63.0f / 255.0f + 0.5f), 0), 63);
+    int b = std::min(std::max((int)(color[2] * 31.0f / 255.0f + 0.5f), 0), 31);
+    return (unsigned short)((r << 11) | (g << 5) | b);
+}
+
+static void unpackRGB565(unsigned short packed, int* color) {
+    int r = packed >> 11, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+static void encodeColorBlock(const unsigned char block[16][4], std::vector<unsigned char>& out) {
+    /* the two end colors are the extremes of the block along its main axis (the direction the colors spread the
+    * most, found by power iteration on their covariance), each pixel gets the closest of the 4 colors between them
+    */
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++)
+            mean[c] += block[i][c] / 16.0f;
+
+    float covariance[3][3] = {};
+    for (int i = 0; i < 16; i++) {
+        float d[3] = { block[i][0] - mean[0], block[i][1] - mean[1], block[i][2] - mean[2] };
+        for (int a = 0; a < 3; a++)
+            for (int b = 0; b < 3; b++)
+                covariance[a][b] += d[a] * d[b];
+    }
+
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; iteration++) {
+        float next[3];
+        for (int a = 0; a < 3; a++)
+            next[a] = covariance[a][0] * axis[0] + covariance[a][1] * axis[1] + covariance[a][2] * axis[2];
+        float length = std::max(std::max(std::fabs(next[0]), std::fabs(next[1])), std::fabs(next[2]));
+        if (length < 1e-6f)
+            break; // a flat block, any axis will do
+        for (int a = 0; a < 3; a++)
+            axis[a] = next[a] / length;
+    }
+
+    float lowest = 1e30f, highest = -1e30f;
+    for (int i = 0; i < 16; i++) {
+        float t = (block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] + (block[i][2] - mean[2]) * axis[2];
+        lowest = std::min(lowest, t);
+        highest = std::max(highest, t);
+    }
+    float axisLength = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    float low[3], high[3];
+    for (int c = 0; c < 3; c++) {
+        low[c] = mean[c] + axis[c] * lowest / axisLength;
+        high[c] = mean[c] + axis[c] * highest / axisLength;
+    }
+
+    // the first color has to be the bigger one, otherwise the block is read as 3 colors and transparent black
+    unsigned short color0 = packRGB565(high), color1 = packRGB565(low);
+    if (color0 < color1)
+        std::swap(color0, color1);
+
+    int palette[4][3];
+    unpackRGB565(color0, palette[0]);
+    unpackRGB565(color1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    unsigned int indices = 0;
+    if (color0 != color1) {
+        for (int i = 0; i < 16; i++) {
+            int best = 0, bestDistance = 1 << 30;
+            for (int p = 0; p < 4; p++) {
+                int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+                int distance = dr * dr + dg * dg + db * db;
+                if (distance < bestDistance) {
+                    best = p;
+                    bestDistance = distance;
+                }
+            }
+            indices |= (unsigned int)best << (i * 2);
+        }
+    }
+
+    putBytes(out, color0, 2);
+    putBytes(out, color1, 2);
+    putBytes(out, indices, 4);
+}
+
+static void encodeAlphaBlock(const unsigned char block[16][4], std::vector<unsigned char>& out) {
+    // the alphas go between the block's lowest and highest, in 8 steps
+    int alpha0 = 0, alpha1 = 255;
+    for (int i = 0; i < 16; i++) {
+        alpha0 = std::max(alpha0, (int)block[i][3]);
+        alpha1 = std::min(alpha1, (int)block[i][3]);
+    }
+
+    unsigned long long indices = 0;
+    if (alpha0 != alpha1) {
+        int palette[8] = { alpha0, alpha1 };
+        for (int p = 1; p < 7; p++)
+            palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+
+        for (int i = 0; i < 16; i++) {
+            int best = 0, bestDistance = 256;
+            for (int p = 0; p < 8; p++) {
+                int distance = std::abs(block[i][3] - palette[p]);
+                if (distance < bestDistance) {
+                    best = p;
+                    bestDistance = distance;
+                }
+            }
+            indices |= (unsigned long long)best << (i * 3);
+        }
+    }
+
+    out.push_back((unsigned char)alpha0);
+    out.push_back((unsigned char)alpha1);
+    putBytes(out, indices, 6);
+}
+
+static void encodeBC(const Image& image, bool alpha, std::vector<unsigned char>& out) {
+    // the blocks that go past the edge repeat its last row and column
+    for (int blockY = 0; blockY < image.height; blockY += 4) {
+        for (int blockX = 0; blockX < image.width; blockX += 4) {
+            unsigned char block[16][4];
+            for (int y = 0; y < 4; y++) {
+                for (int x = 0; x < 4; x++) {
+                    int pixelX = std::min(blockX + x, image.width - 1), pixelY = std::min(blockY + y, image.height - 1);
+                    memcpy(block[y * 4 + x], &image.pixels[((size_t)pixelY * image.width + pixelX) * 4], 4);
+                }
+            }
+            if (alpha)
+                encodeAlphaBlock(block, out);
+            encodeColorBlock(block, out);
+        }
+    }
+}
+
+//////////////////////////////////////////////// COOKING ////////////////////////////////////////////////
+
+std::string getCookedTexturePath(std::string imagePath) {
+    return imagePath + ".shctex"; // keeps the extension, arrow.jpg and arrow.png are different images
+}
+
+bool cookTexture(std::string imagePath, bool compress) {
+    Image image;
+    int channels;
+    unsigned char* pixels = stbi_load(imagePath.c_str(), &image.width, &image.height, &channels, 4);
+    if (pixels == NULL) {
+        std::cerr << "Could not cook " << imagePath << ": " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+    image.pixels.assign(pixels, pixels + (size_t)image.width * image.height * 4);
+    stbi_image_free(pixels);
+
+    bool alpha = false;
+    for (size_t i = 3; i < image.pixels.size() && !alpha; i += 4)
+        alpha = image.pixels[i] != 255;
+
+    CookedTextureHeader header;
+    memcpy(header.magic, COOKED_TEXTURE_MAGIC, sizeof(header.magic));
+    header.version = COOKED_TEXTURE_VERSION;
+    header.format = compress ? (alpha ? COOKED_BC3 : COOKED_BC1) : (alpha ? COOKED_RGBA8 : COOKED_RGB8);
+    header.width = image.width;
+    header.height = image.height;
+    header.levels = 0;
+
+    std::vector<CookedLevel> levels;
+    std::vector<unsigned char> data;
+    while (true) {
+        CookedLevel level;
+        level.width = image.width;
+        level.height = image.height;
+        level.offset = (unsigned int)data.size();
+
+        if (compress)
+            encodeBC(image, alpha, data);
+        else if (alpha)
+            data.insert(data.end(), image.pixels.begin(), image.pixels.end());
+        else {
+            for (size_t i = 0; i < image.pixels.size(); i += 4)
+                data.insert(data.end(), &image.pixels[i], &image.pixels[i] + 3);
+        }
+
+        level.size = (unsigned int)data.size() - level.offset;
+        levels.push_back(level);
+        if (image.width == 1 && image.height == 1)
+            break;
+        image = halve(image);
+    }
+    header.levels = (int)levels.size();
+
+    std::string cookedPath = getCookedTexturePath(imagePath);
+    FILE* file = fopen(cookedPath.c_str(), "wb");
+    if (file == NULL) {
+        std::cerr << "Could not write " << cookedPath << std::endl;
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(&levels[0], sizeof(CookedLevel), levels.size(), file) == levels.size()
+        && fwrite(&data[0], 1, data.size(), file) == data.size();
+    written = fclose(file) == 0 && written;
+    if (!written) {
+        std::cerr << "Could not write " << cookedPath << std::endl;
+        return false;
+    }
+
+    static const char* formatNames[] = { "RGB", "RGBA", "BC1", "BC3" };
+    std::cout << imagePath << " -> " << cookedPath << ": " << header.width << "x" << header.height << " " << formatNames[header.format]
+        << ", " << header.levels << " levels, " << data.size() / 1024 << " KB" << std::endl;
+    return true;
+}
+
+static std::vector<std::string> listImages(std::string directory) {
+    std::vector<std::string> files = listFiles(directory, false), images;
+    for (size_t i = 0; i < files.size(); i++) {
+        std::string extension = files[i].size() > 4 ? files[i].substr(files[i].size() - 4) : "";
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        if (extension == ".jpg" || extension == ".png")
+            images.push_back(files[i]);
+    }
+    return images;
+}
+
+int cookTextures(std::string directory, bool compress) {
+    std::vector<std::string> images = listImages(directory);
+    if (images.empty())
+        std::cerr << "No .jpg or .png to cook in " << directory << std::endl;
+
+    int failed = 0;
+    for (size_t i = 0; i < images.size(); i++) {
+        if (!cookTexture(images[i], compress))
+            failed++;
+    }
+    return failed;
+}
+
+//////////////////////////////////////////////// LOADING ////////////////////////////////////////////////
+
+const unsigned char* CookedTexture::getData() const {
+    return file.getData() + sizeof(CookedTextureHeader) + levels.size() * sizeof(CookedLevel);
+}
+
+unsigned int CookedTexture::getDataSize() const {
+    return (unsigned int)(file.getSize() - sizeof(CookedTextureHeader) - levels.size() * sizeof(CookedLevel));
+}
+
+bool readCookedTexture(std::string filePath, CookedTexture& texture) {
+    texture.file = assets().open(filePath);
+    if (!texture.file.isOpen())
+        return false;
+
+    const unsigned char* file = texture.file.getData();
+    size_t size = texture.file.getSize();
+    CookedTextureHeader& header = texture.header;
+    bool valid = size >= sizeof(header);
+    if (valid) {
+        memcpy(&header, file, sizeof(header));
+        valid = memcmp(header.magic, COOKED_TEXTURE_MAGIC, sizeof(header.magic)) == 0 && header.version == COOKED_TEXTURE_VERSION
+            && header.format >= COOKED_RGB8 && header.format <= COOKED_BC3 && header.levels > 0 && header.levels <= 32
+            && size >= sizeof(header) + header.levels * sizeof(CookedLevel);
+    }
+    if (valid) {
+        texture.levels.resize(header.levels);
+        memcpy(&texture.levels[0], file + sizeof(header), header.levels * sizeof(CookedLevel));
+        unsigned int dataSize = texture.getDataSize();
+        for (int i = 0; i < header.levels && valid; i++) {
+            const CookedLevel& level = texture.levels[i];
+            valid = level.width > 0 && level.height > 0 && level.offset <= dataSize && level.size <= dataSize - level.offset;
+        }
+    }
+    if (!valid) {
+        std::cerr << "Cooked texture " << filePath << " is damaged or from another version, cook it again" << std::endl;
+        texture.levels.clear();
+        texture.file = AssetView();
+        return false;
+    }
+    return true;
+}
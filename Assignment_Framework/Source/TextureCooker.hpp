@@ -0,0 +1,55 @@
+#ifndef TEXTURE_COOKER_HEADER
+#define TEXTURE_COOKER_HEADER
+
+#include "AssetPack.hpp"
+#include <string>
+#include <vector>
+
+/* Cooks the images in Assets/Textures offline (-cook, -cookbc) into files the GL can take as they are, so nothing
+* has to be decoded or filtered at startup: the image is decoded once, its whole mip chain is made with a box filter
+* and, with -cookbc, every level is compressed to BC1 (S3TC DXT1, 8 bytes a 4x4 block, opaque images) or BC3 (DXT5,
+* 16 bytes a block, images with alpha) on the CPU. BC textures stay compressed on the GPU, 8 and 4 times smaller
+* than RGBA.
+* dirt.jpg is cooked to dirt.jpg.shctex next to it, TextureLoader loads the cooked file instead of the image when
+* there is one. A cooked file is not updated when its image changes, cook again.
+*
+* The file is a CookedTextureHeader, a CookedLevel for each level from the biggest to 1x1, then the levels' data one
+* after the other, all little endian.
+*/
+
+enum CookedTextureFormat { COOKED_RGB8, COOKED_RGBA8, COOKED_BC1, COOKED_BC3 };
+
+struct CookedTextureHeader {
+	char magic[8]; // "SHCTEX" and two 0
+	int version;
+	int format; // a CookedTextureFormat
+	int width, height;
+	int levels;
+};
+
+struct CookedLevel {
+	int width, height;
+	unsigned int offset, size; // of the level's data, from the end of the level table
+};
+
+const int COOKED_TEXTURE_VERSION = 1;
+
+struct CookedTexture {
+	CookedTextureHeader header;
+	std::vector<CookedLevel> levels;
+	AssetView file; // the whole file at once, a view of the asset pack when it is in it
+
+	bool isCompressed() const { return header.format == COOKED_BC1 || header.format == COOKED_BC3; }
+	const unsigned char* getData() const; // the first level's, the others follow it
+	unsigned int getDataSize() const; // of all the levels
+};
+
+std::string getCookedTexturePath(std::string imagePath); // dirt.jpg -> dirt.jpg.shctex
+
+bool cookTexture(std::string imagePath, bool compress); // false if the image cannot be read or the file written
+int cookTextures(std::string directory, bool compress); // every .jpg and .png in directory, returns how many failed
+
+// false if there is no cooked file (quietly) or it is damaged (with an error)
+bool readCookedTexture(std::string filePath, CookedTexture& texture);
+
+#endif
@@ -0,0 +1,364 @@
+#include "TextureLoader.hpp"
+#include "GLMetrics.hpp"
+#include "JobSystem.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stb_image.h>
+
+// GL_PIXEL_UNPACK_BUFFER is left unbound between uploads, with it bound every other glTexImage2D would read from it
+
+static const size_t PLACEHOLDER_BYTES = 4; // the single white RGBA texel a texture has until its image is uploaded
+
+GLuint TextureLoader::load(std::string filePath) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    const unsigned char white[4] = { 255, 255, 255, 255 };
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    std::shared_ptr<TextureRequest> request = std::make_shared<TextureRequest>();
+    request->filePath = filePath;
+    request->texture = texture;
+    request->claimed = false;
+    request->compressionSupported = GLEW_EXT_texture_compression_s3tc != GL_FALSE;
+    queue(request);
+    return texture;
+}
+
+GLuint TextureLoader::createArray(int width, int height) {
+    // the placeholder is a single white layer, the GL clamps the layer drawn with to the ones the array has
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    const unsigned char white[4] = { 255, 255, 255, 255 };
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, 1, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    TextureArray& array = arrays[texture];
+    array.texture = texture;
+    array.width = width;
+    array.height = height;
+    return texture;
+}
+
+int TextureLoader::loadLayer(GLuint texture, std::string filePath) {
+    std::unordered_map<GLuint, TextureArray>::iterator array = arrays.find(texture);
+    if (array == arrays.end() || array->second.uploaded) {
+        std::cerr << "Error::Texture " << filePath << " cannot be added to a texture array that is already uploaded." << std::endl;
+        return -1;
+    }
+
+    std::shared_ptr<TextureRequest> request = std::make_shared<TextureRequest>();
+    request->filePath = filePath;
+    request->texture = texture;
+    request->claimed = false;
+    request->compressionSupported = false;
+    request->layer = (int)array->second.layers.size();
+    request->layerWidth = array->second.width;
+    request->layerHeight = array->second.height;
+    array->second.layers.push_back(request);
+    queue(request);
+    return request->layer;
+}
+
+void TextureLoader::queue(const std::shared_ptr<TextureRequest>& request) {
+    requests.push_back(request);
+
+    // the job keeps the request alive, the loader never holds on to the job: its slot is reused once it is done
+    JobSystem& jobs = jobSystem();
+    jobs.runBackground(jobs.create([this, request]() {
+        if (!request->claimed.exchange(true))
+            decode(request);
+    }));
+}
+
+static void resample(const unsigned char* source, int width, int height, int channels, int layerWidth, int layerHeight, std::vector<unsigned char>& out) {
+    // bilinear between the texels' centers to RGBA, an image of the layer's size comes out as it went in
+    out.resize((size_t)layerWidth * layerHeight * 4);
+    for (int y = 0; y < layerHeight; y++) {
+        float sourceY = std::min(std::max((y + 0.5f) * height / layerHeight - 0.5f, 0.0f), (float)(height - 1));
+        int y0 = (int)sourceY, y1 = std::min(y0 + 1, height - 1);
+        float fractionY = sourceY - y0;
+        for (int x = 0; x < layerWidth; x++) {
+            float sourceX = std::min(std::max((x + 0.5f) * width / layerWidth - 0.5f, 0.0f), (float)(width - 1));
+            int x0 = (int)sourceX, x1 = std::min(x0 + 1, width - 1);
+            float fractionX = sourceX - x0;
+
+            const unsigned char* topLeft = source + ((size_t)y0 * width + x0) * channels;
+            const unsigned char* topRight = source + ((size_t)y0 * width + x1) * channels;
+            const unsigned char* bottomLeft = source + ((size_t)y1 * width + x0) * channels;
+            const unsigned char* bottomRight = source + ((size_t)y1 * width + x1) * channels;
+            unsigned char* texel = &out[((size_t)y * layerWidth + x) * 4];
+            for (int c = 0; c < 4; c++) {
+                if (c >= channels) {
+                    texel[c] = 255; // opaque RGB
+                    continue;
+                }
+                float top = topLeft[c] + (topRight[c] - topLeft[c]) * fractionX;
+                float bottom = bottomLeft[c] + (bottomRight[c] - bottomLeft[c]) * fractionX;
+                texel[c] = (unsigned char)(top + (bottom - top) * fractionY + 0.5f);
+            }
+        }
+    }
+}
+
+void TextureLoader::decodeLayer(TextureRequest& request) {
+    // an RGB or RGBA cooked file saves the decoding, its first level is the image
+    CookedTexture cooked;
+    if (readCookedTexture(getCookedTexturePath(request.filePath), cooked) && !cooked.isCompressed()) {
+        int channels = cooked.header.format == COOKED_RGB8 ? 3 : 4;
+        resample(cooked.getData(), cooked.header.width, cooked.header.height, channels, request.layerWidth, request.layerHeight, request.layerPixels);
+        return;
+    }
+
+    int width, height, channels;
+    AssetView image = assets().open(request.filePath);
+    unsigned char* pixels = NULL;
+    if (image.isOpen())
+        pixels = stbi_load_from_memory(image.getData(), (int)image.getSize(), &width, &height, &channels, 4);
+    if (pixels == NULL) {
+        std::cerr << "Error::Texture could not load texture file:" << request.filePath << std::endl;
+        return; // the layer stays white
+    }
+    resample(pixels, width, height, 4, request.layerWidth, request.layerHeight, request.layerPixels);
+    stbi_image_free(pixels);
+}
+
+void TextureLoader::decode(const std::shared_ptr<TextureRequest>& request) {
+    TRACE_SCOPE("decode texture");
+    // the image is only decoded when it was not cooked, or was cooked to a format this GL does not have
+    CookedTexture& cooked = request->cooked;
+    if (request->layer >= 0)
+        decodeLayer(*request);
+    else if (!readCookedTexture(getCookedTexturePath(request->filePath), cooked) || (cooked.isCompressed() && !request->compressionSupported)) {
+        cooked = CookedTexture();
+        AssetView image = assets().open(request->filePath);
+        if (image.isOpen())
+            request->pixels = stbi_load_from_memory(image.getData(), (int)image.getSize(), &request->width, &request->height, &request->channels, 0);
+        if (request->pixels == NULL)
+            std::cerr << "Error::Texture could not load texture file:" << request->filePath << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    decoded.push_back(request);
+    decodedChanged.notify_all();
+}
+
+void TextureLoader::update() {
+    if (requests.empty())
+        return;
+
+    // with a single core the jobs only run while the GL thread waits on its own, which it does newest first
+    if (jobSystem().getWorkerCount() == 1) {
+        for (size_t i = 0; i < requests.size(); i++) {
+            if (!requests[i]->claimed.exchange(true)) {
+                decode(requests[i]); // one a frame
+                break;
+            }
+        }
+    }
+
+    size_t uploaded = 0;
+    while (uploaded < uploadBudget) {
+        std::shared_ptr<TextureRequest> request;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (decoded.empty())
+                break;
+            request = decoded.front();
+            decoded.pop_front();
+        }
+        if (request->layer >= 0) {
+            // the array goes up with its last layer, that one takes the others out of the requests
+            TextureArray& array = arrays[request->texture];
+            if (++array.decodedLayers == (int)array.layers.size())
+                uploaded += uploadArray(array);
+            continue;
+        }
+        uploaded += upload(*request);
+        requests.erase(std::find(requests.begin(), requests.end(), request));
+    }
+}
+
+void TextureLoader::finish() {
+    TRACE_SCOPE("finish textures");
+    // the jobs still queued would have to wait for the workers busy with the others, it is quicker to decode them here
+    for (size_t i = 0; i < requests.size(); i++) {
+        if (!requests[i]->claimed.exchange(true))
+            decode(requests[i]);
+    }
+
+    while (!requests.empty()) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            decodedChanged.wait(lock, [this]() { return !decoded.empty(); });
+        }
+        size_t budget = uploadBudget;
+        uploadBudget = (size_t)-1;
+        update();
+        uploadBudget = budget;
+    }
+}
+
+void* TextureLoader::mapUploadBuffer(size_t size) {
+    // orphaning the buffer gives a new one if the driver still reads the last image from it
+    if (uploadBuffer == 0)
+        glGenBuffers(1, &uploadBuffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped == NULL)
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return mapped;
+}
+
+const void* TextureLoader::stage(const void* data, size_t size) {
+    void* mapped = mapUploadBuffer(size);
+    if (mapped == NULL)
+        return data; // straight from memory then
+    memcpy(mapped, data, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    return NULL; // from the start of the buffer
+}
+
+size_t TextureLoader::upload(TextureRequest& request) {
+    if (!request.cooked.levels.empty())
+        return uploadCooked(request);
+    if (request.pixels == NULL) {
+        textureBytes[request.texture] = PLACEHOLDER_BYTES;
+        return 0; // keeps the placeholder
+    }
+
+    TRACE_SCOPE("upload texture");
+    GLenum format = GL_RGB;
+    if (request.channels == 1)
+        format = GL_RED;
+    else if (request.channels == 2)
+        format = GL_RG;
+    else if (request.channels == 4)
+        format = GL_RGBA;
+    size_t size = (size_t)request.width * request.height * request.channels;
+
+    const void* pixels = stage(request.pixels, size);
+
+    // the rows of stb_image's images are packed, RGB rows are not a multiple of 4 bytes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, request.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, request.width, request.height, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    textureBytes[request.texture] = size + size / 3; // the mipmaps are a third more
+
+    stbi_image_free(request.pixels);
+    request.pixels = NULL;
+    return size;
+}
+
+size_t TextureLoader::uploadCooked(TextureRequest& request) {
+    TRACE_SCOPE("upload texture");
+    const CookedTexture& cooked = request.cooked;
+    GLenum format = cooked.header.format == COOKED_RGB8 ? GL_RGB : GL_RGBA;
+    GLenum compressedFormat = cooked.header.format == COOKED_BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+    // every level goes in the pixel buffer at once, each one is then read from its offset
+    size_t size = cooked.getDataSize();
+    const void* data = stage(cooked.getData(), size);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, request.texture);
+    for (int i = 0; i < cooked.header.levels; i++) {
+        const CookedLevel& level = cooked.levels[i];
+        const void* levelData = (const void*)((uintptr_t)data + level.offset);
+        if (cooked.isCompressed())
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, compressedFormat, level.width, level.height, 0, level.size, levelData);
+        else
+            glTexImage2D(GL_TEXTURE_2D, i, format, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, levelData);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, cooked.header.levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    textureBytes[request.texture] = size;
+
+    request.cooked = CookedTexture();
+    return size;
+}
+
+size_t TextureLoader::uploadArray(TextureArray& array) {
+    TRACE_SCOPE("upload texture array");
+    size_t layerSize = (size_t)array.width * array.height * 4;
+    size_t size = layerSize * array.layers.size();
+
+    // the layers one after the other in the pixel buffer, or in memory when it cannot be mapped
+    std::vector<unsigned char> memory;
+    unsigned char* destination = (unsigned char*)mapUploadBuffer(size);
+    if (destination == NULL) {
+        memory.resize(size);
+        destination = memory.data();
+    }
+    for (size_t i = 0; i < array.layers.size(); i++) {
+        std::vector<unsigned char>& pixels = array.layers[i]->layerPixels;
+        if (pixels.empty())
+            memset(destination + i * layerSize, 255, layerSize); // could not be read, white like the placeholder
+        else
+            memcpy(destination + i * layerSize, pixels.data(), layerSize);
+        std::vector<unsigned char>().swap(pixels);
+        requests.erase(std::find(requests.begin(), requests.end(), array.layers[i]));
+    }
+    const void* data = memory.empty() ? NULL : memory.data();
+    if (data == NULL)
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, array.width, array.height, (GLsizei)array.layers.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    array.layers.clear();
+    array.uploaded = true;
+    textureBytes[array.texture] = size + size / 3;
+    return size;
+}
+
+void TextureLoader::unload(GLuint texture) {
+    // a texture still loading would be filled after it is gone (or once its name is given out again)
+    if (textureBytes.erase(texture) == 0) {
+        std::cerr << "Error::Texture " << texture << " cannot be unloaded before it is uploaded." << std::endl;
+        return;
+    }
+    arrays.erase(texture);
+    glDeleteTextures(1, &texture);
+}
+
+size_t TextureLoader::getTextureBytes(GLuint texture) const {
+    std::unordered_map<GLuint, size_t>::const_iterator bytes = textureBytes.find(texture);
+    return bytes == textureBytes.end() ? 0 : bytes->second;
+}
+
+void TextureLoader::destroy() {
+    // images still waiting are dropped, their textures go with the context
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < decoded.size(); i++)
+        stbi_image_free(decoded[i]->pixels);
+    decoded.clear();
+    requests.clear();
+    arrays.clear();
+    textureBytes.clear();
+
+    if (uploadBuffer != 0)
+        glDeleteBuffers(1, &uploadBuffer);
+    uploadBuffer = 0;
+}
@@ -0,0 +1,94 @@
+#ifndef TEXTURE_LOADER_CLASS_H
+#define TEXTURE_LOADER_CLASS_H
+
+#include <GL/glew.h>
+#include "TextureCooker.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct TextureRequest {
+	std::string filePath;
+	GLuint texture; // the handle load() gave out
+	std::atomic<bool> claimed; // decoding started, by a job worker or by finish()
+
+	bool compressionSupported; // whether the GL takes BC textures
+
+	// filled by the decode: the cooked texture when there is one, the decoded image otherwise (NULL if it could not be read)
+	CookedTexture cooked;
+	unsigned char* pixels = NULL;
+	int width = 0, height = 0, channels = 0;
+
+	// for a layer of a texture array (texture is the array's), the image as RGBA at the array's size
+	int layer = -1;
+	int layerWidth = 0, layerHeight = 0;
+	std::vector<unsigned char> layerPixels;
+};
+
+struct TextureArray {
+	GLuint texture;
+	int width, height; // of every layer
+	std::vector<std::shared_ptr<TextureRequest> > layers; // until they are uploaded
+	int decodedLayers = 0;
+	bool uploaded = false;
+};
+
+class TextureLoader {
+	/* Loads textures without making the game wait for them. load() hands out a texture right away that holds a 1x1
+	* white placeholder and queues the image's decoding on the job workers' background queue (JobSystem.hpp), so every
+	* image decodes at the same time on its own core without the frame's jobs waiting behind it. update(), once per
+	* frame on the GL thread, uploads the decoded images: the pixels are copied into a pixel buffer object the texture
+	* is then filled from, so the driver does not copy them again before glTexImage2D returns, and the mipmaps are
+	* generated for trilinear filtering.
+	* An image cooked with -cook (TextureCooker.hpp) is read instead, in one go, and its levels are uploaded as they are.
+	* Models can draw with the handle at once, the image simply shows up in it a few frames later.
+	* finish() waits for everything instead, for fixed step runs that have to draw the same frames every time.
+	*
+	* Textures can also be layers of a GL_TEXTURE_2D_ARRAY (createArray, loadLayer): the models drawing with layers of
+	* the same array share one bind and only change a uniform (CommandList.hpp). The layers all have the array's size,
+	* an image of another size is resampled (bilinear) on the worker that decodes it. The array is white until every
+	* one of its layers is decoded, they are then uploaded together in one call and the mipmaps generated once.
+	* A layer is read from a cooked file when it is not compressed, the array itself is RGBA.
+	*/
+public:
+	GLuint load(std::string filePath); // on the GL thread
+	GLuint createArray(int width, int height); // on the GL thread, an array with no layers yet
+	int loadLayer(GLuint array, std::string filePath); // on the GL thread, before the array is uploaded, returns the layer (-1 if it is too late)
+	void update(); // on the GL thread, uploads at most uploadBudget bytes (and at least one image) per call
+	void finish(); // decodes what no worker has started yet on the calling thread, then uploads everything
+	void destroy(); // the pixel buffer, before the context goes
+	void unload(GLuint texture); // on the GL thread, deletes a texture (or array) that has been uploaded
+
+	int getPendingCount() const { return (int)requests.size(); } // loaded and not uploaded yet
+	size_t getTextureBytes(GLuint texture) const; // GPU memory of an uploaded texture with its mipmaps, 0 until it is uploaded
+
+	size_t uploadBudget = 16 * 1024 * 1024;
+
+private:
+	std::vector<std::shared_ptr<TextureRequest> > requests; // the GL thread's, not uploaded yet
+	std::unordered_map<GLuint, TextureArray> arrays; // by texture
+	std::unordered_map<GLuint, size_t> textureBytes; // of the uploaded textures
+	GLuint uploadBuffer = 0;
+
+	// decoded images waiting for the GL thread
+	std::mutex mutex;
+	std::condition_variable decodedChanged;
+	std::deque<std::shared_ptr<TextureRequest> > decoded;
+
+	void queue(const std::shared_ptr<TextureRequest>& request);
+	void decode(const std::shared_ptr<TextureRequest>& request);
+	void decodeLayer(TextureRequest& request);
+	size_t upload(TextureRequest& request); // returns the bytes uploaded
+	size_t uploadCooked(TextureRequest& request);
+	size_t uploadArray(TextureArray& array);
+	void* mapUploadBuffer(size_t size); // the pixel buffer bound and mapped for writing, NULL (with none bound) if it cannot be mapped
+	const void* stage(const void* data, size_t size); // what to give glTexImage2D for data in memory
+};
+
+#endif
@@ -0,0 +1,149 @@
+#include "TextureManager.hpp"
+#include "GLMetrics.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+GLuint TextureManager::acquire(std::string filePath) {
+    ManagedTexture& texture = textures[filePath];
+    if (!describe(texture, filePath, std::vector<std::string>(), 0, 0))
+        return 0;
+    return use(texture);
+}
+
+GLuint TextureManager::acquireArray(std::string name, int width, int height, const std::vector<std::string>& layerPaths) {
+    ManagedTexture& texture = textures[name];
+    if (!describe(texture, name, layerPaths, width, height))
+        return 0;
+    return use(texture);
+}
+
+bool TextureManager::describe(ManagedTexture& texture, std::string name, const std::vector<std::string>& layerPaths, int width, int height) {
+    /* sets what the texture is made of, false when it is resident with other images and cannot be dropped */
+    bool same = texture.layers == layerPaths && texture.arrayWidth == width && texture.arrayHeight == height;
+    if (!same && texture.texture != 0) {
+        if (texture.references > 0 || loader.getTextureBytes(texture.texture) == 0) {
+            std::cerr << "Error::Texture " << name << " is already acquired with other images or another size." << std::endl;
+            return false;
+        }
+        evict(texture); // nothing draws with the old images, the new ones are loaded in their place
+    }
+    texture.name = name;
+    texture.layers = layerPaths;
+    texture.arrayWidth = width;
+    texture.arrayHeight = height;
+    return true;
+}
+
+GLuint TextureManager::use(ManagedTexture& texture) {
+    if (texture.texture == 0)
+        load(texture); // the first time, or it was evicted
+    texture.references++;
+    texture.lastUsed = ++clock;
+    return texture.texture;
+}
+
+void TextureManager::load(ManagedTexture& texture) {
+    if (texture.layers.empty())
+        texture.texture = loader.load(texture.name);
+    else {
+        texture.texture = loader.createArray(texture.arrayWidth, texture.arrayHeight);
+        for (const std::string& layer : texture.layers)
+            loader.loadLayer(texture.texture, layer);
+    }
+    texture.loads++;
+    names[texture.texture] = texture.name;
+}
+
+void TextureManager::release(GLuint texture) {
+    std::unordered_map<GLuint, std::string>::iterator name = names.find(texture);
+    if (name == names.end()) {
+        std::cerr << "Error::Texture " << texture << " was not acquired from the texture manager." << std::endl;
+        return;
+    }
+
+    ManagedTexture& managed = textures[name->second];
+    if (managed.references == 0) {
+        std::cerr << "Error::Texture " << managed.name << " is released more times than it was acquired." << std::endl;
+        return;
+    }
+    managed.references--;
+    managed.lastUsed = ++clock; // the last to stop being drawn is the last to go
+}
+
+void TextureManager::update() {
+    // a handful of textures, looking through all of them for the oldest is enough
+    size_t resident = getResidentBytes();
+    while (resident > budget) {
+        ManagedTexture* oldest = NULL;
+        for (std::unordered_map<std::string, ManagedTexture>::iterator entry = textures.begin(); entry != textures.end(); ++entry) {
+            ManagedTexture& texture = entry->second;
+            // one still loading has nothing to free yet
+            if (texture.texture == 0 || texture.references > 0 || loader.getTextureBytes(texture.texture) == 0)
+                continue;
+            if (oldest == NULL || texture.lastUsed < oldest->lastUsed)
+                oldest = &texture;
+        }
+        if (oldest == NULL)
+            break; // what is left is drawn with
+
+        resident -= loader.getTextureBytes(oldest->texture);
+        evict(*oldest);
+    }
+}
+
+void TextureManager::evict(ManagedTexture& texture) {
+    names.erase(texture.texture);
+    loader.unload(texture.texture);
+    texture.texture = 0;
+    texture.evictions++;
+}
+
+void TextureManager::destroy() {
+    for (std::unordered_map<GLuint, std::string>::iterator name = names.begin(); name != names.end(); ++name) {
+        GLuint texture = name->first;
+        glDeleteTextures(1, &texture);
+    }
+    names.clear();
+    textures.clear();
+}
+
+size_t TextureManager::getResidentBytes() const {
+    size_t bytes = 0;
+    for (std::unordered_map<GLuint, std::string>::const_iterator name = names.begin(); name != names.end(); ++name)
+        bytes += loader.getTextureBytes(name->first);
+    return bytes;
+}
+
+int TextureManager::getResidentCount() const {
+    return (int)names.size();
+}
+
+std::vector<TextureStats> TextureManager::getStats() const {
+    std::vector<TextureStats> stats;
+    for (std::unordered_map<std::string, ManagedTexture>::const_iterator entry = textures.begin(); entry != textures.end(); ++entry) {
+        const ManagedTexture& texture = entry->second;
+        TextureStats stat = { texture.name, texture.texture == 0 ? 0 : loader.getTextureBytes(texture.texture), texture.references,
+            texture.loads, texture.evictions, texture.texture != 0 };
+        stats.push_back(stat);
+    }
+    std::sort(stats.begin(), stats.end(), [](const TextureStats& a, const TextureStats& b) { return a.name < b.name; });
+    return stats;
+}
+
+std::string TextureManager::getReport() const {
+    char line[160];
+    snprintf(line, sizeof(line), "textures: %d resident %.1f / %.1f mb\n", getResidentCount(), getResidentBytes() / (1024.0 * 1024.0),
+        budget / (1024.0 * 1024.0));
+    std::string report = line;
+
+    for (const TextureStats& stat : getStats()) {
+        std::string name = stat.name.substr(stat.name.find_last_of('/') + 1); // the file name is enough on screen
+        if (stat.resident)
+            snprintf(line, sizeof(line), "  %s: %zu kb %d refs %d loads\n", name.c_str(), stat.bytes / 1024, stat.references, stat.loads);
+        else
+            snprintf(line, sizeof(line), "  %s: evicted %d times\n", name.c_str(), stat.evictions);
+        report += line;
+    }
+    return report;
+}
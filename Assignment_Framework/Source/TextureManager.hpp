@@ -0,0 +1,74 @@
+#ifndef TEXTURE_MANAGER_CLASS_H
+#define TEXTURE_MANAGER_CLASS_H
+
+#include <GL/glew.h>
+#include "TextureLoader.hpp"
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ManagedTexture {
+	std::string name; // the image's path, or the name the array was acquired with
+	std::vector<std::string> layers; // the images of an array's layers, empty for a 2D texture
+	int arrayWidth = 0, arrayHeight = 0;
+
+	GLuint texture = 0; // 0 once evicted
+	int references = 0;
+	unsigned long long lastUsed = 0; // the manager's clock when it was last acquired or released
+	int loads = 0; // the first load and every reload after an eviction
+	int evictions = 0;
+};
+
+struct TextureStats {
+	std::string name;
+	size_t bytes; // GPU memory with the mipmaps, 0 when evicted or not uploaded yet
+	int references;
+	int loads;
+	int evictions;
+	bool resident;
+};
+
+class TextureManager {
+	/* Keeps the textures the game draws with inside a memory budget. A texture is acquired by its path (or an array by
+	* a name and the paths of its layers) and released when nothing draws with it anymore: acquiring it again gives the
+	* same texture as long as it is resident, so the models that share an image share its texture.
+	* A released texture stays loaded in case it is wanted again, until the resident textures take more than budget
+	* bytes: update() then evicts the released ones, least recently used first, until they fit (or only referenced
+	* ones are left, those are never evicted). Acquiring an evicted texture loads it again through the TextureLoader,
+	* so it has the placeholder for a few frames like the first time. Its name changes, a texture must not be used
+	* after it is released.
+	* A name is made of the same images every time: acquiring it with other ones while it is referenced (or still
+	* loading) fails and gives 0, otherwise the old texture is dropped and the new images are loaded in its place.
+	* Every call is on the GL thread.
+	*/
+public:
+	TextureManager(TextureLoader& pLoader) : loader(pLoader) {}
+
+	GLuint acquire(std::string filePath);
+	GLuint acquireArray(std::string name, int width, int height, const std::vector<std::string>& layerPaths); // layer i is layerPaths[i]
+	void release(GLuint texture);
+
+	void update(); // once a frame after TextureLoader::update, evicts what goes over the budget
+	void destroy(); // deletes every texture, before the context goes
+
+	size_t getResidentBytes() const;
+	int getResidentCount() const;
+	std::vector<TextureStats> getStats() const; // every texture acquired so far, by name
+	std::string getReport() const; // the totals then a line per texture, for the profiler overlay
+
+	size_t budget = 256 * 1024 * 1024;
+
+private:
+	TextureLoader& loader;
+	std::unordered_map<std::string, ManagedTexture> textures; // by name
+	std::unordered_map<GLuint, std::string> names; // of the resident textures
+	unsigned long long clock = 0;
+
+	bool describe(ManagedTexture& texture, std::string name, const std::vector<std::string>& layerPaths, int width, int height);
+	GLuint use(ManagedTexture& texture); // one more reference, loads it when it is not resident
+	void load(ManagedTexture& texture);
+	void evict(ManagedTexture& texture);
+};
+
+#endif
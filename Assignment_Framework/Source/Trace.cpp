@@ -0,0 +1,151 @@
+#include "Trace.hpp"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <vector>
+
+struct TraceEvent {
+    const char* name;
+    char phase; // Chrome trace phase: B(egin), E(nd), i(nstant) or C(ounter)
+    long long timestamp; // microseconds since the program started
+    double value; // counters only
+};
+
+const unsigned int TRACE_RING_SIZE = 1 << 16; // events a thread can record between two flushes
+
+struct TraceRing {
+    // single producer (the owning thread), single consumer (traceFlush, under registryMutex)
+    TraceEvent events[TRACE_RING_SIZE];
+    std::atomic<unsigned int> head; // next slot the owner writes
+    std::atomic<unsigned int> tail; // next slot the flush reads
+    std::atomic<unsigned int> dropped; // events lost because the ring was full
+    int threadIndex;
+    std::string threadName;
+};
+
+struct CollectedEvent {
+    int threadIndex;
+    TraceEvent event;
+};
+
+std::atomic<bool> tracingEnabled(false);
+
+static std::mutex registryMutex;
+static std::vector<TraceRing*> rings; // never freed, a thread can exit before its events are written
+static std::vector<CollectedEvent> collected;
+static std::set<std::string> internedNames;
+static thread_local TraceRing* localRing = NULL;
+
+static const std::chrono::steady_clock::time_point traceStart = std::chrono::steady_clock::now();
+
+static TraceRing* getLocalRing() {
+    // first event of a thread, the only time recording takes the lock
+    if (localRing == NULL) {
+        TraceRing* ring = new TraceRing();
+        ring->head = 0;
+        ring->tail = 0;
+        ring->dropped = 0;
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        ring->threadIndex = (int)rings.size();
+        ring->threadName = "thread " + std::to_string(ring->threadIndex);
+        rings.push_back(ring);
+        localRing = ring;
+    }
+    return localRing;
+}
+
+void setTracing(bool enabled) {
+    tracingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void traceRecord(const char* name, char phase, double value) {
+    TraceRing* ring = getLocalRing();
+
+    unsigned int head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= TRACE_RING_SIZE) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TraceEvent& event = ring->events[head % TRACE_RING_SIZE];
+    event.name = name;
+    event.phase = phase;
+    event.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - traceStart).count();
+    event.value = value;
+    ring->head.store(head + 1, std::memory_order_release); // publishes the event to the flush
+}
+
+const char* traceIntern(std::string name) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return internedNames.insert(name).first->c_str(); // set nodes never move
+}
+
+void traceSetThreadName(std::string name) {
+    TraceRing* ring = getLocalRing();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    ring->threadName = name;
+}
+
+void traceFlush() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (TraceRing* ring : rings) {
+        unsigned int tail = ring->tail.load(std::memory_order_relaxed);
+        unsigned int head = ring->head.load(std::memory_order_acquire);
+        for (; tail != head; tail++) {
+            CollectedEvent collectedEvent = { ring->threadIndex, ring->events[tail % TRACE_RING_SIZE] };
+            collected.push_back(collectedEvent);
+        }
+        ring->tail.store(tail, std::memory_order_release); // hands the slots back to the owner
+    }
+}
+
+static std::string escapeJSON(const char* text) {
+    std::string escaped;
+    for (; *text; text++) {
+        if (*text == '"' || *text == '\\')
+            escaped += '\\';
+        escaped += *text;
+    }
+    return escaped;
+}
+
+bool traceWrite(std::string filePath) {
+    traceFlush();
+
+    std::ofstream file(filePath, std::ios::out);
+    if (!file.is_open()) {
+        std::cerr << "Could not create file " << filePath << "." << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    for (TraceRing* ring : rings) {
+        file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->threadIndex
+            << ",\"args\":{\"name\":\"" << escapeJSON(ring->threadName.c_str()) << "\"}}";
+        first = false;
+
+        if (ring->dropped.load(std::memory_order_relaxed) > 0)
+            std::cerr << ring->threadName << " dropped " << ring->dropped.load(std::memory_order_relaxed) << " trace events, flush more often." << std::endl;
+    }
+
+    for (const CollectedEvent& collectedEvent : collected) {
+        const TraceEvent& event = collectedEvent.event;
+        file << (first ? "" : ",\n") << "{\"name\":\"" << escapeJSON(event.name) << "\",\"ph\":\"" << event.phase << "\",\"ts\":" << event.timestamp
+            << ",\"pid\":1,\"tid\":" << collectedEvent.threadIndex;
+        if (event.phase == 'i')
+            file << ",\"s\":\"t\"";
+        else if (event.phase == 'C')
+            file << ",\"args\":{\"value\":" << event.value << "}";
+        file << "}";
+        first = false;
+    }
+
+    file << "\n]}\n";
+    return true;
+}
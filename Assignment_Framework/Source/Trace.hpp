@@ -0,0 +1,64 @@
+#ifndef TRACE_HEADER
+#define TRACE_HEADER
+
+#include <atomic>
+#include <string>
+
+/* Timeline of what every thread does, written as Chrome trace JSON (open it in about:tracing or ui.perfetto.dev).
+* Each thread records into its own fixed size ring that only it writes to, so recording never takes a lock, and
+* traceFlush() (once per frame) moves what was recorded out of the rings. While tracing is off every call is one
+* relaxed atomic load.
+* Event names are kept as pointers: pass string literals, or traceIntern() for names built at run time.
+*/
+
+extern std::atomic<bool> tracingEnabled;
+
+inline bool isTracing() { return tracingEnabled.load(std::memory_order_relaxed); }
+
+void setTracing(bool enabled);
+
+void traceRecord(const char* name, char phase, double value);
+
+inline void traceBegin(const char* name) {
+	if (isTracing())
+		traceRecord(name, 'B', 0.0);
+}
+
+inline void traceEnd(const char* name) {
+	if (isTracing())
+		traceRecord(name, 'E', 0.0);
+}
+
+inline void traceInstant(const char* name) {
+	if (isTracing())
+		traceRecord(name, 'i', 0.0);
+}
+
+inline void traceCounter(const char* name, double value) {
+	if (isTracing())
+		traceRecord(name, 'C', value);
+}
+
+const char* traceIntern(std::string name); // copy of name that lives until the program ends
+
+void traceSetThreadName(std::string name); // label of the calling thread in the viewer
+
+void traceFlush(); // moves the events out of every thread's ring, call it often enough that the rings do not fill up
+
+bool traceWrite(std::string filePath); // flushes and writes everything recorded so far
+
+class TraceScope {
+	/* begin event now, end event when the scope is left */
+public:
+	TraceScope(const char* pName) : name(pName) { traceBegin(name); }
+	~TraceScope() { traceEnd(name); }
+
+private:
+	const char* name;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef VOXEL_GRID_HEADER
+#define VOXEL_GRID_HEADER
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "AssetPack.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+
+inline int lowestSetBit(uint64_t word) {
+	/* index of the lowest set bit of a non zero word (de Bruijn multiplication, works without 64 bit intrinsics on Win32) */
+	static const int table[64] = {
+		0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+		62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+		63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+		46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6
+	};
+	return table[((word & (~word + 1)) * 0x03F79D71B4CB0A89ULL) >> 58];
+}
+
+class Bitmask2D {
+	/* width x height grid of bits centered on the origin, the way the wall is laid out by buildWallMask
+	* cells are addressed with the same integer x-y coordinates the shape and wall .csv files use
+	*/
+public:
+	Bitmask2D() : width(0), height(0) {}
+
+	Bitmask2D(int pWidth, int pHeight) : width(pWidth), height(pHeight), words((pWidth * pHeight + 63) / 64, 0) {}
+
+	bool inBounds(int x, int y) const {
+		return x + width / 2 >= 0 && x + width / 2 < width && y + height / 2 >= 0 && y + height / 2 < height;
+	}
+
+	void set(int x, int y) {
+		int i = index(x, y);
+		words[i / 64] |= (uint64_t)1 << (i % 64);
+	}
+
+	void clear(int x, int y) {
+		int i = index(x, y);
+		words[i / 64] &= ~((uint64_t)1 << (i % 64));
+	}
+
+	bool test(int x, int y) const {
+		int i = index(x, y);
+		return (words[i / 64] >> (i % 64)) & 1;
+	}
+
+	void fill() {
+		for (int i = 0; i < width * height; i++)
+			words[i / 64] |= (uint64_t)1 << (i % 64);
+	}
+
+	void subtract(const Bitmask2D& other) {
+		for (size_t i = 0; i < words.size() && i < other.words.size(); i++)
+			words[i] &= ~other.words[i];
+	}
+
+	bool intersects(const Bitmask2D& other) const {
+		// one AND per 64 cells, the whole 9x9 wall is two words
+		for (size_t i = 0; i < words.size() && i < other.words.size(); i++) {
+			if (words[i] & other.words[i])
+				return true;
+		}
+		return false;
+	}
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+
+private:
+	int width, height;
+	std::vector<uint64_t> words;
+
+	int index(int x, int y) const { return (y + height / 2) * width + (x + width / 2); }
+};
+
+class VoxelSet {
+	/* size x size x size grid of unit cubes centered on the origin, holds the cubes a shape is made of
+	*/
+public:
+	VoxelSet() : size(0) {}
+
+	VoxelSet(int pSize) : size(pSize), words((pSize * pSize * pSize + 63) / 64, 0) {}
+
+	static VoxelSet fromCSV(std::string shapeFilePath, int pSize) {
+		/* reads the cube positions of a shape .csv, only the local x, y and z coordinates of each line are used
+		* so the same restrictions as buildWallMask apply (1x1 cubes on integer positions)
+		*/
+		VoxelSet voxels(pSize);
+
+		AssetStream shapeStream(assets().open(shapeFilePath));
+		if (!shapeStream.isOpen()) {
+			std::cerr << "Could not read file " << shapeFilePath << ". File does not exist." << std::endl;
+			return voxels;
+		}
+
+		std::string line;
+		float x, y, z;
+		while (getline(shapeStream, line)) {
+			if (sscanf(line.c_str(), " %f , %f , %f", &x, &y, &z) != 3) // skips the comment lines
+				continue;
+
+			glm::ivec3 cell((int)x, (int)y, (int)z);
+			if (voxels.inBounds(cell))
+				voxels.set(cell);
+			else
+				std::cerr << "Cube " << x << ", " << y << ", " << z << " of " << shapeFilePath << " does not fit in the voxel grid." << std::endl;
+		}
+
+		return voxels;
+	}
+
+	bool inBounds(glm::ivec3 cell) const {
+		int half = size / 2;
+		return cell.x >= -half && cell.x <= half && cell.y >= -half && cell.y <= half && cell.z >= -half && cell.z <= half;
+	}
+
+	void set(glm::ivec3 cell) {
+		int i = index(cell);
+		words[i / 64] |= (uint64_t)1 << (i % 64);
+	}
+
+	bool test(glm::ivec3 cell) const {
+		int i = index(cell);
+		return (words[i / 64] >> (i % 64)) & 1;
+	}
+
+	template <typename Function>
+	void forEach(Function function) const {
+		// visits every filled cell by scanning the set bits of each word
+		for (size_t w = 0; w < words.size(); w++) {
+			uint64_t word = words[w];
+			while (word) {
+				int i = (int)w * 64 + lowestSetBit(word);
+				word &= word - 1;
+				function(cell(i));
+			}
+		}
+	}
+
+	VoxelSet rotated(const int rotation[3][3]) const {
+		/* rotates the cubes about the origin
+		*	rotation - signed permutation matrix (rows), i.e. a multiple of 90 degrees about each axis
+		*/
+		VoxelSet result(size);
+		forEach([&](glm::ivec3 c) {
+			glm::ivec3 r(
+				rotation[0][0] * c.x + rotation[0][1] * c.y + rotation[0][2] * c.z,
+				rotation[1][0] * c.x + rotation[1][1] * c.y + rotation[1][2] * c.z,
+				rotation[2][0] * c.x + rotation[2][1] * c.y + rotation[2][2] * c.z);
+			result.set(r); // the grid is a cube centered on the origin so rotated cells are always in bounds
+		});
+		return result;
+	}
+
+	Bitmask2D project(int width, int height, bool& clipped) const {
+		/* silhouette of the shape as seen down the z axis, i.e. what it punches through the wall
+		*	clipped - set when a cube lands outside of the width x height mask
+		*/
+		Bitmask2D silhouette(width, height);
+		clipped = false;
+		forEach([&](glm::ivec3 c) {
+			if (silhouette.inBounds(c.x, c.y))
+				silhouette.set(c.x, c.y);
+			else
+				clipped = true;
+		});
+		return silhouette;
+	}
+
+	int getSize() const { return size; }
+
+private:
+	int size;
+	std::vector<uint64_t> words;
+
+	int index(glm::ivec3 c) const {
+		int half = size / 2;
+		return ((c.z + half) * size + (c.y + half)) * size + (c.x + half);
+	}
+
+	glm::ivec3 cell(int i) const {
+		int half = size / 2;
+		return glm::ivec3(i % size - half, (i / size) % size - half, i / (size * size) - half);
+	}
+};
+
+inline bool snapToVoxelRotation(glm::quat rotation, int out[3][3]) {
+	/* converts a quaternion that is a multiple of 90 degrees about each axis into its integer rotation matrix
+	* returns false when the quaternion is not axis aligned (e.g. the shape is caught in the middle of a rotation)
+	*/
+	glm::mat3 m = glm::mat3_cast(rotation);
+	const float tolerance = 0.01f;
+
+	for (int row = 0; row < 3; row++) {
+		for (int col = 0; col < 3; col++) {
+			float value = m[col][row]; // glm matrices are column major
+			int rounded = value > 0.5f ? 1 : (value < -0.5f ? -1 : 0);
+			if (glm::abs(value - rounded) > tolerance)
+				return false;
+			out[row][col] = rounded;
+		}
+	}
+	return true;
+}
+
+inline bool fitsThroughWall(const VoxelSet& shape, const Bitmask2D& wall) {
+	/* exact occupancy test: the shape passes when its silhouette does not overlap any cube of the wall
+	*	shape - voxels of the shape already turned into the orientation to test
+	*	wall - filled cells of the wall, as built by buildWallMask
+	*/
+	bool clipped;
+	Bitmask2D silhouette = shape.project(wall.getWidth(), wall.getHeight(), clipped);
+	return !clipped && !silhouette.intersects(wall); // cubes sticking out past the wall would hit the frame, count them as a crash
+}
+
+#endif